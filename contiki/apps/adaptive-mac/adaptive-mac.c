@@ -46,6 +46,9 @@
 #include "net/rime.h"
 #include "net/rime/relcollect.h"
 #include "net/rime/neighbor.h"
+#if SERIAL_BINARY
+#include "serial_frame.h"
+#endif /* SERIAL_BINARY */
 #if GLOSSY
 #include "glossy_interface.h"
 extern unsigned long glossy_arrival_time;
@@ -96,6 +99,11 @@ struct message {
   uint32_t energest_glossy_transmit;
   uint32_t energest_glossy_cpu;
 #endif /* GLOSSY */
+#if GLOSSY_PIGGYBACK_REPORTS
+  glossy_report_struct report;
+#elif GLOSSY_DYNAMIC_SCHEDULE
+  uint8_t report_pending;
+#endif /* GLOSSY_PIGGYBACK_REPORTS */
 };
 
 /* Representation of ADAPTMAC print message */
@@ -233,6 +241,11 @@ recv_relcollect(const rimeaddr_t *originator)
   print_msg.time_to_rx = msg.time_to_rx;
   print_msg.period_skew = msg.period_skew;
 #endif /* GLOSSY */
+#if GLOSSY_PIGGYBACK_REPORTS
+  glossy_data_report(&msg.report);
+#elif GLOSSY_DYNAMIC_SCHEDULE
+  glossy_request_report(originator->u8[0], msg.report_pending);
+#endif /* GLOSSY_PIGGYBACK_REPORTS */
   /* Poll the print process */
   process_poll(&print_process);
 }
@@ -305,6 +318,11 @@ PROCESS_THREAD(app_process, ev, data)
     msg.energest_glossy_transmit = energest_glossy_type_time(ENERGEST_TYPE_TRANSMIT);
     msg.energest_glossy_cpu = energest_glossy_type_time(ENERGEST_TYPE_CPU);
 #endif /* GLOSSY */
+#if GLOSSY_PIGGYBACK_REPORTS
+    glossy_fill_report(&msg.report);
+#elif GLOSSY_DYNAMIC_SCHEDULE
+    msg.report_pending = glossy_report_changed();
+#endif /* GLOSSY_PIGGYBACK_REPORTS */
 
     packetbuf_clear();
     packetbuf_copyfrom(&msg, sizeof (struct message));
@@ -323,6 +341,46 @@ PROCESS_THREAD(print_process, ev, data)
     PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
 
     /* Print ADAPTMAC message */
+#if SERIAL_BINARY
+    /* Fixed layout, fields that are not compiled in are sent as zero */
+    serial_frame_begin(SERIAL_FRAME_PACKET);
+    serial_frame_put_u8(print_msg.rx);
+    serial_frame_put_u16(print_msg.seq_no);
+#if QUEUING_STATS
+    serial_frame_put_u16(print_msg.queuing_delay);
+    serial_frame_put_u16(print_msg.dropped_packets_count);
+    serial_frame_put_u8(print_msg.queue_size);
+#else
+    serial_frame_put_u16(0);
+    serial_frame_put_u16(0);
+    serial_frame_put_u8(0);
+#endif /* QUEUING_STATS */
+    serial_frame_put_u32(print_msg.t_tx);
+    serial_frame_put_u32(print_msg.t_rx);
+    serial_frame_put_u32(print_msg.t_lpm);
+    serial_frame_put_u32(print_msg.t_cpu);
+#if WITH_FTSP || GLOSSY
+    serial_frame_put_u32(print_msg.latency);
+#else
+    serial_frame_put_u32(0);
+#endif /* WITH_FTSP || GLOSSY */
+#if GLOSSY
+    serial_frame_put_u8(print_msg.rx_cnt);
+    serial_frame_put_u16(print_msg.time_to_rx);
+    serial_frame_put_u16(print_msg.period_skew);
+    serial_frame_put_u32(print_msg.t_glossy_tx);
+    serial_frame_put_u32(print_msg.t_glossy_rx);
+    serial_frame_put_u32(print_msg.t_glossy_cpu);
+#else
+    serial_frame_put_u8(0);
+    serial_frame_put_u16(0);
+    serial_frame_put_u16(0);
+    serial_frame_put_u32(0);
+    serial_frame_put_u32(0);
+    serial_frame_put_u32(0);
+#endif /* GLOSSY */
+    serial_frame_end();
+#else /* SERIAL_BINARY */
 #if (WITH_FTSP || GLOSSY) && QUEUING_STATS
     printf("A o=%u seq=%u qd=%u dp=%u qs=%u tx=%lu rx=%lu lpm=%lu cpu=%lu lat=%lu rxc=%u t2rx=%u psk=%d gtx=%lu grx=%lu gcpu=%lu\n",
 #elif (WITH_FTSP || GLOSSY) && !QUEUING_STATS
@@ -354,6 +412,7 @@ PROCESS_THREAD(print_process, ev, data)
 #else
     print_msg.t_cpu);
 #endif /* WITH_FTSP */
+#endif /* SERIAL_BINARY */
   }
   PROCESS_END();
 }
@@ -406,7 +465,46 @@ PROCESS_THREAD(change_data_rate_process, ev, data) {
 }
 #endif /* CHANGE_DATA_RATE */
 /*---------------------------------------------------------------------------*/
+/* Set if a configuration update is malformed, e.g., because the line
+   was cut at SERIAL_LINE_CONF_BUFSIZE. */
+static uint8_t parse_error;
+/* Parses the next number of a configuration update and skips the
+   comma that follows it. */
+static unsigned long
+parse_number(char **s)
+{
+  char *start = *s;
+  unsigned long value = strtoul(*s, s, 10);
+  if (*s == start || **s != ',') {
+    parse_error = 1;
+  } else {
+    (*s)++;
+  }
+  return value;
+}
+/*---------------------------------------------------------------------------*/
+/* Parses the next time of a configuration update, given in units of
+   1/SCALE seconds, and rounds it to rtimer ticks. */
+static rtimer_clock_t
+parse_time(char **s)
+{
+  unsigned long t = (unsigned long)RTIMER_SECOND * 10 * parse_number(s) / SCALE;
+  if (t % 10 > 4) {
+    return (rtimer_clock_t)(t / 10 + 1);
+  }
+  return (rtimer_clock_t)(t / 10);
+}
+/*---------------------------------------------------------------------------*/
 PROCESS_THREAD(dissemination_process, ev, data) {
+  static char *s;
+  static struct config cfg;
+#if GLOSSY && GLOSSY_MAC_CLASSES > 1
+  static struct config new_classes[GLOSSY_MAC_CLASSES - 1];
+  static uint8_t new_class_len[GLOSSY_MAC_CLASSES - 1];
+  static uint8_t new_members[GLOSSY_MAC_CLASS_MEMBERS];
+  static uint8_t i, m;
+  unsigned long k, id;
+#endif /* GLOSSY && GLOSSY_MAC_CLASSES > 1 */
 
 #if TRICKLE_ON
   PROCESS_EXITHANDLER(trickle_close(&trickle);)
@@ -432,40 +530,44 @@ PROCESS_THREAD(dissemination_process, ev, data) {
     		rimeaddr_node_addr.u8[0], rimeaddr_node_addr.u8[1]);
 
     /* Parse the configuration update. We assume the data is
-       formatted like this: t_l,t_s,n, (Note the FINAL comma!!!) */
-    char * s1 = (char *)data;
-    char * s2 = (char *)data;
-    uint8_t count;
-    uint8_t commas_found = 0;
-    unsigned long t_l_tmp = 0;
-    unsigned long t_s_tmp = 0;
-    while (commas_found < 3) {
-      char buf[10] = "";
-      count = 0;
-      while (*s2 != ',') {
-	s2++;
-	count++;
+       formatted like this: t_l,t_s,n, (Note the FINAL comma!!!)
+       With MAC classes, each further class follows as
+       t_l,t_s,n,k,id_1,...,id_k, listing the k nodes of the class.
+       Every number must be followed by a comma, otherwise the whole
+       update is dropped. */
+    s = (char *)data;
+    parse_error = 0;
+    cfg.t_l = parse_time(&s);
+    cfg.t_s = parse_time(&s);
+    cfg.n = (uint8_t) parse_number(&s);
+#if GLOSSY && GLOSSY_MAC_CLASSES > 1
+    for (i = 0, m = 0; i < GLOSSY_MAC_CLASSES - 1; i++) {
+      new_class_len[i] = 0;
+      if (*s == '\0') {
+	/* Class not in use. */
+	new_classes[i] = cfg;
+	continue;
       }
-      commas_found++;
-      strncpy(buf,s1,count);
-      if (commas_found == 1) {
-    t_l_tmp = (unsigned long)RTIMER_SECOND * 10 * atoi(buf) / SCALE;
-      } else if (commas_found == 2) {
-    t_s_tmp = (unsigned long)RTIMER_SECOND * 10 * atoi(buf) / SCALE;
-      } else if (commas_found == 3) {
-	new_cfg.n = (uint8_t) atoi(buf);
+      new_classes[i].t_l = parse_time(&s);
+      new_classes[i].t_s = parse_time(&s);
+      new_classes[i].n = (uint8_t) parse_number(&s);
+      for (k = parse_number(&s); k > 0 && !parse_error; k--) {
+	id = parse_number(&s);
+	if (m < GLOSSY_MAC_CLASS_MEMBERS) {
+	  new_members[m++] = (uint8_t) id;
+	  new_class_len[i]++;
+	}
       }
-      s2++;
-      s1 = s2;
     }
-    new_cfg.t_l = (rtimer_clock_t)(t_l_tmp / 10);
-    new_cfg.t_s = (rtimer_clock_t)(t_s_tmp / 10);
-    if (t_l_tmp % 10 > 4) {
-    	new_cfg.t_l++;
-    }
-    if (t_s_tmp % 10 > 4) {
-    	new_cfg.t_s++;
+#endif /* GLOSSY && GLOSSY_MAC_CLASSES > 1 */
+    if (parse_error) {
+      PRINTF("%u.%u: dropped malformed configuration\n",
+	     rimeaddr_node_addr.u8[0], rimeaddr_node_addr.u8[1]);
+      continue;
     }
+    new_cfg.t_l = cfg.t_l;
+    new_cfg.t_s = cfg.t_s;
+    new_cfg.n = cfg.n;
     PRINTF("%u.%u: got new configuration over UART (t_l = %u t_s = %u n = %u)\n",
 	   rimeaddr_node_addr.u8[0], rimeaddr_node_addr.u8[1],
 	   new_cfg.t_l, new_cfg.t_s, new_cfg.n);
@@ -485,12 +587,23 @@ PROCESS_THREAD(dissemination_process, ev, data) {
     glossy_config_data.t_l = new_cfg.t_l;
     glossy_config_data.t_s = new_cfg.t_s;
     glossy_config_data.n = new_cfg.n;
+#if GLOSSY_MAC_CLASSES > 1
+    memcpy(glossy_config_data.classes, new_classes, sizeof(new_classes));
+    memcpy(glossy_config_data.class_len, new_class_len, sizeof(new_class_len));
+    memcpy(glossy_config_data.members, new_members, sizeof(new_members));
+#endif /* GLOSSY_MAC_CLASSES > 1 */
 #endif
   }
   
   PROCESS_END();
 }
 /*---------------------------------------------------------------------------*/
+#if GLOSSY && GLOSSY_MAC_CLASSES > 1
+/* Strobe for as long as the parent sleeps. */
+#define STROBE_CFG new_parent_cfg
+#else
+#define STROBE_CFG new_cfg
+#endif /* GLOSSY && GLOSSY_MAC_CLASSES > 1 */
 PROCESS_THREAD(adaptation_process, ev, data) {
 
 	PROCESS_BEGIN();
@@ -539,7 +652,7 @@ PROCESS_THREAD(adaptation_process, ev, data) {
 #if MAC_PROTOCOL == XMAC
 		new_xmac_config.on_time = (rtimer_clock_t) new_cfg.t_l;
 		new_xmac_config.off_time = (rtimer_clock_t) new_cfg.t_s;
-		new_xmac_config.strobe_time = (rtimer_clock_t) (2*new_cfg.t_l + new_cfg.t_s);
+		new_xmac_config.strobe_time = (rtimer_clock_t) (2*STROBE_CFG.t_l + STROBE_CFG.t_s);
 		new_xmac_config.strobe_wait_time = get_xmac_config()->strobe_wait_time;
 		set_xmac_config(&new_xmac_config);
 		current_cfg.t_l = new_cfg.t_l;
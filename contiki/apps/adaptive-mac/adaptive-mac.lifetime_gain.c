@@ -96,6 +96,11 @@ struct message {
   uint32_t energest_glossy_transmit;
   uint32_t energest_glossy_cpu;
 #endif /* GLOSSY */
+#if GLOSSY_PIGGYBACK_REPORTS
+  glossy_report_struct report;
+#elif GLOSSY_DYNAMIC_SCHEDULE
+  uint8_t report_pending;
+#endif /* GLOSSY_PIGGYBACK_REPORTS */
 };
 
 /* Representation of ADAPTMAC print message */
@@ -233,6 +238,11 @@ recv_relcollect(const rimeaddr_t *originator)
   print_msg.time_to_rx = msg.time_to_rx;
   print_msg.period_skew = msg.period_skew;
 #endif /* GLOSSY */
+#if GLOSSY_PIGGYBACK_REPORTS
+  glossy_data_report(&msg.report);
+#elif GLOSSY_DYNAMIC_SCHEDULE
+  glossy_request_report(originator->u8[0], msg.report_pending);
+#endif /* GLOSSY_PIGGYBACK_REPORTS */
   /* Poll the print process */
   process_poll(&print_process);
 }
@@ -320,6 +330,11 @@ PROCESS_THREAD(app_process, ev, data)
     msg.energest_glossy_transmit = energest_glossy_type_time(ENERGEST_TYPE_TRANSMIT);
     msg.energest_glossy_cpu = energest_glossy_type_time(ENERGEST_TYPE_CPU);
 #endif /* GLOSSY */
+#if GLOSSY_PIGGYBACK_REPORTS
+    glossy_fill_report(&msg.report);
+#elif GLOSSY_DYNAMIC_SCHEDULE
+    msg.report_pending = glossy_report_changed();
+#endif /* GLOSSY_PIGGYBACK_REPORTS */
 
     packetbuf_clear();
     packetbuf_copyfrom(&msg, sizeof (struct message));
@@ -37,6 +37,13 @@
 #include "glossy.h"
 #include "net/rime.h"
 #include "contiki-conf.h"
+#if SERIAL_BINARY
+#include "serial_frame.h"
+#endif /* SERIAL_BINARY */
+
+#ifndef GLOSSY_MAC_CLASSES
+#define GLOSSY_MAC_CLASSES 1
+#endif /* GLOSSY_MAC_CLASSES */
 
 // Glossy data struct
 struct config {
@@ -49,6 +56,18 @@ typedef struct {
 	uint16_t t_s;
 	uint8_t n;
 	uint8_t seq_no;
+#if GLOSSY_DYNAMIC_SCHEDULE
+	uint8_t n_slots;
+	uint8_t slots[GLOSSY_MAX_SLOTS];	// node that reports in each slot
+#endif /* GLOSSY_DYNAMIC_SCHEDULE */
+#if GLOSSY_MAC_CLASSES > 1
+	// t_l, t_s, and n above are those of class 0, which applies to all
+	// nodes not listed in members: the first class_len[0] members belong
+	// to class 1, the next class_len[1] ones to class 2, and so on
+	struct config classes[GLOSSY_MAC_CLASSES - 1];
+	uint8_t class_len[GLOSSY_MAC_CLASSES - 1];
+	uint8_t members[GLOSSY_MAC_CLASS_MEMBERS];
+#endif /* GLOSSY_MAC_CLASSES > 1 */
 } glossy_config_struct;
 typedef struct {
 	uint16_t pkt_rate;
@@ -60,6 +79,14 @@ typedef struct {
 	glossy_report_struct glossy_report;
 //	uint8_t node_id;
 	uint8_t received;
+#if GLOSSY_DYNAMIC_SCHEDULE
+	uint8_t node_id;
+	uint8_t pending;	// node joined, changed, or missed its last slot
+	uint8_t age;		// Glossy periods since the last report
+#endif /* GLOSSY_DYNAMIC_SCHEDULE */
+#if GLOSSY_PIGGYBACK_REPORTS
+	uint8_t in_data;	// report received in a data packet, not yet printed
+#endif /* GLOSSY_PIGGYBACK_REPORTS */
 } report_struct;
 
 #if LOCATION == ETHZ
@@ -69,17 +96,39 @@ static uint8_t schedule[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
 static uint8_t schedule[] = {1, 5, 8, 13, 2, 6, 9, 14, 3, 7, 10, 15, 4, 20, 11, 16, 22, 21, 12, 17, 23, 19, 18};
 #endif /* LOCATION */
 #define N_NODES sizeof(schedule)
+#if GLOSSY_DYNAMIC_SCHEDULE
+// schedule[] only seeds the nodes known to the sink, which learns about
+// further nodes from their data packets
+#define GLOSSY_SLOTS            (glossy_config_data.n_slots)
+#define GLOSSY_SLOT_OWNER(i)    (glossy_config_data.slots[i])
+#define GLOSSY_SLOT_REPORT(i)   (report[slot_report[i]])
+#else
+#define GLOSSY_SLOTS            N_NODES
+#define GLOSSY_SLOT_OWNER(i)    (schedule[i])
+#define GLOSSY_SLOT_REPORT(i)   (report[i])
+#endif /* GLOSSY_DYNAMIC_SCHEDULE */
 static uint8_t leds[] = {1, 3, 7, 6, 4, 6, 7, 3, 1};
 
 // Interface variables
 static glossy_config_struct glossy_config_data;
 static glossy_report_struct glossy_report_data;
 static volatile struct config new_cfg;
+#if GLOSSY_MAC_CLASSES > 1
+// Configuration of the parent, which determines how long to strobe
+static volatile struct config new_parent_cfg;
+static uint8_t class_parent_id = 0;
+#endif /* GLOSSY_MAC_CLASSES > 1 */
 static uint16_t data_rate;
 int period_skew = 0;
 // Will be changed by relcollect
 uint8_t parent_id = 0;
+#if GLOSSY_DYNAMIC_SCHEDULE
+static report_struct report[GLOSSY_MAX_NODES];
+static uint8_t n_known = 0;
+static uint8_t slot_report[GLOSSY_MAX_SLOTS];
+#else
 static report_struct report[N_NODES];
+#endif /* GLOSSY_DYNAMIC_SCHEDULE */
 
 #if MAC_PROTOCOL == XMAC
 static volatile struct config current_cfg = {
@@ -119,6 +168,36 @@ static uint8_t sync_missed = 0;
 static uint8_t report_idx = 0;
 static rtimer_clock_t t_start = 0;
 
+static void print_report(const glossy_report_struct *r) {
+	unsigned long t_l_to_print = (unsigned long)current_cfg.t_l * SCALE * 10 / RTIMER_SECOND;
+	unsigned long t_s_to_print = (unsigned long)current_cfg.t_s * SCALE * 10 / RTIMER_SECOND;
+	if (t_l_to_print % 10 > 4) {
+		t_l_to_print = t_l_to_print / 10 + 1;
+	} else {
+		t_l_to_print = t_l_to_print / 10;
+	}
+	if (t_s_to_print % 10 > 4) {
+		t_s_to_print = t_s_to_print / 10 + 1;
+	} else {
+		t_s_to_print = t_s_to_print / 10;
+	}
+#if SERIAL_BINARY
+	serial_frame_begin(SERIAL_FRAME_REPORT);
+	serial_frame_put_u8(r->node_id);
+	serial_frame_put_u8(r->parent_id);
+	serial_frame_put_u16(r->pkt_rate);
+	serial_frame_put_u16(r->prr);
+	serial_frame_put_u16((rtimer_clock_t)t_l_to_print);
+	serial_frame_put_u16((rtimer_clock_t)t_s_to_print);
+	serial_frame_put_u8(current_cfg.n);
+	serial_frame_end();
+#else
+	printf("G o=%u p=%u pr=%u prr=%u tl=%u ts=%u n=%u\n",
+			r->node_id, r->parent_id, r->pkt_rate, r->prr,
+			(rtimer_clock_t)t_l_to_print, (rtimer_clock_t)t_s_to_print, current_cfg.n);
+#endif /* SERIAL_BINARY */
+}
+
 PROCESS(glossy_print_report_process, "Glossy print report process");
 PROCESS_THREAD(glossy_print_report_process, ev, data)
 {
@@ -126,36 +205,37 @@ PROCESS_THREAD(glossy_print_report_process, ev, data)
 
 	while(1) {
 		PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
-		for (report_idx = 0; report_idx < N_NODES; report_idx++) {
+		for (report_idx = 0; report_idx < GLOSSY_SLOTS; report_idx++) {
 			// print only if the node has already a parent and it is actually the node we were waiting for
-			if (report[report_idx].glossy_report.parent_id &&
-					report[report_idx].glossy_report.node_id == schedule[report_idx]) {
+			if (GLOSSY_SLOT_REPORT(report_idx).glossy_report.parent_id &&
+					GLOSSY_SLOT_REPORT(report_idx).glossy_report.node_id == GLOSSY_SLOT_OWNER(report_idx)) {
 				PROCESS_PAUSE();
-				if (report[report_idx].received) {
-				    unsigned long t_l_to_print = (unsigned long)current_cfg.t_l * SCALE * 10 / RTIMER_SECOND;
-				    unsigned long t_s_to_print = (unsigned long)current_cfg.t_s * SCALE * 10 / RTIMER_SECOND;
-				    if (t_l_to_print % 10 > 4) {
-				    	t_l_to_print = t_l_to_print / 10 + 1;
-				    } else {
-				    	t_l_to_print = t_l_to_print / 10;
-				    }
-				    if (t_s_to_print % 10 > 4) {
-				    	t_s_to_print = t_s_to_print / 10 + 1;
-				    } else {
-				    	t_s_to_print = t_s_to_print / 10;
-				    }
-					printf("G o=%u p=%u pr=%u prr=%u tl=%u ts=%u n=%u\n",
-							report[report_idx].glossy_report.node_id,
-							report[report_idx].glossy_report.parent_id,
-							report[report_idx].glossy_report.pkt_rate,
-							report[report_idx].glossy_report.prr,
-							(rtimer_clock_t)t_l_to_print, (rtimer_clock_t)t_s_to_print, current_cfg.n);
+				if (GLOSSY_SLOT_REPORT(report_idx).received) {
+					print_report(&GLOSSY_SLOT_REPORT(report_idx).glossy_report);
+#if GLOSSY_PIGGYBACK_REPORTS
+					GLOSSY_SLOT_REPORT(report_idx).in_data = 0;
+#endif /* GLOSSY_PIGGYBACK_REPORTS */
 				} else {
-					printf("node_id=%u rx_cnt=0\n", report[report_idx].glossy_report.node_id);
+					printf("node_id=%u rx_cnt=0\n", GLOSSY_SLOT_REPORT(report_idx).glossy_report.node_id);
 				}
 			}
 		}
+#if GLOSSY_PIGGYBACK_REPORTS
+		// reports that reached the sink in data packets since the last phase
+		for (report_idx = 0; report_idx < n_known; report_idx++) {
+			if (report[report_idx].in_data) {
+				report[report_idx].in_data = 0;
+				PROCESS_PAUSE();
+				print_report(&report[report_idx].glossy_report);
+			}
+		}
+#endif /* GLOSSY_PIGGYBACK_REPORTS */
+#if SERIAL_BINARY
+		serial_frame_begin(SERIAL_FRAME_FINISHED);
+		serial_frame_end();
+#else
 		printf("F\n");
+#endif /* SERIAL_BINARY */
 		if (MAC_PROTOCOL == LPP_NEW) {
 			rime_mac->on();
 		}
@@ -208,6 +288,51 @@ static inline void start_mac_energest(void) {
 	ENERGEST_ON(ENERGEST_TYPE_CPU);
 }
 
+#if GLOSSY_MAC_CLASSES > 1
+// Sets cfg to the MAC parameters of the given node: those of the class
+// the config flood lists the node in, or those of class 0.
+static void glossy_class_config(uint8_t id, volatile struct config *cfg) {
+	uint8_t i, j, m;
+	cfg->t_l = glossy_config_data.t_l;
+	cfg->t_s = glossy_config_data.t_s;
+	cfg->n = glossy_config_data.n;
+	for (i = 0, m = 0; i < GLOSSY_MAC_CLASSES - 1; i++) {
+		for (j = 0; j < glossy_config_data.class_len[i] && m < GLOSSY_MAC_CLASS_MEMBERS; j++, m++) {
+			if (glossy_config_data.members[m] == id) {
+				cfg->t_l = glossy_config_data.classes[i].t_l;
+				cfg->t_s = glossy_config_data.classes[i].t_s;
+				cfg->n = glossy_config_data.classes[i].n;
+				return;
+			}
+		}
+	}
+}
+#endif /* GLOSSY_MAC_CLASSES > 1 */
+
+// Hands a configuration received by Glossy to the adaptation process.
+// With MAC classes, nodes also adapt whenever their parent changes, as
+// they strobe for as long as their parent sleeps.
+static inline void glossy_check_config(void) {
+#if GLOSSY_MAC_CLASSES > 1
+	if (glossy_config_data.seq_no != config_seq_no || parent_id != class_parent_id) {
+		config_seq_no = glossy_config_data.seq_no;
+		class_parent_id = parent_id;
+		glossy_class_config(rimeaddr_node_addr.u8[0], &new_cfg);
+		glossy_class_config(parent_id ? parent_id : rimeaddr_node_addr.u8[0], &new_parent_cfg);
+		process_poll(&adaptation_process);
+	}
+#else
+	if (glossy_config_data.seq_no != config_seq_no) {
+		// New configuration received by Glossy
+		config_seq_no = glossy_config_data.seq_no;
+		new_cfg.t_l = glossy_config_data.t_l;
+		new_cfg.t_s = glossy_config_data.t_s;
+		new_cfg.n = glossy_config_data.n;
+		process_poll(&adaptation_process);
+	}
+#endif /* GLOSSY_MAC_CLASSES > 1 */
+}
+
 static inline void estimate_period_skew(void) {
 	if (GLOSSY_IS_SYNCED()) {
 		period_skew = get_t_ref_l() - (t_ref_l_old + (rtimer_clock_t)GLOSSY_PERIOD);
@@ -222,6 +347,138 @@ static inline void estimate_period_skew(void) {
 	}
 }
 
+#if GLOSSY_DYNAMIC_SCHEDULE
+// Values of the last report sent by this node
+static uint8_t reported = 0;
+static uint8_t reported_parent_id;
+static uint16_t reported_pkt_rate;
+static uint16_t reported_prr;
+
+static void glossy_fill_report(glossy_report_struct *r) {
+	r->node_id = rimeaddr_node_addr.u8[0];
+	r->parent_id = parent_id;
+	r->pkt_rate = data_rate;
+	r->prr = MAC_GET_PRR();
+}
+
+static inline void set_report_fields(void) {
+	glossy_fill_report(&glossy_report_data);
+	reported = 1;
+	reported_parent_id = glossy_report_data.parent_id;
+	reported_pkt_rate = glossy_report_data.pkt_rate;
+	reported_prr = glossy_report_data.prr;
+}
+
+#if !GLOSSY_PIGGYBACK_REPORTS
+/*
+ * Returns 1 if this node needs a report slot, i.e., if it has not yet
+ * reported or its parent, data rate or PRR changed since its last report.
+ * Piggybacked on data packets so that the sink can schedule the node.
+ */
+static uint8_t glossy_report_changed(void) {
+	uint16_t prr = MAC_GET_PRR();
+	return !reported || parent_id != reported_parent_id || data_rate != reported_pkt_rate ||
+			(prr > reported_prr ? prr - reported_prr : reported_prr - prr) > GLOSSY_PRR_THRESHOLD;
+}
+#endif /* GLOSSY_PIGGYBACK_REPORTS */
+
+static report_struct *find_report(uint8_t node_id) {
+	uint8_t idx;
+	for (idx = 0; idx < n_known; idx++) {
+		if (report[idx].node_id == node_id) {
+			return &report[idx];
+		}
+	}
+	if (n_known < GLOSSY_MAX_NODES) {
+		// a node we have not heard of before has joined
+		report[n_known].node_id = node_id;
+		report[n_known].pending = 1;
+		report[n_known].age = 0;
+#if GLOSSY_PIGGYBACK_REPORTS
+		report[n_known].in_data = 0;
+#endif /* GLOSSY_PIGGYBACK_REPORTS */
+		return &report[n_known++];
+	}
+	return NULL;
+}
+
+#if !GLOSSY_PIGGYBACK_REPORTS
+/*
+ * Called by the sink for every data packet: schedules the originator
+ * if it is new or has requested a slot.
+ */
+static void glossy_request_report(uint8_t node_id, uint8_t changed) {
+	report_struct *r = find_report(node_id);
+	if (r != NULL && changed) {
+		r->pending = 1;
+	}
+}
+
+#else
+/*
+ * Called by the sink for every data packet: the report it carries
+ * replaces a Glossy slot for the originator and is printed together
+ * with the reports of the next phase.
+ */
+static void glossy_data_report(const glossy_report_struct *data_report) {
+	report_struct *r = find_report(data_report->node_id);
+	if (r != NULL && data_report->parent_id) {
+		r->glossy_report = *data_report;
+		r->pending = 0;
+		r->age = 0;
+		r->in_data = 1;
+	}
+}
+#endif /* GLOSSY_PIGGYBACK_REPORTS */
+
+/*
+ * Fills the slots of the next config flood, first with pending nodes,
+ * then with nodes that have not reported for GLOSSY_REFRESH_PERIODS so
+ * that the controller does not purge them. The scan starts at a different
+ * node in every period to share the slots fairly.
+ */
+static void glossy_schedule_reports(void) {
+	static uint8_t first = 0;
+	uint8_t idx, k, refresh;
+	glossy_config_data.n_slots = 0;
+	for (idx = 0; idx < n_known; idx++) {
+		if (report[idx].age < 0xff) {
+			report[idx].age++;
+		}
+	}
+	for (refresh = 0; refresh < 2; refresh++) {
+		for (k = 0; k < n_known && glossy_config_data.n_slots < GLOSSY_MAX_SLOTS; k++) {
+			idx = (first + k) % n_known;
+			if (refresh ? (!report[idx].pending && report[idx].age >= GLOSSY_REFRESH_PERIODS) : report[idx].pending) {
+				slot_report[glossy_config_data.n_slots] = idx;
+				glossy_config_data.slots[glossy_config_data.n_slots++] = report[idx].node_id;
+			}
+		}
+	}
+	if (n_known) {
+		first = (first + 1) % n_known;
+	}
+}
+
+static inline void glossy_slot_done(uint8_t slot) {
+	report_struct *r = &GLOSSY_SLOT_REPORT(slot);
+	if (r->received && r->glossy_report.node_id == r->node_id) {
+		r->pending = 0;
+		r->age = 0;
+	} else {
+		// try again in the next period
+		r->pending = 1;
+	}
+}
+#else
+static inline void set_report_fields(void) {
+	glossy_report_data.node_id = rimeaddr_node_addr.u8[0];
+	glossy_report_data.parent_id = parent_id;
+	glossy_report_data.pkt_rate = data_rate;
+	glossy_report_data.prr = MAC_GET_PRR();
+}
+#endif /* GLOSSY_DYNAMIC_SCHEDULE */
+
 char glossy_scheduler(struct rtimer *t, void *ptr) {
 	PT_BEGIN(&pt);
 
@@ -233,6 +490,9 @@ char glossy_scheduler(struct rtimer *t, void *ptr) {
 
 			leds_on(LEDS_GREEN);
 			glossy_disable_other_interrupts();
+#if GLOSSY_DYNAMIC_SCHEDULE
+			glossy_schedule_reports();
+#endif /* GLOSSY_DYNAMIC_SCHEDULE */
 			// the sink is always the initiator during the config propagation phase
 			glossy_start((uint8_t *)&glossy_config_data, GLOSSY_CONFIG_LEN,
 					GLOSSY_INITIATOR, GLOSSY_SYNC, GLOSSY_N, 1);
@@ -249,8 +509,8 @@ char glossy_scheduler(struct rtimer *t, void *ptr) {
 					set_t_ref_l(GLOSSY_REFERENCE_TIME + GLOSSY_PERIOD);
 					set_t_ref_l_updated(1);
 				}
-				// start the round-robin reporting phase
-				for (report_idx = 0; report_idx < N_NODES; report_idx++) {
+				// start the reporting phase
+				for (report_idx = 0; report_idx < GLOSSY_SLOTS; report_idx++) {
 					leds_off(LEDS_ALL);
 					rtimer_set(t, GLOSSY_REFERENCE_TIME +
 							(report_idx + 1) * (GLOSSY_DURATION + GLOSSY_GAP), 1,
@@ -258,26 +518,22 @@ char glossy_scheduler(struct rtimer *t, void *ptr) {
 					PT_YIELD(&pt);
 					leds_on(leds[(report_idx + 1) % sizeof(leds)]);
 					// the sink is always a receiver during the round-robin reporting phase
-					glossy_start((uint8_t *)&report[report_idx].glossy_report, GLOSSY_REPORT_LEN,
+					glossy_start((uint8_t *)&GLOSSY_SLOT_REPORT(report_idx).glossy_report, GLOSSY_REPORT_LEN,
 							GLOSSY_RECEIVER, GLOSSY_NO_SYNC, GLOSSY_N, 1);
 					rtimer_set(t, GLOSSY_REFERENCE_TIME +
 							(report_idx + 1) * (GLOSSY_DURATION + GLOSSY_GAP) + GLOSSY_DURATION, 1,
 							(rtimer_callback_t)glossy_scheduler, ptr);
 					PT_YIELD(&pt);
-					report[report_idx].received = glossy_stop();
+					GLOSSY_SLOT_REPORT(report_idx).received = glossy_stop();
+#if GLOSSY_DYNAMIC_SCHEDULE
+					glossy_slot_done(report_idx);
+#endif /* GLOSSY_DYNAMIC_SCHEDULE */
 				}
 				leds_off(LEDS_ALL);
 			}
 			rtimer_set_long(t, t_start, GLOSSY_PERIOD, 1, (rtimer_callback_t)glossy_scheduler, ptr);
 			estimate_period_skew();
-			if (glossy_config_data.seq_no != config_seq_no) {
-				// New configuration received by Glossy
-				config_seq_no = glossy_config_data.seq_no;
-				new_cfg.t_l = glossy_config_data.t_l;
-				new_cfg.t_s = glossy_config_data.t_s;
-				new_cfg.n = glossy_config_data.n;
-				process_poll(&adaptation_process);
-			}
+			glossy_check_config();
 			process_poll(&glossy_print_report_process);
 			glossy_enable_other_interrupts();
 			start_mac_energest();
@@ -326,20 +582,23 @@ char glossy_scheduler(struct rtimer *t, void *ptr) {
 				} else {
 					sync_missed = 0;
 				}
-				// start the round-robin reporting phase
-				for (report_idx = 0; report_idx < N_NODES; report_idx++) {
+#if GLOSSY_DYNAMIC_SCHEDULE
+				if (!config_received || glossy_config_data.n_slots > GLOSSY_MAX_SLOTS) {
+					// we do not know the slots of this period: keep the radio off
+					glossy_config_data.n_slots = 0;
+				}
+#endif /* GLOSSY_DYNAMIC_SCHEDULE */
+				// start the reporting phase
+				for (report_idx = 0; report_idx < GLOSSY_SLOTS; report_idx++) {
 					leds_off(LEDS_ALL);
 					rtimer_set(t, GLOSSY_REFERENCE_TIME +
 							(report_idx + 1) * (GLOSSY_DURATION + GLOSSY_GAP), 1,
 							(rtimer_callback_t)glossy_scheduler, ptr);
 					PT_YIELD(&pt);
 					leds_on(leds[(report_idx + 1) % sizeof(leds)]);
-					if (rimeaddr_node_addr.u8[0] == schedule[report_idx]) {
+					if (rimeaddr_node_addr.u8[0] == GLOSSY_SLOT_OWNER(report_idx)) {
 						// initiator for the current round: set the report fields
-						glossy_report_data.node_id = rimeaddr_node_addr.u8[0];
-						glossy_report_data.parent_id = parent_id;
-						glossy_report_data.pkt_rate = data_rate;
-						glossy_report_data.prr = MAC_GET_PRR();
+						set_report_fields();
 						glossy_start((uint8_t *)&glossy_report_data, GLOSSY_REPORT_LEN,
 								GLOSSY_INITIATOR, GLOSSY_NO_SYNC, GLOSSY_N, 1);
 					} else {
@@ -370,14 +629,7 @@ char glossy_scheduler(struct rtimer *t, void *ptr) {
 						GLOSSY_PERIOD + period_skew - GLOSSY_GUARD_TIME * (1 + sync_missed), 1,
 						(rtimer_callback_t)glossy_scheduler, ptr);
 			}
-			if (glossy_config_data.seq_no != config_seq_no) {
-				// New configuration received by Glossy
-				config_seq_no = glossy_config_data.seq_no;
-				new_cfg.t_l = glossy_config_data.t_l;
-				new_cfg.t_s = glossy_config_data.t_s;
-				new_cfg.n = glossy_config_data.n;
-				process_poll(&adaptation_process);
-			}
+			glossy_check_config();
 //			process_poll(&glossy_print_process);
 			glossy_enable_other_interrupts();
 			start_mac_energest();
@@ -400,6 +652,12 @@ void glossy_init(void) {
 	glossy_config_data.n = current_cfg.n;
 	// start print processes
 	if (IS_SINK()) {
+#if GLOSSY_DYNAMIC_SCHEDULE
+		// schedule all nodes of the deployment until they have reported
+		for (report_idx = 0; report_idx < N_NODES; report_idx++) {
+			find_report(schedule[report_idx]);
+		}
+#endif /* GLOSSY_DYNAMIC_SCHEDULE */
 		process_start(&glossy_print_report_process, NULL);
 	} else {
 		process_start(&glossy_print_process, NULL);
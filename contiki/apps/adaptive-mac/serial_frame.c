@@ -0,0 +1,92 @@
+/*
+ * Copyright 2013 ETH Zurich and SICS Swedish ICT
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * author: Marco Zimmerling <zimmerling@tik.ee.ethz.ch>
+ */
+
+#include "contiki.h"
+#include "lib/crc16.h"
+#include "dev/uart1.h"
+#include "serial_frame.h"
+
+static uint8_t type;
+static uint8_t len;
+static uint8_t payload[SERIAL_FRAME_MAX_LEN];
+
+/*---------------------------------------------------------------------------*/
+void
+serial_frame_begin(uint8_t t)
+{
+	type = t;
+	len = 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+serial_frame_put_u8(uint8_t value)
+{
+	if (len < SERIAL_FRAME_MAX_LEN) {
+		payload[len++] = value;
+	}
+}
+/*---------------------------------------------------------------------------*/
+void
+serial_frame_put_u16(uint16_t value)
+{
+	serial_frame_put_u8(value & 0xff);
+	serial_frame_put_u8(value >> 8);
+}
+/*---------------------------------------------------------------------------*/
+void
+serial_frame_put_u32(uint32_t value)
+{
+	serial_frame_put_u16(value & 0xffff);
+	serial_frame_put_u16(value >> 16);
+}
+/*---------------------------------------------------------------------------*/
+void
+serial_frame_end(void)
+{
+	uint8_t i;
+	unsigned short crc;
+
+	crc = crc16_add(type, 0);
+	crc = crc16_add(len, crc);
+	crc = crc16_data(payload, len, crc);
+
+	uart1_writeb(SERIAL_FRAME_SYNC);
+	uart1_writeb(type);
+	uart1_writeb(len);
+	for (i = 0; i < len; i++) {
+		uart1_writeb(payload[i]);
+	}
+	uart1_writeb(crc & 0xff);
+	uart1_writeb(crc >> 8);
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2013 ETH Zurich and SICS Swedish ICT
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * author: Marco Zimmerling <zimmerling@tik.ee.ethz.ch>
+ */
+
+#ifndef __SERIAL_FRAME_H__
+#define __SERIAL_FRAME_H__
+
+/*
+ * Binary frames sent by the sink to the controller instead of the
+ * "A ...", "G ..." and "F" text lines. A frame is
+ *
+ *   SYNC | type | length | payload (length bytes) | CRC16 (2 bytes)
+ *
+ * where all multi-byte fields are little-endian and the CRC16 (see
+ * core/lib/crc16.c) covers type, length and payload. SYNC is a
+ * non-printable byte, so frames and text lines can be interleaved on
+ * the same serial line.
+ */
+#define SERIAL_FRAME_SYNC     0x01
+#define SERIAL_FRAME_MAX_LEN  64
+
+// Frame types
+#define SERIAL_FRAME_PACKET   'A'   // data packet received by the sink
+#define SERIAL_FRAME_REPORT   'G'   // Glossy report of a node
+#define SERIAL_FRAME_FINISHED 'F'   // end of the Glossy reports of a round
+
+void serial_frame_begin(uint8_t type);
+void serial_frame_put_u8(uint8_t value);
+void serial_frame_put_u16(uint16_t value);
+void serial_frame_put_u32(uint32_t value);
+void serial_frame_end(void);
+
+#endif /* __SERIAL_FRAME_H__ */
@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2011, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file
+ *         Glossy emulation for hosts without a CC2420. Implements the
+ *         interface of glossy.c on top of a flood medium shared by the
+ *         simulated nodes, see glossy.h.
+ */
+
+#include "glossy.h"
+#include "lib/random.h"
+#include <string.h>
+
+static uint8_t initiator, sync, rx_cnt, tx_max;
+static uint8_t *data;
+static uint8_t data_len;
+static volatile uint8_t glossy_status;
+static int node_index = -1;
+
+static rtimer_clock_t T_slot_h;
+static rtimer_clock_t t_ref_l;
+static slot_t slot;
+static uint8_t t_ref_l_updated;
+static rtimer_clock_t time_to_first_rx;
+
+/* --------------------------- Glossy process ----------------------- */
+PROCESS(glossy_process, "Glossy busy waiting process");
+PROCESS_THREAD(glossy_process, ev, data) {
+	PROCESS_BEGIN();
+
+	while (1) {
+		// floods are played out in glossy_stop(), nothing to wait for
+		PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+	}
+
+	PROCESS_END();
+}
+
+void glossy_disable_other_interrupts(void) {
+}
+
+void glossy_enable_other_interrupts(void) {
+}
+
+/* ---------------------------- Flood model ------------------------- */
+static uint8_t glossy_sim_in_range(struct glossy_sim_node *a,
+		struct glossy_sim_node *b, int range) {
+	int dx = a->x - b->x;
+	int dy = a->y - b->y;
+	return dx * dx + dy * dy <= range * range;
+}
+
+// Plays out the flood of the current round, slot by slot, up to the
+// last slot that ended before now. As in Glossy, a node that receives
+// in one slot relays in the next one, until it has transmitted tx_max
+// times; all relays in a slot send the same packet, so they do not
+// collide.
+static void glossy_sim_flood(struct glossy_sim_medium *m, rtimer_clock_t now) {
+	int tx[GLOSSY_SIM_MAX_NODES];
+	struct glossy_sim_node *a, *b;
+	int range, last_slot, s, i, k, n_tx;
+
+	m->evaluated = 1;
+	if (m->initiator < 0) {
+		return;
+	}
+	range = glossy_arch_range();
+	last_slot = (rtimer_clock_t)(now - m->t_start) / GLOSSY_SIM_SLOT;
+	m->nodes[m->initiator].tx_slot = 0;
+
+	for (s = 0; s < last_slot; s++) {
+		n_tx = 0;
+		for (i = 0; i < m->n_nodes; i++) {
+			if (m->nodes[i].off_slot < 0 && m->nodes[i].tx_slot == s) {
+				tx[n_tx++] = i;
+			}
+		}
+		if (n_tx == 0) {
+			// relays only transmit right after a reception: the flood is over
+			break;
+		}
+
+		for (i = 0; i < m->n_nodes; i++) {
+			b = &m->nodes[i];
+			if (b->off_slot >= 0 || b->tx_slot == s ||
+					RTIMER_CLOCK_LT(m->t_start + s * GLOSSY_SIM_SLOT, b->t_start)) {
+				// radio off, transmitting, or not listening yet
+				continue;
+			}
+			for (k = 0; k < n_tx; k++) {
+				if (glossy_sim_in_range(&m->nodes[tx[k]], b, range)) {
+					break;
+				}
+			}
+			if (k == n_tx || random_rand() % 100 >= GLOSSY_SIM_RELIABILITY) {
+				continue;
+			}
+			if (b->rx_cnt++ == 0) {
+				b->first_rx_slot = s;
+			}
+			if (b->tx_cnt == b->tx_max) {
+				b->off_slot = s;
+			} else {
+				b->tx_slot = s + 1;
+			}
+		}
+
+		for (k = 0; k < n_tx; k++) {
+			a = &m->nodes[tx[k]];
+			a->tx_slot = -1;
+			if (++a->tx_cnt == a->tx_max) {
+				a->off_slot = s;
+			}
+		}
+	}
+}
+
+#if GLOSSY
+static void glossy_sim_energest(struct glossy_sim_medium *m,
+		struct glossy_sim_node *self, rtimer_clock_t now) {
+	rtimer_clock_t t_off = now;
+	rtimer_clock_t T_tx = self->tx_cnt * GLOSSY_SIM_SLOT;
+	rtimer_clock_t T_on;
+
+	if (self->off_slot >= 0 &&
+			RTIMER_CLOCK_LT(m->t_start + (self->off_slot + 1) * GLOSSY_SIM_SLOT, now)) {
+		t_off = m->t_start + (self->off_slot + 1) * GLOSSY_SIM_SLOT;
+	}
+	T_on = t_off - self->t_start;
+	if (T_tx > T_on) {
+		T_tx = T_on;
+	}
+	energest_glossy_type_set(ENERGEST_TYPE_TRANSMIT,
+			energest_glossy_type_time(ENERGEST_TYPE_TRANSMIT) + T_tx / ENERGEST_DIVIDER);
+	energest_glossy_type_set(ENERGEST_TYPE_LISTEN,
+			energest_glossy_type_time(ENERGEST_TYPE_LISTEN) + (T_on - T_tx) / ENERGEST_DIVIDER);
+}
+#endif /* GLOSSY */
+
+/* --------------------------- Main interface ----------------------- */
+void glossy_start(uint8_t *data_, uint8_t data_len_, uint8_t initiator_,
+		uint8_t sync_, uint8_t tx_max_, uint8_t turn_radio_on) {
+	struct glossy_sim_medium *m = glossy_arch_medium();
+	struct glossy_sim_node *self;
+
+	// copy function arguments to the respective Glossy variables
+	data = data_;
+	data_len = data_len_;
+	initiator = initiator_;
+	sync = sync_;
+	tx_max = tx_max_;
+	rx_cnt = 0;
+	glossy_status = (initiator) ? GLOSSY_STATUS_RECEIVED : GLOSSY_STATUS_WAITING;
+	if (sync && turn_radio_on) {
+		t_ref_l_updated = 0;
+	}
+
+	// join the flood of the current round, if the radio is on
+	node_index = -1;
+	if (!turn_radio_on || m->n_nodes == GLOSSY_SIM_MAX_NODES) {
+		return;
+	}
+	node_index = m->n_nodes++;
+	m->n_active++;
+	self = &m->nodes[node_index];
+	glossy_arch_position(&self->x, &self->y);
+	self->initiator = initiator;
+	self->tx_max = tx_max;
+	self->t_start = RTIMER_NOW();
+	self->rx_cnt = 0;
+	self->tx_cnt = 0;
+	self->first_rx_slot = -1;
+	self->off_slot = -1;
+	self->tx_slot = -1;
+	if (initiator && m->initiator < 0 && !m->evaluated) {
+		// further initiators in the same round are drowned out
+		m->initiator = node_index;
+		m->t_start = self->t_start;
+		memcpy(m->data, data,
+				data_len < GLOSSY_SIM_MAX_DATA_LEN ? data_len : GLOSSY_SIM_MAX_DATA_LEN);
+	}
+	process_poll(&glossy_process);
+}
+
+uint8_t glossy_stop(void) {
+	struct glossy_sim_medium *m = glossy_arch_medium();
+	struct glossy_sim_node *self;
+	rtimer_clock_t now = RTIMER_NOW();
+
+	glossy_status = GLOSSY_STATUS_OFF;
+	if (node_index < 0) {
+		return rx_cnt;
+	}
+	if (!m->evaluated) {
+		// the first node to stop plays out the flood for everybody
+		glossy_sim_flood(m, now);
+	}
+	self = &m->nodes[node_index];
+	rx_cnt = self->rx_cnt;
+	if (rx_cnt && !initiator) {
+		memcpy(data, m->data,
+				data_len < GLOSSY_SIM_MAX_DATA_LEN ? data_len : GLOSSY_SIM_MAX_DATA_LEN);
+	}
+	if (sync && rx_cnt) {
+		// the reference time is known exactly: the start of the flood
+		T_slot_h = GLOSSY_SIM_SLOT;
+		t_ref_l = m->t_start;
+		slot = self->first_rx_slot;
+		t_ref_l_updated = 1;
+		time_to_first_rx = m->t_start + self->first_rx_slot * GLOSSY_SIM_SLOT -
+				self->t_start;
+	}
+#if GLOSSY
+	glossy_sim_energest(m, self, now);
+#endif /* GLOSSY */
+
+	if (--m->n_active == 0) {
+		// everybody is done: start a new round
+		m->n_nodes = 0;
+		m->initiator = -1;
+		m->evaluated = 0;
+	}
+	node_index = -1;
+	return rx_cnt;
+}
+
+slot_t get_relay_cnt(void) {
+	return slot;
+}
+
+rtimer_clock_t get_T_slot_h(void) {
+	return T_slot_h;
+}
+
+uint8_t is_t_ref_l_updated(void) {
+	return t_ref_l_updated;
+}
+
+rtimer_clock_t get_t_ref_l(void) {
+	return t_ref_l;
+}
+
+void set_t_ref_l(rtimer_clock_t t) {
+	t_ref_l = t;
+}
+
+void set_t_ref_l_updated(uint8_t updated) {
+	t_ref_l_updated = updated;
+}
+
+uint8_t get_glossy_status(void) {
+	return glossy_status;
+}
+
+rtimer_clock_t get_time_to_first_rx(void) {
+	return time_to_first_rx;
+}
@@ -163,6 +163,12 @@ timerb1_interrupt(void)
 									// XMAC dutycycle
 									powercycle();
 									LPM4_EXIT;
+								} else {
+									if (tbiv == TBIV_TBCCR5) {
+										// XMAC end of a wait in send_packet
+										TBCCTL5 = 0;
+										LPM4_EXIT;
+									}
 								}
 							}
 #endif /* MAC_PROTOCOL */
@@ -210,6 +216,7 @@ inline void glossy_disable_other_interrupts(void) {
 	TBCCTL2 = 0;
 	TBCCTL3 = 0;
 	TBCCTL4 = 0;
+	TBCCTL5 = 0;
 	DISABLE_FIFOP_INT();
 	CLEAR_FIFOP_INT();
 	SFD_CAP_INIT(CM_BOTH);
@@ -43,12 +43,14 @@
 
 #include "contiki.h"
 #include "dev/watchdog.h"
-#include "dev/cc2420_const.h"
 #include "dev/leds.h"
-#include "dev/spi.h"
 #include <stdio.h>
-#include <legacymsp430.h>
 #include <stdlib.h>
+#if !GLOSSY_CONF_SIM
+#include "dev/cc2420_const.h"
+#include "dev/spi.h"
+#include <legacymsp430.h>
+#endif /* !GLOSSY_CONF_SIM */
 
 #if MAC_PROTOCOL == XMAC
 #include "net/mac/xmac.h"
@@ -65,7 +67,9 @@
 #define GLOSSY_SYNC_WINDOW            64
 
 // ratio between the frequencies of the high- and low-frequency clocks
-#if COOJA
+#if GLOSSY_CONF_SIM
+#define CLOCK_PHI                     1
+#elif COOJA
 #define CLOCK_PHI                     (4194304uL / RTIMER_SECOND)
 #else
 #define CLOCK_PHI                     (F_CPU / RTIMER_SECOND)
@@ -115,8 +119,13 @@ PROCESS_NAME(glossy_process);
 void glossy_start(uint8_t *data_, uint8_t data_len_, uint8_t initiator_,
 		uint8_t sync_, uint8_t tx_max_, uint8_t turn_radio_on);
 uint8_t glossy_stop(void);
+#if GLOSSY_CONF_SIM
+void glossy_disable_other_interrupts(void);
+void glossy_enable_other_interrupts(void);
+#else
 inline void glossy_disable_other_interrupts(void);
 inline void glossy_enable_other_interrupts(void);
+#endif /* GLOSSY_CONF_SIM */
 slot_t get_relay_cnt(void);
 rtimer_clock_t get_T_slot_h(void);
 uint8_t is_t_ref_l_updated(void);
@@ -126,6 +135,60 @@ void set_t_ref_l_updated(uint8_t updated);
 uint8_t get_glossy_status(void);
 rtimer_clock_t get_time_to_first_rx(void);
 
+#if GLOSSY_CONF_SIM
+/* ------------------------- Emulated floods ------------------------ */
+/*
+ * On hosts without a CC2420 (native, netsim), glossy-sim.c emulates
+ * floods instead: all nodes that are inside a glossy_start()/glossy_stop()
+ * window when the initiator starts take part in the flood, which is
+ * played out slot by slot over the neighbor relation given by the
+ * platform. Each reception succeeds with GLOSSY_SIM_RELIABILITY percent
+ * probability, and each slot lasts GLOSSY_SIM_SLOT rtimer ticks.
+ */
+#ifdef GLOSSY_CONF_SIM_RELIABILITY
+#define GLOSSY_SIM_RELIABILITY        GLOSSY_CONF_SIM_RELIABILITY
+#else
+#define GLOSSY_SIM_RELIABILITY        100
+#endif
+#ifdef GLOSSY_CONF_SIM_SLOT
+#define GLOSSY_SIM_SLOT               GLOSSY_CONF_SIM_SLOT
+#else
+#define GLOSSY_SIM_SLOT               1
+#endif
+#ifdef GLOSSY_CONF_SIM_MAX_NODES
+#define GLOSSY_SIM_MAX_NODES          GLOSSY_CONF_SIM_MAX_NODES
+#else
+#define GLOSSY_SIM_MAX_NODES          256
+#endif
+#define GLOSSY_SIM_MAX_DATA_LEN       127
+
+struct glossy_sim_node {
+	int x, y;
+	uint8_t initiator, tx_max;
+	rtimer_clock_t t_start;
+	// outcome of the flood for this node
+	uint8_t rx_cnt, tx_cnt;
+	int first_rx_slot, off_slot;
+	// state while the flood is played out
+	int tx_slot;
+};
+
+struct glossy_sim_medium {
+	int n_nodes, n_active;
+	int initiator;
+	uint8_t evaluated;
+	rtimer_clock_t t_start;
+	uint8_t data[GLOSSY_SIM_MAX_DATA_LEN];
+	struct glossy_sim_node nodes[GLOSSY_SIM_MAX_NODES];
+};
+
+/* Implemented by the platform (glossy-arch.c). The medium must be the
+   same for all nodes that should hear each other's floods. */
+struct glossy_sim_medium *glossy_arch_medium(void);
+void glossy_arch_position(int *x, int *y);
+int glossy_arch_range(void);
+#else /* GLOSSY_CONF_SIM */
+
 /* ------------------------------ Timeouts -------------------------- */
 inline void glossy_schedule_rx_timeout(void);
 inline void glossy_stop_rx_timeout(void);
@@ -176,4 +239,6 @@ inline void glossy_end_tx(void);
 #define CLEAR_SFD_INT()			do { TBCCTL1 &= ~CCIFG; } while (0)
 #define IS_ENABLED_SFD_INT()    !!(TBCCTL1 & CCIE)
 
+#endif /* GLOSSY_CONF_SIM */
+
 #endif /* GLOSSY_H_ */
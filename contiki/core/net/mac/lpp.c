@@ -58,6 +58,7 @@
 #include "net/rime.h"
 #include "net/mac/mac.h"
 #include "net/mac/lpp.h"
+#include "net/rime/neighbor.h"
 #include "net/rime/packetbuf.h"
 #include "net/rime/announcement.h"
 #include "sys/compower.h"
@@ -101,9 +102,6 @@
 
 extern void rel_send_queued_packet(void);
 
-static uint32_t handshakes_total = 0;
-static uint32_t handshakes_succ = 0;
-
 #if WITH_DATA_ACK
 static int got_data_ack;
 #define WAIT_FOR_DATA_ACK RTIMER_SECOND/240 // 17
@@ -565,7 +563,6 @@ send_packet_to_radio(struct queue_list_item *i) {
 	#if WITH_DATA_ACK
 		struct lpp_hdr *hdr;
 		if(!is_broadcast) {
-			handshakes_total++;
 			// Wait some time for DATA_ACK
 			rtimer_clock_t t = RTIMER_NOW();
 			while (got_data_ack == 0 && RTIMER_CLOCK_LT(RTIMER_NOW(), t + WAIT_FOR_DATA_ACK)) {
@@ -580,16 +577,12 @@ send_packet_to_radio(struct queue_list_item *i) {
 								&& rimeaddr_cmp(&hdr->receiver, &rimeaddr_node_addr)) {
 							got_data_ack = 1;
 							i->acknowledged = 1;
-							handshakes_succ++;
 						}
 					}
 				}
 			}
-			// update the handshake counters
-			if (handshakes_total > HANDSHAKES_RESET_PERIOD) {
-				handshakes_total >>= 1;
-				handshakes_succ >>= 1;
-			}
+			// update the link estimate of the receiver
+			neighbor_update_prr(&qhdr->receiver, got_data_ack);
 		}
 	#endif /* WITH_DATA_ACK */
 
@@ -792,16 +785,6 @@ int lpp_got_data_ack() {
   return got_data_ack;
 }
 /*---------------------------------------------------------------------------*/
-uint16_t lpp_get_prr() {
-  PRINTF("handshakes_succ %lu, handshakes_total %lu\n", handshakes_succ, handshakes_total);
-  return (handshakes_succ != 0) ? (uint16_t) ((handshakes_succ*1000) / handshakes_total) : 1000;
-}
-/*---------------------------------------------------------------------------*/
-void lpp_reset_prr() {
-  handshakes_total = 0;
-  handshakes_succ = 0;
-}
-/*---------------------------------------------------------------------------*/
 int lpp_queue_is_empty() {
 	return (num_packets_to_send() == 0) ? 1 : 0;
 }
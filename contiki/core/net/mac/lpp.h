@@ -72,10 +72,6 @@ const struct mac_callback *lpp_callback_cb;
 
 int lpp_got_data_ack();
 
-uint16_t lpp_get_prr();
-
-void lpp_reset_prr();
-
 int lpp_queue_is_empty();
 
 #endif /* __LPP_H__ */
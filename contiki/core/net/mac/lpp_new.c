@@ -34,6 +34,7 @@
 #include "dev/leds.h"
 #include "lib/random.h"
 #include "net/rime.h"
+#include "net/rime/neighbor.h"
 #include "net/mac/lpp_new.h"
 #include "sys/energest.h"
 #include "contiki-conf.h"
@@ -96,7 +97,6 @@ struct send_buffer {
 
 /*---------------------------------------------------------------------------*/
 static uint8_t lpp_new_is_on, dutycycle_on;
-static uint32_t handshakes_total, handshakes_succ, probes_total, probes_succ = 0;
 #if !GLOSSY
 static struct rtimer rt;
 #endif /* GLOSSY */
@@ -223,20 +223,6 @@ remove_packet_from_buffer(void) {
 		radio_off();
 	}
 	if (!buffer.is_broadcast) {
-		// update the handshake counters
-		probes_total++;
-		if (probes_total == 2) {
-			// two probes are equivalent to one handshake
-//			handshakes_total++;
-//			handshakes_succ += (probes_succ >> 1);
-			probes_total = 0;
-			probes_succ = 0;
-		}
-		if (handshakes_total >= HANDSHAKES_RESET_PERIOD) {
-			// halve the handshake counters
-			handshakes_total >>= 1;
-			handshakes_succ >>= 1;
-		}
 		// notify relunicast that the transmission attempt completed
 		post_send(buffer.got_data_ack);
 	}
@@ -344,12 +330,6 @@ send_data_packet(void) {
 		packetbuf_set_attr(PACKETBUF_ATTR_TIMESTAMP, 0);
 		buffer.probe_received = 0;
 	} else {
-		// consider only the first probe that could have been received
-		if (RTIMER_CLOCK_LT(RTIMER_NOW(), buffer.t_start +
-				2*lpp_new_config.on_time + lpp_new_config.off_time +
-				LPP_NEW_MAX_RANDOM_OFF_TIME)) {
-			probes_succ++;
-		}
 		packetbuf_set_attr(PACKETBUF_ATTR_TIMESTAMP, 0);
 		radio->send(buffer.packet, buffer.len);
 #if WITH_DATA_ACK
@@ -366,10 +346,8 @@ send_data_packet(void) {
 				}
 			}
 		}
-		handshakes_total++;
-		if (buffer.got_data_ack) {
-			handshakes_succ++;
-		}
+		// update the link estimate of the receiver
+		neighbor_update_prr(&buffer.dest, buffer.got_data_ack);
 #endif /* WITH_DATA_ACK */
 		remove_packet_from_buffer();
 	}
@@ -518,18 +496,6 @@ set_lpp_new_config(const struct lpp_new_config *config) {
 	mac_on();
 }
 
-/*---------------------------------------------------------------------------*/
-uint16_t lpp_new_get_prr() {
-	PRINTF("handshakes_succ %lu, handshakes_total %lu\n", handshakes_succ, handshakes_total);
-	return (uint16_t) (((handshakes_succ+1)*1000) / (handshakes_total+1));
-}
-
-/*---------------------------------------------------------------------------*/
-void lpp_new_reset_prr() {
-	handshakes_total = 0;
-	handshakes_succ = 0;
-}
-
 /*---------------------------------------------------------------------------*/
 #if !GLOSSY
 // send timeout timer interrupt
@@ -54,10 +54,6 @@ const struct lpp_new_config *get_lpp_new_config();
 
 void set_lpp_new_config(const struct lpp_new_config *config);
 
-uint16_t lpp_new_get_prr();
-
-void lpp_new_reset_prr();
-
 #if GLOSSY
 extern struct process send_timeout_process;
 char dutycycle(void);
@@ -74,6 +74,7 @@
 #include "sys/rtimer.h"
 #include "dev/leds.h"
 #include "net/rime.h"
+#include "net/rime/neighbor.h"
 #include "net/rime/timesynch.h"
 #include "dev/radio.h"
 #include "dev/watchdog.h"
@@ -93,6 +94,30 @@
 #define WITH_RANDOM_WAIT_BEFORE_SEND 0
 #define WITH_DATA_ACK                1
 
+#ifdef XMAC_CONF_PHASE_LOCK
+#define WITH_PHASE_LOCK XMAC_CONF_PHASE_LOCK
+#else
+#define WITH_PHASE_LOCK 1
+#endif
+
+#ifdef XMAC_CONF_BURST
+#define WITH_BURST XMAC_CONF_BURST
+#else
+#define WITH_BURST 1
+#endif
+
+#if GLOSSY
+#ifdef XMAC_CONF_SLEEP_WAIT
+#define WITH_SLEEP_WAIT XMAC_CONF_SLEEP_WAIT
+#else
+#define WITH_SLEEP_WAIT 1
+#endif
+#else /* GLOSSY */
+/* Waking up from the sleep needs TBCCR5, which only the Timer B
+   interrupt handler in glossy.c serves. */
+#define WITH_SLEEP_WAIT 0
+#endif /* GLOSSY */
+
 struct announcement_data {
 	uint16_t id;
 	uint16_t value;
@@ -118,12 +143,65 @@ struct announcement_msg {
 #define TYPE_STROBE_ACK   3
 #define TYPE_DATA_ACK     4
 
+#define TYPE_MASK         0x00ff
+/* Set in the type of a unicast DATA packet if the sender has more
+   packets queued for the receiver, which then stays awake for them. */
+#define FLAG_PENDING      0x0100
+
 struct xmac_hdr {
 	uint16_t type;
 	rimeaddr_t sender;
 	rimeaddr_t receiver;
 };
 
+#if WITH_PHASE_LOCK
+/* The STROBE_ACK tells the sender where the receiver is in its duty
+   cycle, so that the next time the sender can start strobing just
+   before the receiver wakes up, rather than at a random point of the
+   receiver's cycle. */
+struct xmac_ack_hdr {
+	struct xmac_hdr hdr;
+	rtimer_clock_t since_on;	/* time since the receiver woke up */
+	rtimer_clock_t period;		/* on_time + off_time of the receiver */
+	rtimer_clock_t on_time;		/* on_time of the receiver */
+};
+
+/* Learned wake-up phase of a neighbor. */
+struct xmac_phase {
+	rimeaddr_t addr;
+	rtimer_clock_t t_on;		/* a wake-up of the neighbor in local time */
+	clock_time_t c_on;		/* the same wake-up in clock ticks */
+	rtimer_clock_t period;		/* 0 if the entry is not in use */
+	rtimer_clock_t on_time;
+};
+
+#ifdef XMAC_CONF_PHASE_NEIGHBORS
+#define PHASE_NEIGHBORS XMAC_CONF_PHASE_NEIGHBORS
+#else
+#define PHASE_NEIGHBORS 8
+#endif
+
+/* Phases older than this are not trusted anymore. */
+#define PHASE_MAX_AGE (60 * CLOCK_SECOND)
+/* Time to start strobing before the predicted wake-up, which grows by
+   one tick every 2^PHASE_DRIFT_SHIFT ticks (~60 ppm) to account for
+   the drift between the clocks of sender and receiver. */
+#define PHASE_GUARD_TIME (RTIMER_SECOND / 1000)
+#define PHASE_DRIFT_SHIFT 14
+#endif /* WITH_PHASE_LOCK */
+
+#if WITH_SLEEP_WAIT
+/* Waits shorter than this are not worth going to sleep for. */
+#define SLEEP_MIN_TIME 2
+#endif /* WITH_SLEEP_WAIT */
+
+#if WITH_BURST
+/* Time the receiver stays awake for the next packet of a burst. The
+   sender only sends without strobing during the first half, so that the
+   packet cannot arrive after the receiver went back to sleep. */
+#define BURST_TIMEOUT (RTIMER_SECOND / 32)
+#endif /* WITH_BURST */
+
 #ifdef XMAC_CONF_ON_TIME
 #define DEFAULT_ON_TIME (XMAC_CONF_ON_TIME)
 #else
@@ -168,11 +246,27 @@ static volatile unsigned char radio_is_on = 0;
 static volatile int was_timeout = 0;
 static volatile rtimer_clock_t last_on = 0;
 
-static uint32_t handshakes_total = 0;
-static uint32_t handshakes_succ = 0;
 
 static const struct radio_driver *radio;
 
+#if GLOSSY
+/* The duty cycle runs on Timer B, see powercycle(). */
+#define XMAC_NOW() (TBR)
+#else
+#define XMAC_NOW() RTIMER_NOW()
+#endif /* GLOSSY */
+
+#if WITH_PHASE_LOCK
+static struct xmac_phase phases[PHASE_NEIGHBORS];
+#endif /* WITH_PHASE_LOCK */
+
+#if WITH_BURST
+/* Receiver that is still awake after our last packet, see send_packet(). */
+static int burst_open = 0;
+static rimeaddr_t burst_receiver;
+static rtimer_clock_t burst_time;
+#endif /* WITH_BURST */
+
 #undef LEDS_ON
 #undef LEDS_OFF
 #undef LEDS_TOGGLE
@@ -250,6 +344,12 @@ void timeout(void) {
   {
 	off();
   }
+#if WITH_BURST
+  /* A burst may have kept us awake past our next wake-up. */
+  while (RTIMER_CLOCK_LT(last_on + xmac_config.on_time + xmac_config.off_time, TBR)) {
+	last_on += xmac_config.on_time + xmac_config.off_time;
+  }
+#endif /* WITH_BURST */
   TBCCR3 = last_on + xmac_config.on_time + xmac_config.off_time;
   TBCCTL3 = CCIE;
 }
@@ -263,6 +363,12 @@ static void timeout(struct rtimer *t, void *ptr) {
   {
     off();
   }
+#if WITH_BURST
+  /* A burst may have kept us awake past our next wake-up. */
+  while (RTIMER_CLOCK_LT(last_on + xmac_config.on_time + xmac_config.off_time, RTIMER_NOW())) {
+    last_on += xmac_config.on_time + xmac_config.off_time;
+  }
+#endif /* WITH_BURST */
   rtimer_set(t, last_on + xmac_config.on_time + xmac_config.off_time, 1,
 	     (void (*)(struct rtimer *, void *))powercycle, ptr);
 }
@@ -407,14 +513,131 @@ format_announcement(char *hdr)
 }
 #endif /* XMAC_CONF_ANNOUNCEMENTS */
 /*---------------------------------------------------------------------------*/
+#if WITH_PHASE_LOCK
+static struct xmac_phase *phase_lookup(const rimeaddr_t *addr) {
+	int i;
+	for (i = 0; i < PHASE_NEIGHBORS; i++) {
+		if (phases[i].period != 0 && rimeaddr_cmp(&phases[i].addr, addr)) {
+			return &phases[i];
+		}
+	}
+	return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void phase_update(const rimeaddr_t *addr, rtimer_clock_t t, const struct xmac_ack_hdr *ack) {
+	struct xmac_phase *p = phase_lookup(addr);
+	int i;
+
+	if (p == NULL) {
+		/* Take an unused entry or replace the oldest one. */
+		p = &phases[0];
+		for (i = 0; i < PHASE_NEIGHBORS && p->period != 0; i++) {
+			if (phases[i].period == 0
+					|| (clock_time_t)(clock_time() - phases[i].c_on) > (clock_time_t)(clock_time() - p->c_on)) {
+				p = &phases[i];
+			}
+		}
+		rimeaddr_copy(&p->addr, addr);
+	}
+	p->t_on = t - ack->since_on;
+	p->c_on = clock_time() - ack->since_on / (RTIMER_SECOND / CLOCK_SECOND);
+	p->period = ack->period;
+	p->on_time = ack->on_time;
+}
+/*---------------------------------------------------------------------------*/
+static void phase_drop(const rimeaddr_t *addr) {
+	struct xmac_phase *p = phase_lookup(addr);
+	if (p != NULL) {
+		p->period = 0;
+	}
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the time to wait until just before the next wake-up of the
+   receiver, or 0 if its phase is unknown or it is awake or about to
+   wake up. */
+static rtimer_clock_t phase_wait(const rimeaddr_t *addr) {
+	struct xmac_phase *p = phase_lookup(addr);
+	unsigned long elapsed, guard, pos;
+
+	if (p == NULL) {
+		return 0;
+	}
+	if ((clock_time_t)(clock_time() - p->c_on) > PHASE_MAX_AGE) {
+		p->period = 0;
+		return 0;
+	}
+
+	/* The rtimer wraps within seconds, so the clock tells how many
+	   times it wrapped since the wake-up we know about. */
+	elapsed = (unsigned long)(clock_time_t)(clock_time() - p->c_on) * (RTIMER_SECOND / CLOCK_SECOND);
+	elapsed += (short)(rtimer_clock_t)((rtimer_clock_t)(XMAC_NOW() - p->t_on) - (rtimer_clock_t)elapsed);
+
+	guard = PHASE_GUARD_TIME + (elapsed >> PHASE_DRIFT_SHIFT);
+	if (2 * guard >= p->period) {
+		return 0;
+	}
+	/* Position in the receiver's cycle at now + guard. */
+	pos = (elapsed + guard) % p->period;
+	if (pos < 2 * guard) {
+		return 0;
+	}
+	/* Position at now is pos - guard: the receiver is awake. */
+	if (pos - guard < p->on_time) {
+		return 0;
+	}
+	return (rtimer_clock_t)(p->period - pos);
+}
+#endif /* WITH_PHASE_LOCK */
+/*---------------------------------------------------------------------------*/
+/* Waits until the deadline or, if packet is set, until the radio has
+   received a packet. With WITH_SLEEP_WAIT the CPU sleeps in LPM0 in the
+   meantime, woken up by TBCCR5 at the deadline or by the FIFOP interrupt
+   of the radio. LPM0 keeps SMCLK running for the radio SPI and the UART,
+   and any other interrupt wakes us up as well, hence the loop. */
+static void wait_until(rtimer_clock_t deadline, int packet) {
+#if WITH_SLEEP_WAIT
+	int s;
+
+	/* Timer B runs from the same 32 kHz clock as the rtimer. */
+	TBCCR5 = TBR + (rtimer_clock_t)(deadline - RTIMER_NOW());
+	TBCCTL5 = CCIE;
+	while (RTIMER_CLOCK_LT(RTIMER_NOW(), deadline) && !(packet && FIFOP_IS_1)) {
+		s = splhigh();
+		if (  (TBCCTL5 & CCIE)
+		   && RTIMER_CLOCK_LT(RTIMER_NOW() + SLEEP_MIN_TIME, deadline)
+		   && !(packet && FIFOP_IS_1)) {
+			ENERGEST_OFF(ENERGEST_TYPE_CPU);
+			ENERGEST_ON(ENERGEST_TYPE_LPM);
+			_BIS_SR(GIE | CPUOFF);
+			ENERGEST_OFF(ENERGEST_TYPE_LPM);
+			ENERGEST_ON(ENERGEST_TYPE_CPU);
+		}
+		splx(s);
+	}
+	TBCCTL5 = 0;
+#else /* WITH_SLEEP_WAIT */
+	/* Returning early is fine, as the callers poll the radio in a loop. */
+	if (!packet) {
+		while (RTIMER_CLOCK_LT(RTIMER_NOW(), deadline));
+	}
+#endif /* WITH_SLEEP_WAIT */
+}
+/*---------------------------------------------------------------------------*/
 static int send_packet(void) {
 	if (!xmac_is_on) {
 		return 1;
 	}
 
+#if WITH_PHASE_LOCK
+	struct {
+		struct xmac_hdr hdr;
+	} strobe;
+	struct xmac_ack_hdr ack;
+#else /* WITH_PHASE_LOCK */
 	struct {
 		struct xmac_hdr hdr;
 	} strobe, ack;
+#endif /* WITH_PHASE_LOCK */
 
 	volatile int len = 0;
 	rtimer_clock_t t, t0;
@@ -462,6 +685,23 @@ static int send_packet(void) {
 		is_broadcast = 1;
 	}
 
+	/* Send strobes until the receiver replies with an ACK, unless it is
+	   still awake after our previous packet. */
+	int got_strobe_ack = 0;
+#if WITH_BURST
+	if (!is_broadcast) {
+		if (  burst_open
+		   && rimeaddr_cmp(&burst_receiver, &hdr.receiver)
+		   && RTIMER_CLOCK_LT(RTIMER_NOW(), burst_time + BURST_TIMEOUT / 2)) {
+			got_strobe_ack = 1;
+		}
+		if (packetbuf_attr(PACKETBUF_ATTR_PENDING)) {
+			hdr.type |= FLAG_PENDING;
+		}
+	}
+	burst_open = 0;
+#endif /* WITH_BURST */
+
 	/* Copy the X-MAC header to the header portion of the packet buffer. */
 	packetbuf_hdralloc(sizeof(struct xmac_hdr));
 	memcpy(packetbuf_hdrptr(), &hdr, sizeof(struct xmac_hdr));
@@ -474,6 +714,21 @@ static int send_packet(void) {
 	rimeaddr_copy(&strobe.hdr.sender, &rimeaddr_node_addr);
 	rimeaddr_copy(&strobe.hdr.receiver, packetbuf_addr(PACKETBUF_ADDR_RECEIVER));
 
+	rtimer_clock_t strobe_time = xmac_config.strobe_time;
+#if WITH_PHASE_LOCK
+	/* If we know when the receiver wakes up, we keep the radio off until
+	   shortly before. The strobes still stop strobe_time after now, so
+	   if the receiver does not show up, the packet fails no later than
+	   without phase locking, and we strobe for the full time next time. */
+	if (!is_broadcast && !got_strobe_ack) {
+		rtimer_clock_t wait = phase_wait(&strobe.hdr.receiver);
+		if (wait > 0 && wait < strobe_time) {
+			wait_until(RTIMER_NOW() + wait, 0);
+			strobe_time -= wait;
+		}
+	}
+#endif /* WITH_PHASE_LOCK */
+
 	/* Turn on the radio to listen for the strobe ACK. */
 	if (!is_broadcast) {
 		on();
@@ -488,13 +743,12 @@ static int send_packet(void) {
 	}
 #endif /* EXCLUDE_TRICKLE_ENERGY */
 
-	/* Send strobes until the receiver replies with an ACK */
 	int strobes = 0;
-	int got_strobe_ack = 0;
+	int in_burst = got_strobe_ack;
 	int interferred = 0;
 	rtimer_clock_t strobe_wait_time;
 	t0 = RTIMER_NOW();
-	for (strobes = 0; got_strobe_ack == 0 && interferred == 0 && RTIMER_CLOCK_LT(RTIMER_NOW(), t0 + xmac_config.strobe_time); strobes++) {
+	for (strobes = 0; got_strobe_ack == 0 && interferred == 0 && RTIMER_CLOCK_LT(RTIMER_NOW(), t0 + strobe_time); strobes++) {
 		if (is_broadcast){
 			/* Send the data packet. */
 			radio->send(packetbuf_hdrptr(), packetbuf_totlen());
@@ -509,31 +763,38 @@ static int send_packet(void) {
 		while (got_strobe_ack == 0 && interferred == 0 && RTIMER_CLOCK_LT(RTIMER_NOW(), t + strobe_wait_time)) {
 			/* See if we got an ACK */
 			if (!is_broadcast) {
-				len = radio->read((uint8_t *) &ack, sizeof(struct xmac_hdr));
+				len = radio->read((uint8_t *) &ack, sizeof(ack));
 				if (len > 0) {
 					if (  ack.hdr.type == TYPE_STROBE_ACK
 					   && rimeaddr_cmp(&ack.hdr.sender, &rimeaddr_node_addr)
 					   && rimeaddr_cmp(&ack.hdr.receiver, &rimeaddr_node_addr)) {
 						/* We got an ACK from the receiver, so we can immediately send the packet. */
 						got_strobe_ack = 1;
+#if WITH_PHASE_LOCK
+						if (len >= (int) sizeof(ack) && ack.period > 0) {
+							phase_update(&strobe.hdr.receiver, XMAC_NOW(), &ack);
+						}
+#endif /* WITH_PHASE_LOCK */
 					}// else if (ack.hdr.type != TYPE_DATA_ACK) {
 						/* We got a STROBE or a DATA packet, so we immediately stop strobing. */
 					//	interferred = 1;
 					//}
 				}
 			}
+			if (got_strobe_ack == 0) {
+				/* Sleep until the next strobe or until a packet arrives. */
+				wait_until(t + strobe_wait_time, !is_broadcast);
+			}
 		}
 	}
-	if (!is_broadcast) {
-		handshakes_total++;
-		if (got_strobe_ack) {
-			handshakes_succ++;
-		}
-		// update the handshake counters
-		if (handshakes_total >= HANDSHAKES_RESET_PERIOD) {
-			handshakes_total >>= 1;
-			handshakes_succ >>= 1;
+	if (!is_broadcast && !in_burst) {
+		neighbor_update_prr(&hdr.receiver, got_strobe_ack);
+#if WITH_PHASE_LOCK
+		if (!got_strobe_ack) {
+			/* The receiver did not wake up when we expected it to. */
+			phase_drop(&strobe.hdr.receiver);
 		}
+#endif /* WITH_PHASE_LOCK */
 	}
 
 #if EXCLUDE_TRICKLE_ENERGY
@@ -584,7 +845,6 @@ static int send_packet(void) {
 		if(!is_broadcast) {
 			// Wait some time for DATA_ACK
 			//PRINTF("x-mac: send_packet: waiting for DATA_ACK\n");
-			handshakes_total++;
 			t = RTIMER_NOW();
 			while (got_data_ack == 0 && RTIMER_CLOCK_LT(RTIMER_NOW(), t + T_WAIT)) {
 				// Check whether we got a DATA_ACK
@@ -594,14 +854,24 @@ static int send_packet(void) {
 							&& rimeaddr_cmp(&strobe.hdr.receiver, &rimeaddr_node_addr)) {
 						PRINTF("x-mac: send_packet: got DATA_ACK\n");
 						got_data_ack = 1;
-						handshakes_succ++;
 					}
 				}
+				if (got_data_ack == 0) {
+					wait_until(t + T_WAIT, 1);
+				}
+			}
+#if WITH_BURST
+			if (got_data_ack && (hdr.type & FLAG_PENDING)) {
+				/* The receiver stays awake for our next packet. */
+				burst_open = 1;
+				rimeaddr_copy(&burst_receiver, &hdr.receiver);
+				burst_time = RTIMER_NOW();
 			}
-			// update the handshake counters
-			if (handshakes_total >= HANDSHAKES_RESET_PERIOD) {
-				handshakes_total >>= 1;
-				handshakes_succ >>= 1;
+#endif /* WITH_BURST */
+			/* Like the strobe, the data handshake of a burst packet would
+			   only sample the link while the receiver is kept awake. */
+			if (!in_burst) {
+				neighbor_update_prr(&hdr.receiver, got_data_ack);
 			}
 		}
 #endif /* WITH_DATA_ACK */
@@ -674,10 +944,16 @@ static int read_packet(void) {
 
 					/* Construct the STROBE_ACK. By using the same address as both
 					   sender and receiver, we flag the message is a strobe ack.*/
-					struct xmac_hdr msg;
-					msg.type = TYPE_STROBE_ACK;
-					rimeaddr_copy(&msg.receiver, &hdr->sender);
-					rimeaddr_copy(&msg.sender, &hdr->sender);
+#if WITH_PHASE_LOCK
+					struct xmac_ack_hdr ack;
+#else /* WITH_PHASE_LOCK */
+					struct {
+						struct xmac_hdr hdr;
+					} ack;
+#endif /* WITH_PHASE_LOCK */
+					ack.hdr.type = TYPE_STROBE_ACK;
+					rimeaddr_copy(&ack.hdr.receiver, &hdr->sender);
+					rimeaddr_copy(&ack.hdr.sender, &hdr->sender);
 
 					// we set the timeout rtimer only after receiving the first strobe
 					// i.e. only when waiting_for_packet is zero
@@ -698,7 +974,12 @@ static int read_packet(void) {
 						   send the STROBE ACK. */
 						waiting_for_packet = 1;
 						on();
-						radio->send((const uint8_t *) &msg, sizeof(struct xmac_hdr));
+#if WITH_PHASE_LOCK
+						ack.since_on = XMAC_NOW() - last_on;
+						ack.period = xmac_config.on_time + xmac_config.off_time;
+						ack.on_time = xmac_config.on_time;
+#endif /* WITH_PHASE_LOCK */
+						radio->send((const uint8_t *) &ack, sizeof(ack));
 					}
 				}
 			}
@@ -715,12 +996,33 @@ static int read_packet(void) {
 
 			/* We are done processing the strobe and we therefore return to the caller. */
 			return RIME_OK;
-		} else if (hdr->type == TYPE_DATA) {
+		} else if ((hdr->type & TYPE_MASK) == TYPE_DATA) {
 			if (rimeaddr_cmp(&hdr->receiver, &rimeaddr_node_addr) || rimeaddr_cmp(&hdr->receiver, &rimeaddr_null)) {
 				/* This is a regular packet that is destined to us or to the broadcast address. */
 
+#if WITH_BURST
+				int burst = (hdr->type & FLAG_PENDING) && rimeaddr_cmp(&hdr->receiver, &rimeaddr_node_addr);
+				if (burst) {
+					/* More packets follow, so we stay awake and push the
+					   timeout back, which also keeps the duty cycle from
+					   turning off the radio. */
+#if GLOSSY
+					TBCCTL3 = 0;
+					TBCCR2 = TBR + BURST_TIMEOUT;
+					TBCCTL2 = CCIE;
+#else
+					rtimer_reset(&rt, RTIMER_NOW() + BURST_TIMEOUT, 1, (void (*)(struct rtimer *, void *))timeout, NULL);
+#endif /* GLOSSY */
+					was_timeout = 1;
+					on();
+				} else {
+					/* We have received the final packet, so we can go back to being asleep. */
+					off();
+				}
+#else /* WITH_BURST */
 				/* We have received the final packet, so we can go back to being asleep. */
 				off();
+#endif /* WITH_BURST */
 
 				/* Set sender and receiver packet attributes */
 				if (!rimeaddr_cmp(&hdr->receiver, &rimeaddr_null)) {
@@ -755,7 +1057,11 @@ static int read_packet(void) {
 #endif /* XMAC_CONF_COMPOWER */
 
 				//someone_is_sending = 0;
+#if WITH_BURST
+				waiting_for_packet = burst;
+#else /* WITH_BURST */
 				waiting_for_packet = 0;
+#endif /* WITH_BURST */
 
 				return packetbuf_totlen();
 			}
@@ -849,6 +1155,14 @@ xmac_init(const struct radio_driver *d) {
 /*---------------------------------------------------------------------------*/
 int turn_on(void) {
 	xmac_is_on = 1;
+#if WITH_PHASE_LOCK
+	/* Neighbors restart their duty cycle along with us, after Glossy or
+	   a new configuration, so what we learned about them is outdated. */
+	memset(phases, 0, sizeof(phases));
+#endif /* WITH_PHASE_LOCK */
+#if WITH_BURST
+	burst_open = 0;
+#endif /* WITH_BURST */
 #if GLOSSY
 	if(in_on_phase) {
 		TBCCR3 = TBR + (random_rand() % xmac_config.off_time);
@@ -908,18 +1222,12 @@ int xmac_got_data_ack(){
   return got_data_ack;
 }
 /*---------------------------------------------------------------------------*/
-uint16_t xmac_get_prr() {
-  PRINTF("handshakes_succ %lu, handshakes_total %lu\n", handshakes_succ, handshakes_total);
-  if (handshakes_succ && handshakes_total) {
-	  return (uint16_t) ((handshakes_succ*1000) / handshakes_total);
-  } else {
-	  // avoid returning 0 as a PRR
-	  return (uint16_t) 1;
-  }
-}
-/*---------------------------------------------------------------------------*/
-void xmac_reset_prr(){
-  handshakes_total = 0;
-  handshakes_succ = 0;
+int xmac_burst_open(const rimeaddr_t *receiver) {
+#if WITH_BURST
+	return burst_open && rimeaddr_cmp(&burst_receiver, receiver)
+			&& RTIMER_CLOCK_LT(RTIMER_NOW(), burst_time + BURST_TIMEOUT / 2);
+#else /* WITH_BURST */
+	return 0;
+#endif /* WITH_BURST */
 }
 /*---------------------------------------------------------------------------*/
@@ -75,6 +75,7 @@
 #include "sys/rtimer.h"
 #include "net/mac/mac.h"
 #include "dev/radio.h"
+#include "net/rime/rimeaddr.h"
 
 #define XMAC_RECEIVER "xmac.recv"
 #define XMAC_STROBES "xmac.strobes"
@@ -101,9 +102,7 @@ void set_xmac_config(const struct xmac_config *config);
 
 int xmac_got_data_ack();
 
-uint16_t xmac_get_prr();
-
-void xmac_reset_prr();
+int xmac_burst_open(const rimeaddr_t *receiver);
 
 int turn_on();
 int turn_off(int keep_radio_on);
@@ -170,6 +170,19 @@ neighbor_etx(struct neighbor *n)
 {
   int i, etx;
 
+  if(n->prr_samples >= NEIGHBOR_PRR_MIN_SAMPLES) {
+    /* A transmission succeeds if all of its handshakes do, so the ETX
+       is the inverse of the ratio to the power of their number. */
+    uint32_t p = n->prr;
+    for(i = 1; i < NEIGHBOR_PRR_HANDSHAKES; ++i) {
+      p = (p * n->prr) / NEIGHBOR_PRR_ONE;
+    }
+    if(p <= NEIGHBOR_PRR_ONE / 255) {
+      return 255;
+    }
+    return NEIGHBOR_ETX_SCALE * ((NEIGHBOR_PRR_ONE + p / 2) / p);
+  }
+
   etx = 0;
   for(i = 0; i < NEIGHBOR_NUM_ETXS; ++i) {
     etx += n->etxs[i];
@@ -247,6 +260,57 @@ neighbor_add(rimeaddr_t *addr, uint8_t nrtmetric, uint8_t netx)
       n->etxs[i] = netx;
     }
     n->etxptr = 0;
+    n->prr = NEIGHBOR_PRR_ONE;
+    n->prr_samples = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+neighbor_update_prr(rimeaddr_t *addr, uint8_t success)
+{
+  struct neighbor *n = neighbor_find(addr);
+
+  if(n != NULL) {
+    if(success) {
+      n->prr += (NEIGHBOR_PRR_ONE - n->prr) >> NEIGHBOR_PRR_SHIFT;
+    } else {
+      n->prr -= n->prr >> NEIGHBOR_PRR_SHIFT;
+    }
+    if(n->prr_samples < 255) {
+      n->prr_samples++;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the handshake success ratio of the link to n in per mille. */
+uint16_t
+neighbor_prr(struct neighbor *n)
+{
+  uint16_t prr = (uint16_t)(((uint32_t)n->prr * 1000 + NEIGHBOR_PRR_ONE / 2) / NEIGHBOR_PRR_ONE);
+
+  /* Avoid returning 0 as a PRR. */
+  return prr > 0 ? prr : 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the handshake success ratio of the link to the current best
+   neighbor in per mille, or 1 if we have none. */
+uint16_t
+neighbor_best_prr(void)
+{
+  if(last_best == NULL) {
+    return 1;
+  }
+  return neighbor_prr(last_best);
+}
+/*---------------------------------------------------------------------------*/
+void
+neighbor_reset_prr(void)
+{
+  struct neighbor *n;
+
+  for(n = list_head(neighbors_list); n != NULL; n = n->next) {
+    n->prr = NEIGHBOR_PRR_ONE;
+    n->prr_samples = 0;
   }
 }
 /*---------------------------------------------------------------------------*/
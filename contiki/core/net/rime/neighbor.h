@@ -56,6 +56,28 @@
 #define NEIGHBOR_ETX_SCALE 1
 #define NEIGHBOR_NUM_ETXS 16
 
+/* The handshake success ratio of the link to a neighbor is kept as an
+   exponentially weighted moving average in fixed point, where
+   NEIGHBOR_PRR_ONE stands for 1. Each handshake moves the average by
+   1/2^NEIGHBOR_PRR_SHIFT of the difference, so it remembers about the
+   last 2^NEIGHBOR_PRR_SHIFT (by default 8) handshakes. */
+#define NEIGHBOR_PRR_ONE 0x8000U
+#ifdef NEIGHBOR_CONF_PRR_SHIFT
+#define NEIGHBOR_PRR_SHIFT NEIGHBOR_CONF_PRR_SHIFT
+#else
+#define NEIGHBOR_PRR_SHIFT 3
+#endif
+/* Number of handshakes a transmission needs, each of which the MAC
+   samples with neighbor_update_prr(): two for X-MAC (strobe and
+   data), one for LPP, which only reports the data ACK. */
+#ifdef NEIGHBOR_CONF_PRR_HANDSHAKES
+#define NEIGHBOR_PRR_HANDSHAKES NEIGHBOR_CONF_PRR_HANDSHAKES
+#else
+#define NEIGHBOR_PRR_HANDSHAKES 1
+#endif
+/* Number of handshakes before the average replaces the ETX history. */
+#define NEIGHBOR_PRR_MIN_SAMPLES 4
+
 struct neighbor {
   struct neighbor *next;
   uint16_t time;
@@ -63,6 +85,8 @@ struct neighbor {
   uint16_t rtmetric;
   uint8_t etxptr;
   uint8_t etxs[NEIGHBOR_NUM_ETXS];
+  uint16_t prr;
+  uint8_t prr_samples;
 };
 
 void neighbor_init(void);
@@ -79,6 +103,11 @@ void neighbor_set_lifetime(int seconds);
 
 uint8_t neighbor_etx(struct neighbor *n);
 
+void neighbor_update_prr(rimeaddr_t *addr, uint8_t success);
+uint16_t neighbor_prr(struct neighbor *n);
+uint16_t neighbor_best_prr(void);
+void neighbor_reset_prr(void);
+
 int neighbor_num(void);
 struct neighbor *neighbor_get(int num);
 
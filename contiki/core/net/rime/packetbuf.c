@@ -83,6 +83,7 @@ const char *packetbuf_attr_strings[] =
 
     "PACKETBUF_ATTR_RELIABLE",
     "PACKETBUF_ATTR_ERELIABLE",
+    "PACKETBUF_ATTR_PENDING",
 
     "PACKETBUF_ADDR_SENDER",
     "PACKETBUF_ADDR_RECEIVER",
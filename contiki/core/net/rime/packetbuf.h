@@ -346,6 +346,7 @@ enum {
   
   PACKETBUF_ATTR_RELIABLE,
   PACKETBUF_ATTR_ERELIABLE,
+  PACKETBUF_ATTR_PENDING,
 
   PACKETBUF_ADDR_SENDER,
   PACKETBUF_ADDR_RECEIVER,
@@ -241,6 +241,9 @@ void rel_send_queued_packet(void) {
 			queuing_size_sum >>= 1;
 		}
 #endif /* QUEUING_STATS */
+		/* All queued packets go to the same parent, so tell the MAC layer
+		   whether another one follows right after this one. */
+		packetbuf_set_attr(PACKETBUF_ATTR_PENDING, i->next != NULL);
    		c->forwarding = 1;
    		relunicast_send(&c->relunicast_conn,
    				&n->addr,
@@ -175,6 +175,8 @@ void post_send(int acknowledged)
 /*---------------------------------------------------------------------------*/
 int relunicast_send(struct relunicast_conn *c, rimeaddr_t *receiver,
 		uint8_t max_retransmissions, rimeaddr_t *esender) {
+	clock_time_t delay;
+
 	if (relunicast_is_transmitting(c)) {
 		PRINTF("%d.%d: relunicast: already transmitting\n",
 				rimeaddr_node_addr.u8[0],rimeaddr_node_addr.u8[1]);
@@ -194,6 +196,14 @@ int relunicast_send(struct relunicast_conn *c, rimeaddr_t *receiver,
 	c->is_tx = 1;
 	rimeaddr_copy(&c->esender, esender);
 	rimeaddr_copy(&c->receiver, receiver);
+	/* If X-MAC keeps the receiver awake for us, send right away rather
+	   than at a random point of the duty cycle. */
+	delay = (clock_time_t) RANDOM_DELAY;
+#if MAC_PROTOCOL == XMAC
+	if (xmac_burst_open(receiver)) {
+		delay = 0;
+	}
+#endif /* MAC_PROTOCOL */
 #if WITH_FTSP
 	// set the time attribute only if we are the esender (and this is the first transmission attempt)
 	if (rimeaddr_cmp(&c->esender, &rimeaddr_node_addr)) {
@@ -209,9 +219,9 @@ int relunicast_send(struct relunicast_conn *c, rimeaddr_t *receiver,
 		c->time_high = (rtimer_clock_t) (time >> 16);
 		c->time_low = (rtimer_clock_t) (time & 0xffff);
 	}
-	schedule_send(c, (clock_time_t) RANDOM_DELAY);
+	schedule_send(c, delay);
 #else
-	ctimer_set(&c->t, (clock_time_t) RANDOM_DELAY, send, c);
+	ctimer_set(&c->t, delay, send, c);
 #endif /* GLOSSY */
 
 	return 1;
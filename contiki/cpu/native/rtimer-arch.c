@@ -54,6 +54,45 @@
 #endif
 
 /*---------------------------------------------------------------------------*/
+#if CLOCK_CONF_VIRTUAL_TIME
+static int scheduled;
+static rtimer_clock_t next_time;
+
+void
+rtimer_arch_init(void)
+{
+  scheduled = 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+rtimer_arch_schedule(rtimer_clock_t t)
+{
+  PRINTF("rtimer_arch_schedule time %u now %u\n", t,
+	 (rtimer_clock_t)clock_time());
+  next_time = t;
+  scheduled = 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+rtimer_arch_next(clock_time_t *time)
+{
+  if(!scheduled) {
+    return 0;
+  }
+  *time = clock_time() + (rtimer_clock_t)(next_time - rtimer_arch_now());
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+rtimer_arch_check(void)
+{
+  if(scheduled && !RTIMER_CLOCK_LT(rtimer_arch_now(), next_time)) {
+    scheduled = 0;
+    rtimer_run_next();
+  }
+}
+/*---------------------------------------------------------------------------*/
+#else /* CLOCK_CONF_VIRTUAL_TIME */
 static void
 interrupt(int sig)
 {
@@ -84,4 +123,5 @@ rtimer_arch_schedule(rtimer_clock_t t)
   val.it_interval.tv_sec = val.it_interval.tv_usec = 0;
   setitimer(ITIMER_REAL, &val, NULL);
 }
+#endif /* CLOCK_CONF_VIRTUAL_TIME */
 /*---------------------------------------------------------------------------*/
@@ -47,4 +47,12 @@
 
 #define rtimer_arch_now() clock_time()
 
+#if CLOCK_CONF_VIRTUAL_TIME
+/* In virtual time, the main loop runs the rtimers: rtimer_arch_next()
+   tells when the next one is due, and rtimer_arch_check() runs it once
+   the clock has been advanced to that time. */
+int rtimer_arch_next(clock_time_t *time);
+void rtimer_arch_check(void);
+#endif /* CLOCK_CONF_VIRTUAL_TIME */
+
 #endif /* __RTIMER_ARCH_H__ */
@@ -42,7 +42,29 @@
 #include <time.h>
 #include <sys/time.h>
 
+#if CLOCK_CONF_VIRTUAL_TIME
+static clock_time_t virtual_time;
+
+/*---------------------------------------------------------------------------*/
+void
+clock_set_virtual_time(clock_time_t time)
+{
+  virtual_time = time;
+}
+/*---------------------------------------------------------------------------*/
+clock_time_t
+clock_time(void)
+{
+  return virtual_time;
+}
+/*---------------------------------------------------------------------------*/
+unsigned long
+clock_seconds(void)
+{
+  return virtual_time / CLOCK_SECOND;
+}
 /*---------------------------------------------------------------------------*/
+#else /* CLOCK_CONF_VIRTUAL_TIME */
 clock_time_t
 clock_time(void)
 {
@@ -62,6 +84,7 @@ clock_seconds(void)
  
   return tv.tv_sec;
 }
+#endif /* CLOCK_CONF_VIRTUAL_TIME */
 /*---------------------------------------------------------------------------*/
 void
 clock_delay(unsigned int d)
@@ -76,6 +76,20 @@ typedef unsigned long clock_time_t;
 
 #define CLOCK_CONF_SECOND 1000
 
+/* Run the clock in virtual time (make VIRTUAL_TIME=1): whenever all
+   processes are idle, the clock skips ahead to the next timer instead
+   of waiting for it. */
+#ifndef CLOCK_CONF_VIRTUAL_TIME
+#define CLOCK_CONF_VIRTUAL_TIME 0
+#endif /* CLOCK_CONF_VIRTUAL_TIME */
+
+#if CLOCK_CONF_VIRTUAL_TIME
+void clock_set_virtual_time(clock_time_t time);
+#endif /* CLOCK_CONF_VIRTUAL_TIME */
+
+/* Glossy floods are emulated by core/dev/glossy-sim.c. */
+#define GLOSSY_CONF_SIM 1
+
 #define LOG_CONF_ENABLED 1
 
 /* Not part of C99 but actually present */
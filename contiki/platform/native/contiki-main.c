@@ -51,6 +51,36 @@ PROCINIT(&etimer_process, &tcpip_process, &serial_line_process);
 
 SENSORS(&pir_sensor, &vib_sensor, &button_sensor);
 
+/*---------------------------------------------------------------------------*/
+#if CLOCK_CONF_VIRTUAL_TIME
+/* Advances the clock to the next etimer or rtimer. Returns zero if
+   there is no timer to wait for. */
+static int
+advance_virtual_time(void)
+{
+  clock_time_t next, t;
+  int pending;
+
+  pending = 0;
+  if(etimer_pending()) {
+    next = etimer_next_expiration_time();
+    pending = 1;
+  }
+  if(rtimer_arch_next(&t) && (!pending || (long)(t - next) < 0)) {
+    next = t;
+    pending = 1;
+  }
+  if(!pending) {
+    return 0;
+  }
+
+  if((long)(next - clock_time()) > 0) {
+    clock_set_virtual_time(next);
+  }
+  rtimer_arch_check();
+  return 1;
+}
+#endif /* CLOCK_CONF_VIRTUAL_TIME */
 /*---------------------------------------------------------------------------*/
 int
 main(void)
@@ -68,17 +98,25 @@ main(void)
   while(1) {
     fd_set fds;
     int n;
-    struct timeval tv;
+    struct timeval tv, *tvp;
     
     n = process_run();
 
     
     tv.tv_sec = 0;
     tv.tv_usec = 1;
+    tvp = &tv;
+
+#if CLOCK_CONF_VIRTUAL_TIME
+    if(n == 0 && !advance_virtual_time()) {
+      /* No timers are pending, so only input can wake us up. */
+      tvp = NULL;
+    }
+#endif /* CLOCK_CONF_VIRTUAL_TIME */
 
     FD_ZERO(&fds);
     FD_SET(STDIN_FILENO, &fds);
-    select(1, &fds, NULL, NULL, &tv);
+    select(1, &fds, NULL, NULL, tvp);
 
     if(FD_ISSET(STDIN_FILENO, &fds)) {
       char c;
@@ -104,6 +104,28 @@ typedef unsigned short uip_stats_t;
 typedef unsigned long clock_time_t;
 #define CLOCK_CONF_SECOND 1000
 
+/* Run all nodes in the simulator process instead of forking one
+   process per node (make NETSIM_INPROCESS=1), see main.c. */
+#ifndef NETSIM_INPROCESS
+#define NETSIM_INPROCESS 0
+#endif /* NETSIM_INPROCESS */
+
+/* Run the simulation in virtual time (make VIRTUAL_TIME=1): whenever
+   all nodes are idle, the clock skips ahead to the next timer of any
+   node. The simulator must then own all nodes. */
+#ifndef CLOCK_CONF_VIRTUAL_TIME
+#define CLOCK_CONF_VIRTUAL_TIME 0
+#endif /* CLOCK_CONF_VIRTUAL_TIME */
+
+#if CLOCK_CONF_VIRTUAL_TIME && !NETSIM_INPROCESS
+#error "Virtual time requires NETSIM_INPROCESS"
+#endif /* CLOCK_CONF_VIRTUAL_TIME && !NETSIM_INPROCESS */
+
+/* Glossy floods are emulated by core/dev/glossy-sim.c, over the nodes
+   within range of the ether. Only the nodes of the in-process mode
+   hear each other's floods. */
+#define GLOSSY_CONF_SIM 1
+
 
 /*------------------------------------------------------------------------------*/
 
@@ -54,6 +54,7 @@
 #include "net/mac/lpp.h"
 
 #include "ether.h"
+#include "node.h"
 
 #include <stdio.h>
 #ifndef HAVE_SNPRINTF
@@ -112,8 +113,13 @@ remove_route(int s)
 void
 contiki_main(int flag)
 {
+#if NETSIM_INPROCESS
+  /* All nodes share the simulator's pid and rand() state. */
+  random_init(node.id);
+#else /* NETSIM_INPROCESS */
   random_init(getpid());
   srand(getpid());
+#endif /* NETSIM_INPROCESS */
 
   leds_init();
   
@@ -171,6 +177,11 @@ contiki_main(int flag)
   rtimer_init();
   
   autostart_start(autostart_processes);
+
+#if NETSIM_INPROCESS
+  /* The simulator runs the node with contiki_main_run(). */
+  return;
+#endif /* NETSIM_INPROCESS */
   
   while(1) {
     int n;
@@ -187,4 +198,39 @@ contiki_main(int flag)
   }
 }
 /*---------------------------------------------------------------------------*/
+#if NETSIM_INPROCESS
+long
+contiki_main_run(int packets)
+{
+  long wakeup, t;
+#if CLOCK_CONF_VIRTUAL_TIME
+  clock_time_t next;
+#endif /* CLOCK_CONF_VIRTUAL_TIME */
+
+  if(packets) {
+    process_poll(&ethernode_process);
+  }
+#if CLOCK_CONF_VIRTUAL_TIME
+  rtimer_arch_check();
+#endif /* CLOCK_CONF_VIRTUAL_TIME */
+  etimer_request_poll();
+  while(process_run() > 0);
+
+  wakeup = -1;
+  if(etimer_pending()) {
+    t = (long)(etimer_next_expiration_time() - clock_time());
+    wakeup = t > 0 ? t : 0;
+  }
+#if CLOCK_CONF_VIRTUAL_TIME
+  if(rtimer_arch_next(&next)) {
+    t = (long)(next - clock_time());
+    if(wakeup < 0 || t < wakeup) {
+      wakeup = t > 0 ? t : 0;
+    }
+  }
+#endif /* CLOCK_CONF_VIRTUAL_TIME */
+  return wakeup;
+}
+#endif /* NETSIM_INPROCESS */
+/*---------------------------------------------------------------------------*/
 process_event_t codeprop_event_quit;
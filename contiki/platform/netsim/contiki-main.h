@@ -37,4 +37,13 @@
 
 void contiki_main(int b);
 
+/**
+ * Run a node started with contiki_main() in the in-process mode until
+ * it has no more events to process.
+ *
+ * \param packets Non-zero if packets have been queued for the node
+ * \return Time (ms) until the next etimer of the node expires, or -1
+ */
+long contiki_main_run(int packets);
+
 #endif /* __CONTIKI_MAIN_H__ */
@@ -73,9 +73,27 @@
 #define NULL 0
 #endif /* NULL */
 
-MEMB(packets, struct ether_packet, 20000);
+#define ETHER_MAX_PACKETS 20000
+
+#if NETSIM_INPROCESS
+/* Packets are allocated from the heap, so that they are shared by
+   all node contexts and not copied at every context switch. */
+static int num_packets;
+#else /* NETSIM_INPROCESS */
+MEMB(packets, struct ether_packet, ETHER_MAX_PACKETS);
+#endif /* NETSIM_INPROCESS */
 LIST(active_packets);
 
+/* Active packets hashed by grid cell, with cells as large as the
+   transmission range: a node can only hear packets sent from its own
+   or the eight surrounding cells. */
+#define ETHER_CELLS 1024
+static struct ether_packet *cells[ETHER_CELLS];
+
+/* Packets within range of the current node, in active list order. */
+static struct ether_packet **in_range;
+static int in_range_size;
+
 static u8_t rxbuffer[2048];
 static clock_time_t timer;
 
@@ -86,6 +104,76 @@ static clock_time_t timer;
 
 static int s, sc;
 
+#if NETSIM_INPROCESS
+/* In-process mode: the datagrams that would be sent over UDP are
+   instead put in per-port queues. Queue 0 is the ether server's, the
+   queue of the node at port p is p - NODES_PORTBASE + 1. The queues
+   are allocated before the first node is started, so the pointer is
+   the same in all node contexts. */
+struct ether_datagram {
+  struct ether_datagram *next;
+  int len;
+  char data[2048];
+};
+
+struct ether_queue {
+  struct ether_datagram *first, *last;
+};
+
+static struct ether_queue *queues;
+
+/*-----------------------------------------------------------------------------------*/
+static void
+queue_put(struct ether_queue *q, char *data, int len)
+{
+  struct ether_datagram *d;
+
+  if(len > sizeof(d->data)) {
+    len = sizeof(d->data);
+  }
+  d = malloc(sizeof(struct ether_datagram));
+  if(d == NULL) {
+    perror("ether: queue_put: malloc");
+    return;
+  }
+  memcpy(d->data, data, len);
+  d->len = len;
+  d->next = NULL;
+  if(q->last == NULL) {
+    q->first = d;
+  } else {
+    q->last->next = d;
+  }
+  q->last = d;
+}
+/*-----------------------------------------------------------------------------------*/
+static int
+queue_get(struct ether_queue *q, u8_t *buf, int bufsize)
+{
+  struct ether_datagram *d;
+  int len;
+
+  d = q->first;
+  if(d == NULL) {
+    return 0;
+  }
+  q->first = d->next;
+  if(q->first == NULL) {
+    q->last = NULL;
+  }
+  len = d->len < bufsize ? d->len : bufsize;
+  memcpy(buf, d->data, len);
+  free(d);
+  return len;
+}
+/*-----------------------------------------------------------------------------------*/
+int
+ether_node_pending(int port)
+{
+  return queues[port - NODES_PORTBASE + 1].first != NULL;
+}
+#endif /* NETSIM_INPROCESS */
+
 #define PTYPE_NONE   0
 #define PTYPE_CLOCK  1
 #define PTYPE_DATA   2
@@ -177,11 +265,22 @@ ether_server_init(void)
 
   gettimeofday(&t1, NULL);
   
+#if !NETSIM_INPROCESS
   memb_init(&packets);
+#endif /* !NETSIM_INPROCESS */
   list_init(active_packets);
 
   timer = 0;
 
+#if NETSIM_INPROCESS
+  queues = calloc(NODES_MAX + 1, sizeof(struct ether_queue));
+  if(queues == NULL) {
+    perror("ether_server_init: calloc");
+    exit(1);
+  }
+  return;
+#endif /* NETSIM_INPROCESS */
+
   s = socket(AF_INET,SOCK_DGRAM,0);
 
   if(s < 0) {
@@ -209,6 +308,11 @@ void
 ether_client_init(int port)
 {
   struct sockaddr_in sa;
+
+#if NETSIM_INPROCESS
+  sc = port - NODES_PORTBASE + 1;
+  return;
+#endif /* NETSIM_INPROCESS */
     
   sc = socket(AF_INET,SOCK_DGRAM,0);
   
@@ -238,6 +342,10 @@ ether_client_poll(void)
   struct timeval tv;
   int ret;
 
+#if NETSIM_INPROCESS
+  return queues[sc].first != NULL;
+#endif /* NETSIM_INPROCESS */
+
   FD_ZERO(&fdset);
   FD_SET(sc, &fdset);
 
@@ -256,9 +364,14 @@ u16_t
 ether_client_read(u8_t *buf, int bufsize)
 {
   int ret, len;
+  struct ether_hdr *hdr = (struct ether_hdr *)rxbuffer;
+
+#if NETSIM_INPROCESS
+  ret = queue_get(&queues[sc], rxbuffer, sizeof(rxbuffer));
+  if(ret > 0) {
+#else /* NETSIM_INPROCESS */
   fd_set fdset;
   struct timeval tv;
-  struct ether_hdr *hdr = (struct ether_hdr *)rxbuffer;
 
   FD_ZERO(&fdset);
   FD_SET(sc, &fdset);
@@ -278,6 +391,7 @@ ether_client_read(u8_t *buf, int bufsize)
       perror("ether_client_poll: recv");
       return 0;
     }
+#endif /* NETSIM_INPROCESS */
     len = ret;
 
     if(len > bufsize) {
@@ -317,19 +431,28 @@ void
 ether_server_poll(void)
 {
   int ret;
-  fd_set fdset;
-  struct timeval tv;
   struct ether_hdr *hdr = (struct ether_hdr *)rxbuffer;
   /*  struct timeval rtime1, rtime2;
   struct timespec ts;
   struct timezone tz;*/
+#if !NETSIM_INPROCESS
+  struct timeval tv;
 
-  
   tv.tv_sec = 0;
   tv.tv_usec = 100;
+#endif /* !NETSIM_INPROCESS */
 
   
   do {
+#if NETSIM_INPROCESS
+    ret = queue_get(&queues[0], rxbuffer, sizeof(rxbuffer));
+    if(ret == 0) {
+      return;
+    }
+    {
+#else /* NETSIM_INPROCESS */
+    fd_set fdset;
+
     FD_ZERO(&fdset);
     FD_SET(s, &fdset);
 
@@ -343,6 +466,7 @@ ether_server_poll(void)
 	perror("ether_poll: read");
 	return;
       }
+#endif /* NETSIM_INPROCESS */
       nodes_set_line(hdr->srcx, hdr->srcy, hdr->linex, hdr->liney);
       switch(hdr->type) {
       case PTYPE_DATA:
@@ -379,7 +503,14 @@ ether_put(char *data, int len, int x, int y)
 
   /*  printf("ether_put: packet len %d at (%d, %d)\n", len, x, y);*/
   
+#if NETSIM_INPROCESS
+  p = NULL;
+  if(num_packets < ETHER_MAX_PACKETS) {
+    p = (struct ether_packet *)malloc(sizeof(struct ether_packet));
+  }
+#else /* NETSIM_INPROCESS */
   p = (struct ether_packet *)memb_alloc(&packets);
+#endif /* NETSIM_INPROCESS */
 
   if(p != NULL) {
     if(len > 1500) {
@@ -390,6 +521,9 @@ ether_put(char *data, int len, int x, int y)
     p->x = x;
     p->y = y;
     list_push(active_packets, p);
+#if NETSIM_INPROCESS
+    num_packets++;
+#endif /* NETSIM_INPROCESS */
 
 
   }
@@ -399,6 +533,11 @@ static void
 send_packet(char *data, int len, int port)
 {
   struct sockaddr_in sa;
+
+#if NETSIM_INPROCESS
+  queue_put(&queues[port - NODES_PORTBASE + 1], data, len);
+  return;
+#endif /* NETSIM_INPROCESS */
   
   memset((char *)&sa, 0, sizeof(sa));
   sa.sin_family = AF_INET;
@@ -410,6 +549,26 @@ send_packet(char *data, int len, int port)
   }
 }
 /*-----------------------------------------------------------------------------------*/
+static int
+cell_coord(int v, int range)
+{
+  /* Round towards minus infinity, also for negative coordinates. */
+  return v >= 0 ? v / range : -((range - 1 - v) / range);
+}
+/*-----------------------------------------------------------------------------------*/
+static int
+cell_hash(int cellx, int celly)
+{
+  return ((unsigned int)cellx * 73856093u ^
+	  (unsigned int)celly * 19349663u) & (ETHER_CELLS - 1);
+}
+/*-----------------------------------------------------------------------------------*/
+static int
+seq_compare(const void *a, const void *b)
+{
+  return (*(struct ether_packet **)a)->seq - (*(struct ether_packet **)b)->seq;
+}
+/*-----------------------------------------------------------------------------------*/
 void
 ether_tick(void)
 {
@@ -417,9 +576,40 @@ ether_tick(void)
   struct ether_hdr *hdr;
   int port;
   int x, y;
-  int i;
+  int i, j, n;
+  int cellx, celly, dx, dy;
+  int range, range2, dist2;
   int interference;
 
+  if(list_head(active_packets) == NULL) {
+    ++timer;
+    return;
+  }
+
+  /* Hash all active packets into the grid. Packets are numbered in
+     list order, so that nodes see them in the same order as when
+     walking the list. */
+  range = abs(ether_strength()) > 0 ? abs(ether_strength()) : 1;
+  range2 = ether_strength() * ether_strength();
+  memset(cells, 0, sizeof(cells));
+  for(p = list_head(active_packets), n = 0; p != NULL; p = p->next, ++n) {
+    p->seq = n;
+    p->cellx = cell_coord(p->x, range);
+    p->celly = cell_coord(p->y, range);
+    j = cell_hash(p->cellx, p->celly);
+    p->cell_next = cells[j];
+    cells[j] = p;
+  }
+  num_sent += n;
+  if(n > in_range_size) {
+    in_range = realloc(in_range, n * sizeof(struct ether_packet *));
+    if(in_range == NULL) {
+      perror("ether_tick: realloc");
+      exit(1);
+    }
+    in_range_size = n;
+  }
+
   /* Go through every node and see if there are any packets destined
      to them. If two or more packets are sent in the vicinity of the
      node, they interfere with each otehr and none reaches the
@@ -430,77 +620,81 @@ ether_tick(void)
     y = nodes_node(i)->y;
     port = nodes_node(i)->port;
 
-    /* Go through all active packets to see if anyone is sent within
-       range of this node. */
-    for(p = list_head(active_packets); p != NULL; p = p->next) {
-      
-      num_sent++;
-      
-      /* Update the node type. */
-      hdr = (struct ether_hdr *)p->data;
-      /*      nodes_node(hdr->srcid)->type = hdr->srcnodetype;*/
-      
-      if(!(p->x == x && p->y == y) && /* Don't send packets back to
-					 the sender. */
-	 (p->x - x) * (p->x - x) +
-	 (p->y - y) * (p->y - y) <=
-	 ether_strength() * ether_strength()) {
-
-	hdr->signal = ether_strength() * ether_strength() -
-	  (p->x - x) * (p->x - x) -
-	  (p->y - y) * (p->y - y);
-	/* This packet was sent in the reception range of this node,
-	   so we check against all other packets to see if there is
-	   more than one packet sent towards this node. If so, we have
-	   interference and the node will not be able to receive any
-	   data. */
-	interference = 0;
-	if(collisions) {
-	  for(q = list_head(active_packets); q != NULL; q = q->next) {
-	    
-	    /* Compute the distance^2 and check against signal strength. */
-	    if(p != q &&
-	       ((q->x - x) * (q->x - x) +
-		(q->y - y) * (q->y - y) <=
-		ether_strength() * ether_strength())) {
-
-	      /* If the potentially interfering packets were sent from
-		 the same node, then they don't interfere with each
-		 other. Otherwise they interfere and we sent the
-		 interference flag to 1. */
-	      if(p->x != q->x ||
-		 p->y != q->y) {
-		interference = 1;
-	      }
-	      break;
-	    }
+    /* Collect the packets sent within range of this node from the
+       surrounding cells. */
+    n = 0;
+    cellx = cell_coord(x, range);
+    celly = cell_coord(y, range);
+    for(dx = -1; dx <= 1; ++dx) {
+      for(dy = -1; dy <= 1; ++dy) {
+	for(p = cells[cell_hash(cellx + dx, celly + dy)]; p != NULL;
+	    p = p->cell_next) {
+	  if(p->cellx == cellx + dx && p->celly == celly + dy &&
+	     (p->x - x) * (p->x - x) +
+	     (p->y - y) * (p->y - y) <= range2) {
+	    in_range[n++] = p;
 	  }
 	}
+      }
+    }
+    if(n == 0) {
+      continue;
+    }
+    if(n > 1) {
+      qsort(in_range, n, sizeof(struct ether_packet *), seq_compare);
+    }
 
-	if(interference) {
-	  num_collisions++;
-	  /*	  printf("Collisions %d\n", num_collisions);*/
+    for(j = 0; j < n; ++j) {
+      p = in_range[j];
+
+      /* Don't send packets back to the sender. */
+      if(p->x == x && p->y == y) {
+	continue;
+      }
+
+      hdr = (struct ether_hdr *)p->data;
+      dist2 = (p->x - x) * (p->x - x) + (p->y - y) * (p->y - y);
+      hdr->signal = range2 - dist2;
+
+      /* This packet was sent in the reception range of this node, so
+	 we check the first other packet sent towards this node. If it
+	 was sent from another node, we have interference and the node
+	 will not be able to receive any data. Packets sent from the
+	 same node don't interfere with each other. */
+      interference = 0;
+      if(collisions && n > 1) {
+	q = in_range[j == 0 ? 1 : 0];
+	if(p->x != q->x || p->y != q->y) {
+	  interference = 1;
 	}
+      }
+
+      if(interference) {
+	num_collisions++;
+	/*	  printf("Collisions %d\n", num_collisions);*/
+      }
 	
-	if(!interference) {
-	  /*	  printf("ether: delivering packet from %d to %d\n",
+      if(!interference) {
+	/*	  printf("ether: delivering packet from %d to %d\n",
 		  hdr->srcid, port);*/
-	  if((unsigned int)((rand() * 17) % 65536) >= drop_probability) {
-	    send_packet(p->data, p->len, port);
-	    num_received++;
-	  } else {
- 	    num_drops++;
- 	  }
+	if((unsigned int)((rand() * 17) % 65536) >= drop_probability) {
+	  send_packet(p->data, p->len, port);
+	  num_received++;
+	} else {
+	  num_drops++;
 	}
       }
-
-
     }
   }
 
   /* Remove all packets from the active packets list. */
   while((p = list_pop(active_packets)) != NULL) {
+#if NETSIM_INPROCESS
+    free(p);
+    num_packets--;
+#else /* NETSIM_INPROCESS */
     memb_free(&packets, (void *) p);
+#endif /* NETSIM_INPROCESS */
   }
 
   ++timer;
@@ -522,6 +716,11 @@ static void
 node_send_packet(char *data, int len)
 {
   struct sockaddr_in sa;
+
+#if NETSIM_INPROCESS
+  queue_put(&queues[0], data, len);
+  return;
+#endif /* NETSIM_INPROCESS */
   
   memset((char *)&sa, 0, sizeof(sa));
   sa.sin_family = AF_INET;
@@ -44,6 +44,11 @@ struct ether_packet {
   int len;
   int x, y;
   int destx, desty;
+
+  /* Spatial grid used by ether_tick() */
+  struct ether_packet *cell_next;
+  int cellx, celly;
+  int seq;
 };
 
 
@@ -72,6 +77,7 @@ void ether_send_sensor_data(struct sensor_data *d, int srcx, int srcy, int stren
 
 
 int ether_client_poll(void);
+int ether_node_pending(int port);
 
 struct ether_packet * ether_packets(void);
 
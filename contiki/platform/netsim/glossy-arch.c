@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2011, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Flood medium for the emulated Glossy (core/dev/glossy-sim.c):
+ *         nodes hear each other within the range of the ether.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "glossy.h"
+#include "ether.h"
+#include "node.h"
+
+/* Allocated from the heap by glossy_arch_init(), before the nodes are
+   started, so that all nodes of the in-process mode share it. Forked
+   nodes each get a medium of their own and never hear a flood. */
+static struct glossy_sim_medium *medium;
+/*---------------------------------------------------------------------------*/
+void
+glossy_arch_init(void)
+{
+  medium = calloc(1, sizeof(struct glossy_sim_medium));
+  if(medium == NULL) {
+    perror("glossy_arch_init: calloc");
+    exit(1);
+  }
+  medium->initiator = -1;
+}
+/*---------------------------------------------------------------------------*/
+struct glossy_sim_medium *
+glossy_arch_medium(void)
+{
+  if(medium == NULL) {
+    glossy_arch_init();
+  }
+  return medium;
+}
+/*---------------------------------------------------------------------------*/
+void
+glossy_arch_position(int *x, int *y)
+{
+  *x = node_x();
+  *y = node_y();
+}
+/*---------------------------------------------------------------------------*/
+int
+glossy_arch_range(void)
+{
+  return ether_strength();
+}
+/*---------------------------------------------------------------------------*/
@@ -43,6 +43,14 @@
  * sensor node processes communicates with the starting process using
  * named pipes. These pipes carry messages such as data packets and
  * configuration and statistics information requests.
+ *
+ * In the in-process mode (NETSIM_INPROCESS), all sensor nodes instead
+ * run in the starting process. Every node has its own copy of the
+ * data and bss segments of the program, which is copied in before the
+ * node runs and copied out afterwards, and the messages are put in
+ * queues instead of being sent on sockets. A node is only run when
+ * packets have been queued for it or when one of its etimers has
+ * expired.
  */
 #include "contiki-net.h"
 #include "display.h"
@@ -60,13 +68,42 @@
 #include <stdio.h>
 #include <sys/wait.h>
 #include <arpa/inet.h>
+#include <string.h>
+#include <sys/time.h>
 
 in_addr_t gwaddr, winifaddr;
 
 void netsim_init(void);
+void glossy_arch_init(void);
 
 static int main_process = 0;
 
+#if NETSIM_INPROCESS
+/* The data and bss segments, as laid out by the GNU linker. */
+extern char __data_start[], _end[];
+#define CONTEXT_START __data_start
+#define CONTEXT_SIZE  (_end - __data_start)
+
+#if CLOCK_CONF_VIRTUAL_TIME
+/* Wall-clock milliseconds of simulation between display updates. */
+#define VIRTUAL_TIME_SLICE 40
+#endif /* CLOCK_CONF_VIRTUAL_TIME */
+
+struct node_context {
+  char *mem;
+  int port;
+  clock_time_t wakeup;
+  int idle;
+};
+
+/* Allocated from the heap. Only accessed in the simulator's own
+   context, or through local copies of the pointers while node
+   contexts are swapped in. */
+static struct node_context *contexts;
+static int num_contexts;
+static char *server_context;
+#endif /* NETSIM_INPROCESS */
+
 /*---------------------------------------------------------------------------*/
 static void
 sigchld_handler(int sig)
@@ -92,16 +129,106 @@ sigchld_handler(int sig)
   }
 }
 /*---------------------------------------------------------------------------*/
+#if NETSIM_INPROCESS
+/* Runs all nodes that have packets or expired timers. Returns the
+   number of nodes run and stores the earliest wakeup time of the idle
+   nodes in *next, or returns -1 there if no node has a timer. */
+static int
+run_nodes(long *next)
+{
+  struct node_context *ctx, *end;
+  char *server;
+  clock_time_t now;
+  long wakeup;
+  int packets, swapped, run;
+
+  /* Only local variables from here on: the globals are those of the
+     node that is swapped in. */
+  ctx = contexts;
+  end = contexts + num_contexts;
+  server = server_context;
+  now = node_time();
+  swapped = 0;
+  run = 0;
+  *next = -1;
+
+  for(; ctx < end; ++ctx) {
+    packets = ether_node_pending(ctx->port);
+    if(!packets && (ctx->idle || (long)(now - ctx->wakeup) < 0)) {
+      if(!ctx->idle &&
+	 (*next < 0 || (long)(ctx->wakeup - now) < *next)) {
+	*next = (long)(ctx->wakeup - now);
+      }
+      continue;
+    }
+
+    if(!swapped) {
+      memcpy(server, CONTEXT_START, CONTEXT_SIZE);
+      swapped = 1;
+    }
+    memcpy(CONTEXT_START, ctx->mem, CONTEXT_SIZE);
+    wakeup = contiki_main_run(packets);
+    memcpy(ctx->mem, CONTEXT_START, CONTEXT_SIZE);
+
+    ctx->idle = wakeup < 0;
+    ctx->wakeup = now + (wakeup > 0 ? wakeup : 0);
+    ++run;
+  }
+
+  if(swapped) {
+    memcpy(CONTEXT_START, server, CONTEXT_SIZE);
+  }
+  return run;
+}
+#endif /* NETSIM_INPROCESS */
+/*---------------------------------------------------------------------------*/
+#if CLOCK_CONF_VIRTUAL_TIME
+/* Runs simulation rounds for about one display period of wall-clock
+   time. Rounds in which no node has anything to do advance the clock
+   to the next node timer instead of waiting for it. */
+static void
+idle(void)
+{
+  struct timeval start, now;
+  long next;
+
+  gettimeofday(&start, NULL);
+  do {
+    ether_server_poll();
+    ether_tick();
+    /* Only nodes send packets, so if none of them ran there is
+       nothing in the ether either. */
+    if(run_nodes(&next) == 0) {
+      if(next < 0) {
+	break;
+      }
+      node_set_time(node_time() + next);
+    }
+    while(process_run() > 0);
+    gettimeofday(&now, NULL);
+  } while((now.tv_sec - start.tv_sec) * 1000 +
+	  (now.tv_usec - start.tv_usec) / 1000 < VIRTUAL_TIME_SLICE);
+
+  display_tick();
+  display_redraw();
+}
+#else /* CLOCK_CONF_VIRTUAL_TIME */
 static void
 idle(void)
 {
   int events;
+#if NETSIM_INPROCESS
+  long next;
+#endif /* NETSIM_INPROCESS */
 
   do {
     ether_server_poll();
     display_tick();
     display_redraw();
     ether_tick();
+#if NETSIM_INPROCESS
+    run_nodes(&next);
+#endif /* NETSIM_INPROCESS */
     events = process_run();
     if(events > 0) {
       printf("events %d\n", events);
@@ -109,14 +236,43 @@ idle(void)
   } while(events > 0);
 
 }
+#endif /* CLOCK_CONF_VIRTUAL_TIME */
 /*---------------------------------------------------------------------------*/
 static int
 start_node(int x, int y, int b)
 {
   pid_t pid;
-  struct timeval tv;
   static unsigned short port = NODES_PORTBASE;
   
+#if NETSIM_INPROCESS
+  struct node_context *ctx;
+
+  if(num_contexts == NODES_MAX) {
+    fprintf(stderr, "start_node: too many nodes\n");
+    exit(1);
+  }
+  ctx = &contexts[num_contexts++];
+  ctx->mem = malloc(CONTEXT_SIZE);
+  if(ctx->mem == NULL) {
+    perror("start_node: malloc");
+    exit(1);
+  }
+  ctx->port = port;
+  ctx->wakeup = node_time();
+  ctx->idle = 0;
+
+  /* Start the node from a copy of the current globals, as fork()
+     would, and save them as the node's context. */
+  memcpy(server_context, CONTEXT_START, CONTEXT_SIZE);
+  node_init(port - NODES_PORTBASE + 2, x, y, b);
+  ethernode_init(port);
+  contiki_main(b);
+  memcpy(ctx->mem, CONTEXT_START, CONTEXT_SIZE);
+  memcpy(CONTEXT_START, server_context, CONTEXT_SIZE);
+  pid = 0;
+#else /* NETSIM_INPROCESS */
+  struct timeval tv;
+
   pid = fork();
   
   if(pid == 0) {
@@ -141,6 +297,7 @@ start_node(int x, int y, int b)
     
     /* NOTREACHED */
   }
+#endif /* NETSIM_INPROCESS */
 
   if(b) {
     nodes_base_node_port = port;
@@ -192,9 +349,28 @@ main(int argc, char **argv)
   atexit(nodes_kill);
   atexit(ether_print_stats);
 
+#if NETSIM_INPROCESS
+  /* The queues and contexts must exist before the nodes are started. */
+  ether_server_init();
+  contexts = calloc(NODES_MAX, sizeof(struct node_context));
+  server_context = malloc(CONTEXT_SIZE);
+  if(contexts == NULL || server_context == NULL) {
+    perror("main: malloc");
+    exit(1);
+  }
+  node_log_init();
+  glossy_arch_init();
+#if CLOCK_CONF_VIRTUAL_TIME
+  node_set_time(0);
+#endif /* CLOCK_CONF_VIRTUAL_TIME */
+  netsim_init();
+  printf("Running %d nodes in-process, %lu bytes of globals per node\n",
+	 num_contexts, (unsigned long)CONTEXT_SIZE);
+#else /* NETSIM_INPROCESS */
   netsim_init();
   
   ether_server_init();
+#endif /* NETSIM_INPROCESS */
 
 #if 0
   while(1) {
@@ -214,7 +214,9 @@ ethernode_send(void)
   static char tmpbuf[2048];
   struct hdr *hdr = (struct hdr *)tmpbuf;
   u8_t dest;
+#if !NETSIM_INPROCESS
   struct timeval tv;
+#endif /* !NETSIM_INPROCESS */
 
   if(uip_len > sizeof(tmpbuf)) {
     PRINTF(("Ethernode_send: too large uip_len %d\n", uip_len));
@@ -225,9 +227,11 @@ ethernode_send(void)
   len = uip_len + HDR_LEN;
 
   dest = ID_BROADCAST;
+#if !NETSIM_INPROCESS
   tv.tv_sec = 0;
   tv.tv_usec = (random_rand() % 1000);
   select(0, NULL, NULL, NULL, &tv);
+#endif /* !NETSIM_INPROCESS */
 
   do_send(TYPE_DATA, dest, hdr, len);
 
@@ -263,6 +267,19 @@ PROCESS_THREAD(ethernode_process, ev, data)
   PROCESS_BEGIN();
 
   while(1) {
+#if NETSIM_INPROCESS
+    /* Polled by the simulator when packets have been queued for this
+       node, instead of busy polling the socket. */
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+
+    while(ethernode_poll()) {
+      if(receiver_callback) {
+	receiver_callback(&ethernode_driver);
+      } else {
+	ethernode_read(NULL, 0);
+      }
+    }
+#else /* NETSIM_INPROCESS */
     process_post(PROCESS_CURRENT(), PROCESS_EVENT_CONTINUE, NULL);
     PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_CONTINUE);
     
@@ -271,6 +288,7 @@ PROCESS_THREAD(ethernode_process, ev, data)
 	receiver_callback(&ethernode_driver);
       }
     }
+#endif /* NETSIM_INPROCESS */
   }
   PROCESS_END();
 }
@@ -48,4 +48,6 @@ void ethernode_set_receiver(void (* recv)(const struct radio_driver *));
 
 extern const struct radio_driver ethernode_driver;
 
+PROCESS_NAME(ethernode_process);
+
 #endif /* __ETHERNODE_H__ */
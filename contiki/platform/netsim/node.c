@@ -42,13 +42,21 @@
 
 extern in_addr_t gwaddr;
 
-static clock_time_t drift, timer;
+static clock_time_t drift;
+
+#if CLOCK_CONF_VIRTUAL_TIME
+/* Shared by the simulator and all nodes. It is allocated by the first
+   node_set_time(), before any node is started, so the pointer is the
+   same in all node contexts. */
+static clock_time_t *virtual_time;
+#else /* CLOCK_CONF_VIRTUAL_TIME */
+static clock_time_t timer;
+#endif /* CLOCK_CONF_VIRTUAL_TIME */
 
 struct node node;
 
 static int fd;
 
-static void init_node_log(void);
 
 /*------------------------------------------------------------------------------*/
 void
@@ -82,11 +90,35 @@ node_init(int id, int posx, int posy, int b)
 
   drift = rand() % 95726272;
 
-  init_node_log();
+#if !NETSIM_INPROCESS
+  node_log_init();
+#endif /* !NETSIM_INPROCESS */
 }
 /*------------------------------------------------------------------------------*/
 #include <sys/time.h>
 
+#if CLOCK_CONF_VIRTUAL_TIME
+clock_time_t
+node_time(void)
+{
+  return *virtual_time;
+}
+/*------------------------------------------------------------------------------*/
+unsigned long
+node_seconds(void)
+{
+  return *virtual_time / 1000;
+}
+/*------------------------------------------------------------------------------*/
+void
+node_set_time(clock_time_t time)
+{
+  if(virtual_time == NULL) {
+    virtual_time = malloc(sizeof(clock_time_t));
+  }
+  *virtual_time = time;
+}
+#else /* CLOCK_CONF_VIRTUAL_TIME */
 clock_time_t
 node_time(void)
 {
@@ -112,6 +144,7 @@ node_set_time(clock_time_t time)
 {
   timer = time;
 }
+#endif /* CLOCK_CONF_VIRTUAL_TIME */
 /*------------------------------------------------------------------------------*/
 int
 node_x(void)
@@ -130,8 +163,8 @@ node_y(void)
 #include <stdio.h>
 #include <unistd.h>
 
-static void
-init_node_log(void)
+void
+node_log_init(void)
 {
   fd = open("log", O_CREAT | O_WRONLY | O_APPEND, 0666);
 }
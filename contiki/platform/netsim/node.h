@@ -52,6 +52,7 @@ unsigned long node_seconds(void);
 int node_x(void);
 int node_y(void);
 
+void node_log_init(void);
 void node_log(const char *fmt, ...);
 
 
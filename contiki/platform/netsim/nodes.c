@@ -42,7 +42,9 @@
 
 static int numnodes;
 
-static struct nodes_node nodes[2000];
+/* Allocated from the heap, to keep it out of the node contexts in
+   the in-process mode. */
+static struct nodes_node *nodes;
 
 int nodes_base_node_port = 0;
 /*---------------------------------------------------------------------------*/
@@ -50,6 +52,11 @@ void
 nodes_init(void)
 {
   numnodes = 0;
+  nodes = calloc(NODES_MAX, sizeof(struct nodes_node));
+  if(nodes == NULL) {
+    perror("nodes_init: calloc");
+    exit(1);
+  }
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -70,7 +77,10 @@ nodes_kill(void)
 {
   int i;
   for(i = 0; i < numnodes; ++i) {
-    kill(nodes[i].pid, SIGTERM);
+    /* Nodes running in the simulator process have no pid. */
+    if(nodes[i].pid > 0) {
+      kill(nodes[i].pid, SIGTERM);
+    }
   }
 }
 /*---------------------------------------------------------------------------*/
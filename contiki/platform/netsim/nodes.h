@@ -38,6 +38,7 @@
 #include <sys/types.h>
 
 #define NODES_TEXTLEN 10
+#define NODES_MAX     2000
 
 void nodes_init(void);
 void nodes_add(int pid, int x, int y, int port, int id);
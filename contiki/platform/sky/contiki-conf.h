@@ -80,23 +80,28 @@
 
 #if MAC_PROTOCOL == XMAC
  #define MAC_CONF_DRIVER xmac_driver
- #define MAC_GET_PRR() xmac_get_prr()
  #define XMAC_CONF_COMPOWER 0
  #define XMAC_CONF_ANNOUNCEMENTS 0
- #define HANDSHAKES_RESET_PERIOD 20
+ // Learn the wake-up phase of neighbors from their strobe ACKs and
+ // start strobing just before the receiver wakes up
+ #define XMAC_CONF_PHASE_LOCK 1
+ // Send queued packets back-to-back while the parent stays awake,
+ // instead of strobing for each of them
+ #define XMAC_CONF_BURST 1
+ // The link estimate samples both the strobe and the data handshake
+ #define NEIGHBOR_CONF_PRR_HANDSHAKES 2
 #elif MAC_PROTOCOL == LPP
- #define MAC_GET_PRR() lpp_get_prr()
  #define MAC_CONF_DRIVER lpp_driver
  #define WITH_LPP_ANNOUNCEMENTS 0
  #define LPP_DEFAULT_ON_TIME CLOCK_SECOND/128	// 7.8 ms
  #define LPP_DEFAULT_OFF_TIME CLOCK_SECOND/8	// 125 ms
- #define HANDSHAKES_RESET_PERIOD 20
 #elif MAC_PROTOCOL == LPP_NEW
- #define MAC_GET_PRR() lpp_new_get_prr()
  #define MAC_CONF_DRIVER lpp_new_driver
- #define HANDSHAKES_RESET_PERIOD 10
  #define LPP_NEW_MAX_RANDOM_OFF_TIME RTIMER_SECOND/64 // 15.6 ms
 #endif /* MAC_PROTOCOL */
+// Link quality (per mille) towards the current parent, estimated
+// by the MAC from its recent handshakes, see neighbor_update_prr()
+#define MAC_GET_PRR() neighbor_best_prr()
 
 /* Adaptive MAC settings */
 #define GLOSSY 1
@@ -105,6 +110,13 @@
 #if QUEUING_STATS
 #define QUEUING_DELAY_RESET_PERIOD 10
 #endif /* QUEUING_STATS */
+// Send packet and Glossy reports to the controller as binary frames (1)
+// or as text lines (0), see apps/adaptive-mac/serial_frame.h. Cooja
+// batch runs parse the text lines, so build them with
+// DEFINES=SERIAL_BINARY=0.
+#ifndef SERIAL_BINARY
+#define SERIAL_BINARY 1
+#endif /* SERIAL_BINARY */
 
 #if GLOSSY
 // Set COOJA to 1 to simulate Glossy in Cooja
@@ -127,6 +139,34 @@
 #define GLOSSY_GAP              (RTIMER_SECOND / 200)  // / 100
 #define GLOSSY_N                3
 #define GLOSSY_BOOTSTRAP_PERIODS 3
+// Let the sink assign report slots in the config flood only to nodes that
+// joined, changed their parent, PRR or data rate, or have been silent for
+// GLOSSY_REFRESH_PERIODS (1), or let all nodes report in every period (0)
+#define GLOSSY_DYNAMIC_SCHEDULE 1
+#if GLOSSY_DYNAMIC_SCHEDULE
+#define GLOSSY_MAX_SLOTS        8      // each slot adds one byte to the config flood
+#define GLOSSY_MAX_NODES        64
+#define GLOSSY_REFRESH_PERIODS  10     // keep below MaximumPeriodOfSilence of the controller
+#define GLOSSY_PRR_THRESHOLD    50     // in 1/1000
+// Carry the report of a node in each of its data packets (1), so that
+// the sink only schedules Glossy slots for nodes whose packets do not
+// get through, or only in Glossy floods (0)
+#define GLOSSY_PIGGYBACK_REPORTS 1
+#endif /* GLOSSY_DYNAMIC_SCHEDULE */
+// Number of MAC parameter classes in the config flood: class 0 applies to
+// all nodes not listed in another class, so 1 gives all nodes the same
+// t_l, t_s, and n
+#define GLOSSY_MAC_CLASSES      1
+#define GLOSSY_MAC_CLASS_MEMBERS 16    // each member adds one byte to the config flood
+#if GLOSSY_MAC_CLASSES > 1
+// Fit the longest configuration line of the controller, i.e.,
+// "t_l,t_s,n," plus "t_l,t_s,n,k," per further class plus "id," per
+// member, with up to 5 digits per time, 3 per count and node id
+#define SERIAL_LINE_CONF_BUFSIZE (16 + 20 * (GLOSSY_MAC_CLASSES - 1) + 4 * GLOSSY_MAC_CLASS_MEMBERS + 1)
+#if SERIAL_LINE_CONF_BUFSIZE > 255
+#error "Configuration lines do not fit the serial line buffer"
+#endif /* SERIAL_LINE_CONF_BUFSIZE > 255 */
+#endif /* GLOSSY_MAC_CLASSES > 1 */
 // Macros useful for managing Glossy timing
 #define TIME_TO_GLOSSY          (rtimer_time_to_expire())
 #define TIME_FROM_GLOSSY        (GLOSSY_PERIOD + period_skew - TIME_TO_GLOSSY + ((rtimer_clock_t)(GLOSSY_REFERENCE_TIME + GLOSSY_PERIOD + period_skew) - TACCR0))
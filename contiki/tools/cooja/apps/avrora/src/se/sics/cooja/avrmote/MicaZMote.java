@@ -39,7 +39,7 @@ import java.util.Vector;
 import org.apache.log4j.Logger;
 import org.jdom.Element;
 
-import se.sics.cooja.Mote;
+import se.sics.cooja.EmulatedMote;
 import se.sics.cooja.MoteInterface;
 import se.sics.cooja.MoteInterfaceHandler;
 import se.sics.cooja.MoteMemory;
@@ -62,7 +62,7 @@ import avrora.sim.platform.PlatformFactory;
 /**
  * @author Joakim Eriksson, Fredrik Osterlind
  */
-public class MicaZMote implements Mote {
+public class MicaZMote implements EmulatedMote {
   private static Logger logger = Logger.getLogger(MicaZMote.class);
 
   /* 8 MHz according to Contiki config */
@@ -186,6 +186,11 @@ public class MicaZMote implements Mote {
 
   /* return false when done - e.g. true means more work to do before finished with this tick */
   private long cyclesExecuted = 0;
+
+  public long getLocalTime() {
+    return cyclesExecuted * Simulation.MILLISECOND / NR_CYCLES_PER_MSEC - usDrift;
+  }
+
   public boolean tick(long simTime) {
     if (stopNextInstruction) {
       stopNextInstruction = false;
@@ -33,6 +33,11 @@ package se.sics.mrm;
 
 import java.awt.geom.*;
 import java.util.*;
+import java.util.concurrent.Callable;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
 import javax.swing.tree.DefaultMutableTreeNode;
 import org.apache.log4j.Logger;
 import org.jdom.Element;
@@ -68,17 +73,72 @@ public class ChannelModel {
   // Ray tracing components temporary vector
   private boolean inLoggingMode = false;
   private Vector<Line2D> savedRays = null;
-  private Vector<Vector<Line2D>> calculatedVisibleSides = new Vector<Vector<Line2D>>();
-  private Vector<Point2D> calculatedVisibleSidesSources = new Vector<Point2D>();
-  private Vector<Line2D> calculatedVisibleSidesLines = new Vector<Line2D>();
-  private Vector<AngleInterval> calculatedVisibleSidesAngleIntervals = new Vector<AngleInterval>();
+
+  // Recently calculated visible sides, one cache per ray tracing thread
+  private static class VisibleSidesCache {
+    private Vector<Vector<Line2D>> visibleSides = new Vector<Vector<Line2D>>();
+    private Vector<Point2D> sources = new Vector<Point2D>();
+    private Vector<Line2D> lines = new Vector<Line2D>();
+    private Vector<AngleInterval> angleIntervals = new Vector<AngleInterval>();
+    private int generation = 0;
+
+    private void clear() {
+      visibleSides.clear();
+      sources.clear();
+      lines.clear();
+      angleIntervals.clear();
+    }
+  }
+  private ThreadLocal<VisibleSidesCache> visibleSidesCache = new ThreadLocal<VisibleSidesCache>() {
+    protected VisibleSidesCache initialValue() {
+      return new VisibleSidesCache();
+    }
+  };
   private static int maxSavedVisibleSides = 30; // Max size of lists above
 
+  // Incremented whenever obstacles or parameters change
+  private volatile int settingsGeneration = 0;
+
+  // Ray-traced path data per source and destination position
+  private static class PathKey {
+    private final double sourceX, sourceY, destX, destY;
+
+    private PathKey(double sourceX, double sourceY, double destX, double destY) {
+      this.sourceX = sourceX;
+      this.sourceY = sourceY;
+      this.destX = destX;
+      this.destY = destY;
+    }
+
+    public boolean equals(Object obj) {
+      if (!(obj instanceof PathKey)) {
+        return false;
+      }
+      PathKey k = (PathKey) obj;
+      return sourceX == k.sourceX && sourceY == k.sourceY && destX == k.destX && destY == k.destY;
+    }
+
+    public int hashCode() {
+      long h = Double.doubleToLongBits(sourceX);
+      h = 31 * h + Double.doubleToLongBits(sourceY);
+      h = 31 * h + Double.doubleToLongBits(destX);
+      h = 31 * h + Double.doubleToLongBits(destY);
+      return (int) (h ^ (h >>> 32));
+    }
+  }
+  private HashMap<PathKey, double[]> pathDataCache = new HashMap<PathKey, double[]>();
+  private static int maxCachedPaths = 1 << 20; // 1000 motes
+
   /**
    * Notifies observers when this channel model has changed settings.
    */
   private class SettingsObservable extends Observable {
     private void notifySettingsChanged() {
+      /* Same lock as getPathData() and precomputePathData() */
+      synchronized (ChannelModel.this) {
+        pathDataCache.clear();
+      }
+      settingsGeneration++;
       setChanged();
       notifyObservers();
     }
@@ -210,7 +270,9 @@ public class ChannelModel {
    * Remove all previously registered obstacles
    */
   public void removeAllObstacles() {
-    myObstacleWorld.removeAll();
+    synchronized (this) {
+      myObstacleWorld.removeAll();
+    }
     settingsObservable.notifySettingsChanged();
   }
 
@@ -238,7 +300,12 @@ public class ChannelModel {
    * @param notify If true, notifies all observers of this new obstacle
    */
   public void addRectObstacle(double startX, double startY, double width, double height, boolean notify) {
-    myObstacleWorld.addObstacle(startX, startY, width, height);
+    /* Not while paths are being ray traced or looked up */
+    synchronized (this) {
+      myObstacleWorld.addObstacle(startX, startY, width, height);
+      pathDataCache.clear();
+    }
+    settingsGeneration++;
 
     if (notify) {
       settingsObservable.notifySettingsChanged();
@@ -375,90 +442,57 @@ public class ChannelModel {
 
 
   /**
-   * Returns the subset of a given line, that is intersecting the given rectangle.
-   * This method returns null if the line does not intersect the rectangle.
-   * The given line is defined by the given (x1, y1) -> (x2, y2).
+   * Returns the length of the subset of a given line that is intersecting
+   * the given rectangle, or 0 if the line does not intersect the rectangle
+   * (or only touches it). The given line is defined by (x1, y1) -> (x2, y2).
+   *
+   * The line is clipped against the two slabs of the rectangle in
+   * parametric form, so no lines or points are allocated.
    *
    * @param x1 Line start point X
    * @param y1 Line start point Y
    * @param x2 Line end point X
-   * @param y2 Line epoint Y
+   * @param y2 Line end point Y
    * @param rectangle Rectangle which line may intersect
-   * @return Intersection line of given line and rectangle (or null)
+   * @return Length of the intersection of given line and rectangle (or 0)
    */
-  private Line2D getIntersectionLine(double x1, double y1, double x2, double y2, Rectangle2D rectangle) {
-
-    // Check if entire line is inside rectangle
-    if (rectangle.contains(x1, y1) && rectangle.contains(x2, y2)) {
-      return new Line2D.Double(x1, y1, x2, y2);
-    }
-
-    // Get rectangle and test lines
-    Line2D rectangleLower = new Line2D.Double(rectangle.getMinX(), rectangle.getMinY(), rectangle.getMaxX(), rectangle.getMinY());
-    Line2D rectangleUpper = new Line2D.Double(rectangle.getMinX(), rectangle.getMaxY(), rectangle.getMaxX(), rectangle.getMaxY());
-    Line2D rectangleLeft = new Line2D.Double(rectangle.getMinX(), rectangle.getMinY(), rectangle.getMinX(), rectangle.getMaxY());
-    Line2D rectangleRight = new Line2D.Double(rectangle.getMaxX(), rectangle.getMinY(), rectangle.getMaxX(), rectangle.getMaxY());
-    Line2D testLine = new Line2D.Double(x1, y1, x2, y2);
-
-    // Check which sides of the rectangle the test line passes through
-    Vector<Line2D> intersectedSides = new Vector<Line2D>();
-
-    if (rectangleLower.intersectsLine(testLine)) {
-      intersectedSides.add(rectangleLower);
-    }
-
-    if (rectangleUpper.intersectsLine(testLine)) {
-      intersectedSides.add(rectangleUpper);
-    }
-
-    if (rectangleLeft.intersectsLine(testLine)) {
-      intersectedSides.add(rectangleLeft);
-    }
-
-    if (rectangleRight.intersectsLine(testLine)) {
-      intersectedSides.add(rectangleRight);
-    }
-
-    // If no sides are intersected, return null (no intersection)
-    if (intersectedSides.isEmpty()) {
-      return null;
-    }
+  private static double getIntersectionLength(double x1, double y1, double x2, double y2, Rectangle2D rectangle) {
+    double dx = x2 - x1;
+    double dy = y2 - y1;
 
-    // Calculate all resulting line points (should be 2)
-    Vector<Point2D> intersectingLinePoints = new Vector<Point2D>();
+    // Part of the line, from 0 (start) to 1 (end), inside the rectangle
+    double t0 = 0, t1 = 1;
 
-    for (int i=0; i < intersectedSides.size(); i++) {
-      intersectingLinePoints.add(
-          getIntersectionPoint(testLine, intersectedSides.get(i))
-      );
+    if (dx == 0) {
+      if (x1 < rectangle.getMinX() || x1 > rectangle.getMaxX()) {
+        return 0;
+      }
+    } else {
+      double ta = (rectangle.getMinX() - x1) / dx;
+      double tb = (rectangle.getMaxX() - x1) / dx;
+      t0 = Math.max(t0, Math.min(ta, tb));
+      t1 = Math.min(t1, Math.max(ta, tb));
     }
 
-    // If only one side was intersected, one point must be inside rectangle
-    if (intersectingLinePoints.size() == 1) {
-      if (rectangle.contains(x1, y1)) {
-        intersectingLinePoints.add(new Point2D.Double(x1, y1));
-      } else if (rectangle.contains(x2, y2)) {
-        intersectingLinePoints.add(new Point2D.Double(x2, y2));
-      } else {
-        // Border case, no intersection line
-        return null;
+    if (dy == 0) {
+      if (y1 < rectangle.getMinY() || y1 > rectangle.getMaxY()) {
+        return 0;
       }
+    } else {
+      double ta = (rectangle.getMinY() - y1) / dy;
+      double tb = (rectangle.getMaxY() - y1) / dy;
+      t0 = Math.max(t0, Math.min(ta, tb));
+      t1 = Math.min(t1, Math.max(ta, tb));
     }
 
-    if (intersectingLinePoints.size() != 2) {
-      // We should have 2 line points!
-      logger.warn("Intersecting points != 2");
-      return null;
+    if (t0 >= t1) {
+      return 0;
     }
-
-    if (intersectingLinePoints.get(0).distance(intersectingLinePoints.get(1)) < 0.001) {
-      return null;
+    double length = (t1 - t0) * Math.sqrt(dx*dx + dy*dy);
+    if (length < 0.001) {
+      return 0;
     }
-
-    return new Line2D.Double(
-        intersectingLinePoints.get(0),
-        intersectingLinePoints.get(1)
-    );
+    return length;
   }
 
   /**
@@ -918,31 +952,36 @@ public class ChannelModel {
    */
   private Vector<Line2D> getAllVisibleSides(double sourceX, double sourceY, AngleInterval angleInterval, Line2D lookThrough) {
     Point2D source = new Point2D.Double(sourceX, sourceY);
+    VisibleSidesCache cache = visibleSidesCache.get();
+    if (cache.generation != settingsGeneration) {
+      cache.clear();
+      cache.generation = settingsGeneration;
+    }
 
     // Check if results were already calculated earlier
-    for (int i=0; i < calculatedVisibleSidesSources.size(); i++) {
+    for (int i=0; i < cache.sources.size(); i++) {
       if (
           // Compare sources
-          source.equals(calculatedVisibleSidesSources.get(i)) &&
+          source.equals(cache.sources.get(i)) &&
 
           // Compare angle intervals
-          (angleInterval == calculatedVisibleSidesAngleIntervals.get(i) ||
-              angleInterval != null && angleInterval.equals(calculatedVisibleSidesAngleIntervals.get(i)) ) &&
+          (angleInterval == cache.angleIntervals.get(i) ||
+              angleInterval != null && angleInterval.equals(cache.angleIntervals.get(i)) ) &&
 
               // Compare lines
-              (lookThrough == calculatedVisibleSidesLines.get(i) ||
-                  lookThrough != null && lookThrough.equals(calculatedVisibleSidesLines.get(i)) )
+              (lookThrough == cache.lines.get(i) ||
+                  lookThrough != null && lookThrough.equals(cache.lines.get(i)) )
       ) {
         // Move to top of list
-        Point2D oldSource = calculatedVisibleSidesSources.remove(i);
-        Line2D oldLine = calculatedVisibleSidesLines.remove(i);
-        AngleInterval oldAngleInterval = calculatedVisibleSidesAngleIntervals.remove(i);
-        Vector<Line2D> oldVisibleLines = calculatedVisibleSides.remove(i);
+        Point2D oldSource = cache.sources.remove(i);
+        Line2D oldLine = cache.lines.remove(i);
+        AngleInterval oldAngleInterval = cache.angleIntervals.remove(i);
+        Vector<Line2D> oldVisibleLines = cache.visibleSides.remove(i);
 
-        calculatedVisibleSidesSources.add(0, oldSource);
-        calculatedVisibleSidesLines.add(0, oldLine);
-        calculatedVisibleSidesAngleIntervals.add(0, oldAngleInterval);
-        calculatedVisibleSides.add(0, oldVisibleLines);
+        cache.sources.add(0, oldSource);
+        cache.lines.add(0, oldLine);
+        cache.angleIntervals.add(0, oldAngleInterval);
+        cache.visibleSides.add(0, oldVisibleLines);
 
         // Return old results
         return oldVisibleLines;
@@ -1287,19 +1326,19 @@ public class ChannelModel {
     } // End of outer loop
 
     // Save results in order to speed up later calculations
-    int size = calculatedVisibleSides.size();
+    int size = cache.visibleSides.size();
     // Crop saved sides vectors
     if (size >= maxSavedVisibleSides) {
-      calculatedVisibleSides.remove(size-1);
-      calculatedVisibleSidesSources.remove(size-1);
-      calculatedVisibleSidesAngleIntervals.remove(size-1);
-      calculatedVisibleSidesLines.remove(size-1);
+      cache.visibleSides.remove(size-1);
+      cache.sources.remove(size-1);
+      cache.angleIntervals.remove(size-1);
+      cache.lines.remove(size-1);
     }
 
-    calculatedVisibleSides.add(0, visibleLines);
-    calculatedVisibleSidesSources.add(0, source);
-    calculatedVisibleSidesAngleIntervals.add(0, angleInterval);
-    calculatedVisibleSidesLines.add(0, lookThrough);
+    cache.visibleSides.add(0, visibleLines);
+    cache.sources.add(0, source);
+    cache.angleIntervals.add(0, angleInterval);
+    cache.lines.add(0, lookThrough);
 
     return visibleLines;
   }
@@ -1327,9 +1366,140 @@ public class ChannelModel {
 
   // TODO Fix better data type support
   private double[] getTransmissionData(double sourceX, double sourceY, double destX, double destY, TransmissionData dataType) {
+    double[] pathData = getPathData(sourceX, sourceY, destX, destY);
+    double totalPathGain = pathData[0];
+    double delaySpread = pathData[1];
+    double delaySpreadRMS = pathData[2];
+    double accumulatedVariance = 0;
+
+    // - Calculate received power -
+    // Using formula (dB)
+    //  Received power = Output power + System gain + Transmitter gain + Path Loss + Receiver gain
+    // TODO Update formulas
+    double outputPower = getParameterDoubleValue("tx_power");
+    double systemGain = getParameterDoubleValue("system_gain_mean");
+    if (getParameterBooleanValue("apply_random")) {
+      Random random = new Random(); /* TODO Use main random generator? */
+      systemGain += Math.sqrt(getParameterDoubleValue("system_gain_var")) * random.nextGaussian();
+    } else {
+      accumulatedVariance += getParameterDoubleValue("system_gain_var");
+    }
+    double transmitterGain = getParameterDoubleValue("tx_antenna_gain"); // TODO Should depend on angle
+
+    double receivedPower = outputPower + systemGain + transmitterGain + totalPathGain;
+    if (inLoggingMode) {
+      logger.info("Resulting received signal strength:\t" + receivedPower + " (" + accumulatedVariance + ")");
+    }
+
+    if (dataType == TransmissionData.DELAY_SPREAD || dataType == TransmissionData.DELAY_SPREAD_RMS) {
+      return new double[] {delaySpread, delaySpreadRMS};
+    }
+
+    return new double[] {receivedPower, accumulatedVariance};
+  }
+
+  /**
+   * Returns the deterministic part of a transmission from the given source
+   * position to the given destination position, i.e. the ray-traced path
+   * gain and delay spreads. These only depend on the positions, the
+   * obstacles and the parameters, so they are cached per position pair
+   * until the settings change.
+   *
+   * @return [Total path gain (dB), delay spread, RMS delay spread]
+   */
+  private synchronized double[] getPathData(double sourceX, double sourceY, double destX, double destY) {
+    if (inLoggingMode) {
+      /* Rays are only saved when calculated */
+      return calculatePathData(sourceX, sourceY, destX, destY);
+    }
+    PathKey key = new PathKey(sourceX, sourceY, destX, destY);
+    double[] pathData = pathDataCache.get(key);
+    if (pathData == null) {
+      if (pathDataCache.size() >= maxCachedPaths) {
+        /* Moving motes: start over rather than growing without bounds */
+        pathDataCache.clear();
+      }
+      pathData = calculatePathData(sourceX, sourceY, destX, destY);
+      pathDataCache.put(key, pathData);
+    }
+    return pathData;
+  }
+
+  /**
+   * Calculates the path data of all pairs of the given positions that are
+   * not cached yet. The pairs are ray traced in parallel, one thread per
+   * available processor.
+   *
+   * @param positions Positions as {X, Y}
+   */
+  public synchronized void precomputePathData(final double[][] positions) {
+    long startTime = System.currentTimeMillis();
+
+    // Pairs that are not cached yet, per source
+    final Vector<Vector<PathKey>> missing = new Vector<Vector<PathKey>>();
+    int nrMissing = 0;
+    for (int i = 0; i < positions.length; i++) {
+      Vector<PathKey> keys = new Vector<PathKey>();
+      for (int j = 0; j < positions.length; j++) {
+        if (i == j) {
+          continue;
+        }
+        PathKey key = new PathKey(positions[i][0], positions[i][1], positions[j][0], positions[j][1]);
+        if (!pathDataCache.containsKey(key)) {
+          keys.add(key);
+        }
+      }
+      if (!keys.isEmpty()) {
+        missing.add(keys);
+        nrMissing += keys.size();
+      }
+    }
+    if (nrMissing == 0) {
+      return;
+    }
+    if (pathDataCache.size() + nrMissing > maxCachedPaths) {
+      pathDataCache.clear();
+    }
+
+    int nrThreads = Math.min(Runtime.getRuntime().availableProcessors(), missing.size());
+    ExecutorService executor = Executors.newFixedThreadPool(nrThreads);
+    Vector<Callable<double[][]>> tasks = new Vector<Callable<double[][]>>();
+    for (final Vector<PathKey> keys : missing) {
+      tasks.add(new Callable<double[][]>() {
+        public double[][] call() {
+          double[][] pathData = new double[keys.size()][];
+          for (int k = 0; k < keys.size(); k++) {
+            PathKey key = keys.get(k);
+            pathData[k] = calculatePathData(key.sourceX, key.sourceY, key.destX, key.destY);
+          }
+          return pathData;
+        }
+      });
+    }
+    try {
+      List<Future<double[][]>> results = executor.invokeAll(tasks);
+      for (int i = 0; i < results.size(); i++) {
+        double[][] pathData = results.get(i).get();
+        Vector<PathKey> keys = missing.get(i);
+        for (int k = 0; k < keys.size(); k++) {
+          pathDataCache.put(keys.get(k), pathData[k]);
+        }
+      }
+    } catch (InterruptedException e) {
+      logger.warn("Precomputation of path data interrupted");
+    } catch (ExecutionException e) {
+      logger.fatal("Precomputation of path data failed: " + e.getCause());
+    } finally {
+      executor.shutdown();
+    }
+
+    logger.info("Precomputed " + nrMissing + " paths between " + positions.length + " positions in " +
+        (System.currentTimeMillis() - startTime) + " ms using " + nrThreads + " threads");
+  }
+
+  private double[] calculatePathData(double sourceX, double sourceY, double destX, double destY) {
     Point2D source = new Point2D.Double(sourceX, sourceY);
     Point2D dest = new Point2D.Double(destX, destY);
-    double accumulatedVariance = 0;
 
     // - Get all ray paths from source to destination -
     RayData originRayData = new RayData(
@@ -1365,6 +1535,12 @@ public class ChannelModel {
     }
 
     // - Extract length and losses of each path -
+    // Parameters are looked up once rather than per sub path
+    double refractionCoefficient = getParameterDoubleValue("rt_refrac_coefficient");
+    double reflectionCoefficient = getParameterDoubleValue("rt_reflec_coefficient");
+    double diffractionCoefficient = getParameterDoubleValue("rt_diffr_coefficient");
+    double attenuationConstant = getParameterDoubleValue("obstacle_attenuation");
+    boolean fsplOnTotalLength = getParameterBooleanValue("rt_fspl_on_total_length");
     double[] pathLengths = new double[allPaths.size()];
     double[] pathGain = new double[allPaths.size()];
     int bestSignalNr = -1;
@@ -1375,26 +1551,26 @@ public class ChannelModel {
 
       for (int j=0; j < currentPath.getSubPathCount(); j++) {
         Line2D subPath = currentPath.getSubPath(j);
-        double subPathLength = subPath.getP1().distance(subPath.getP2());
+        double subPathLength = Point2D.distance(subPath.getX1(), subPath.getY1(), subPath.getX2(), subPath.getY2());
         RayData.RayType subPathStartType = currentPath.getType(j);
 
         // Type specific losses
         // TODO Type specific losses depends on angles as well!
         if (subPathStartType == RayData.RayType.REFRACTION) {
-          pathGain[i] += getParameterDoubleValue("rt_refrac_coefficient");
+          pathGain[i] += refractionCoefficient;
         } else if (subPathStartType == RayData.RayType.REFLECTION) {
-          pathGain[i] += getParameterDoubleValue("rt_reflec_coefficient");
+          pathGain[i] += reflectionCoefficient;
 
           // Add FSPL from last subpaths (if FSPL on individual rays)
-          if (!getParameterBooleanValue("rt_fspl_on_total_length") && accumulatedStraightLength > 0) {
+          if (!fsplOnTotalLength && accumulatedStraightLength > 0) {
             pathGain[i] += getFSPL(accumulatedStraightLength);
           }
           accumulatedStraightLength = 0; // Reset straight length
         } else if (subPathStartType == RayData.RayType.DIFFRACTION) {
-          pathGain[i] += getParameterDoubleValue("rt_diffr_coefficient");
+          pathGain[i] += diffractionCoefficient;
 
           // Add FSPL from last subpaths (if FSPL on individual rays)
-          if (!getParameterBooleanValue("rt_fspl_on_total_length") && accumulatedStraightLength > 0) {
+          if (!fsplOnTotalLength && accumulatedStraightLength > 0) {
             pathGain[i] += getFSPL(accumulatedStraightLength);
           }
           accumulatedStraightLength = 0; // Reset straight length
@@ -1404,26 +1580,22 @@ public class ChannelModel {
         // If ray starts with a refraction, calculate obstacle attenuation
         if (subPathStartType == RayData.RayType.REFRACTION) {
           // Ray passes through a wall, calculate distance through that wall
-
-          // Fetch attenuation constant
-          double attenuationConstant = getParameterDoubleValue("obstacle_attenuation");
-
           Vector<Rectangle2D> allPossibleObstacles = myObstacleWorld.getAllObstaclesNear(subPath.getP1());
 
           for (int k=0; k < allPossibleObstacles.size(); k++) {
             Rectangle2D obstacle = allPossibleObstacles.get(k);
 
             // Calculate the intersection distance
-            Line2D line = getIntersectionLine(
-                subPath.getP1().getX(),
-                subPath.getP1().getY(),
-                subPath.getP2().getX(),
-                subPath.getP2().getY(),
+            double length = getIntersectionLength(
+                subPath.getX1(),
+                subPath.getY1(),
+                subPath.getX2(),
+                subPath.getY2(),
                 obstacle
             );
 
-            if (line != null) {
-              pathGain[i] += attenuationConstant * line.getP1().distance(line.getP2());
+            if (length > 0) {
+              pathGain[i] += attenuationConstant * length;
               break;
             }
 
@@ -1436,12 +1608,12 @@ public class ChannelModel {
       }
 
       // Add FSPL from last rays (if FSPL on individual rays)
-      if (!getParameterBooleanValue("rt_fspl_on_total_length") && accumulatedStraightLength > 0) {
+      if (!fsplOnTotalLength && accumulatedStraightLength > 0) {
         pathGain[i] += getFSPL(accumulatedStraightLength);
       }
 
       // Free space path loss on total path length?
-      if (getParameterBooleanValue("rt_fspl_on_total_length")) {
+      if (fsplOnTotalLength) {
         pathGain[i] += getFSPL(pathLengths[i]);
       }
 
@@ -1505,30 +1677,7 @@ public class ChannelModel {
       logger.info("RMS Delay spread:\t" + delaySpreadRMS);
     }
 
-    // - Calculate received power -
-    // Using formula (dB)
-    //  Received power = Output power + System gain + Transmitter gain + Path Loss + Receiver gain
-    // TODO Update formulas
-    double outputPower = getParameterDoubleValue("tx_power");
-    double systemGain = getParameterDoubleValue("system_gain_mean");
-    if (getParameterBooleanValue("apply_random")) {
-      Random random = new Random(); /* TODO Use main random generator? */
-      systemGain += Math.sqrt(getParameterDoubleValue("system_gain_var")) * random.nextGaussian();
-    } else {
-      accumulatedVariance += getParameterDoubleValue("system_gain_var");
-    }
-    double transmitterGain = getParameterDoubleValue("tx_antenna_gain"); // TODO Should depend on angle
-
-    double receivedPower = outputPower + systemGain + transmitterGain + totalPathGain;
-    if (inLoggingMode) {
-      logger.info("Resulting received signal strength:\t" + receivedPower + " (" + accumulatedVariance + ")");
-    }
-
-    if (dataType == TransmissionData.DELAY_SPREAD || dataType == TransmissionData.DELAY_SPREAD_RMS) {
-      return new double[] {delaySpread, delaySpreadRMS};
-    }
-
-    return new double[] {receivedPower, accumulatedVariance};
+    return new double[] {totalPathGain, delaySpread, delaySpreadRMS};
   }
 
   /**
@@ -1542,7 +1691,7 @@ public class ChannelModel {
    * @param destY Destination position Y
    * @return All resulting rays of a simulated transmission from source to destination
    */
-  public Vector<Line2D> getRaysOfTransmission(double sourceX, double sourceY, double destX, double destY) {
+  public synchronized Vector<Line2D> getRaysOfTransmission(double sourceX, double sourceY, double destX, double destY) {
 
     // Reset current rays vector
     inLoggingMode = true;
@@ -65,6 +65,15 @@ public class MRM extends AbstractRadioMedium {
 
   private Random random = null;
 
+  /* Ray trace all links again before the next transmission,
+   * after radios were added or moved or the channel model changed */
+  private volatile boolean precomputeNeeded = true;
+  private Observer precomputeObserver = new Observer() {
+    public void update(Observable obs, Object obj) {
+      precomputeNeeded = true;
+    }
+  };
+
   /**
    * Notifies observers when this radio medium has changed settings.
    */
@@ -79,13 +88,45 @@ public class MRM extends AbstractRadioMedium {
 
     // Create the channel model
     currentChannelModel = new ChannelModel();
+    currentChannelModel.addSettingsObserver(precomputeObserver);
 
     // Register temporary plugins
     simulation.getGUI().registerTemporaryPlugin(AreaViewer.class);
     simulation.getGUI().registerTemporaryPlugin(FormulaViewer.class);
   }
 
+  public void registerRadioInterface(Radio radio, Simulation sim) {
+    super.registerRadioInterface(radio, sim);
+    if (radio != null) {
+      radio.getPosition().addObserver(precomputeObserver);
+      precomputeNeeded = true;
+    }
+  }
+
+  public void unregisterRadioInterface(Radio radio, Simulation sim) {
+    super.unregisterRadioInterface(radio, sim);
+    radio.getPosition().deleteObserver(precomputeObserver);
+  }
+
+  /**
+   * Ray traces the links between all registered radios in parallel, so that
+   * transmissions only need to add the random parts of the channel model.
+   */
+  private void precomputeChannel() {
+    Vector<Radio> radios = getRegisteredRadios();
+    double[][] positions = new double[radios.size()][];
+    for (int i = 0; i < positions.length; i++) {
+      Position pos = radios.get(i).getPosition();
+      positions[i] = new double[] { pos.getXCoordinate(), pos.getYCoordinate() };
+    }
+    currentChannelModel.precomputePathData(positions);
+  }
+
   public MRMRadioConnection createConnections(Radio sendingRadio) {
+    if (precomputeNeeded) {
+      precomputeNeeded = false;
+      precomputeChannel();
+    }
     Position sendingPosition = sendingRadio.getPosition();
     MRMRadioConnection newConnection = new MRMRadioConnection(sendingRadio);
 
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2009, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+package se.sics.mrm;
+
+import java.util.Random;
+
+/**
+ * Measures how long ChannelModel.precomputePathData() takes to ray trace
+ * all pairs of 100, 500 and 1000 motes placed at random among a fixed
+ * set of obstacles, i.e. the delay MRM adds when a simulation is loaded
+ * or motes are moved.
+ *
+ * Run with "ant benchmark", or with the mote counts as arguments:
+ * java se.sics.mrm.PrecomputeBenchmark 100 500 1000
+ */
+public class PrecomputeBenchmark {
+
+  /* Side of the square area, in meters */
+  private static final double AREA = 200;
+  private static final int OBSTACLES = 20;
+
+  public static void main(String[] args) {
+    int[] moteCounts = { 100, 500, 1000 };
+    if (args.length > 0) {
+      moteCounts = new int[args.length];
+      for (int i = 0; i < args.length; i++) {
+        moteCounts[i] = Integer.parseInt(args[i]);
+      }
+    }
+
+    System.out.println("Motes     Paths   Time [ms]  Paths/s");
+    for (int motes: moteCounts) {
+      Random random = new Random(motes);
+      ChannelModel channelModel = new ChannelModel();
+      for (int i = 0; i < OBSTACLES; i++) {
+        channelModel.addRectObstacle(random.nextDouble() * AREA, random.nextDouble() * AREA,
+            1 + random.nextDouble() * 20, 1 + random.nextDouble() * 20, false);
+      }
+
+      double[][] positions = new double[motes][2];
+      for (int i = 0; i < motes; i++) {
+        positions[i][0] = random.nextDouble() * AREA;
+        positions[i][1] = random.nextDouble() * AREA;
+      }
+
+      long start = System.nanoTime();
+      channelModel.precomputePathData(positions);
+      long millis = (System.nanoTime() - start) / 1000000;
+
+      long paths = (long) motes * (motes - 1);
+      System.out.println(String.format("%5d  %8d  %10d  %7.0f",
+          motes, paths, millis, paths * 1000.0 / Math.max(1, millis)));
+    }
+  }
+}
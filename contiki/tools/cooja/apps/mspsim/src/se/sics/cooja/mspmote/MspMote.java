@@ -44,6 +44,7 @@ import java.util.Vector;
 import org.apache.log4j.Logger;
 import org.jdom.Element;
 
+import se.sics.cooja.EmulatedMote;
 import se.sics.cooja.GUI;
 import se.sics.cooja.Mote;
 import se.sics.cooja.MoteInterface;
@@ -71,7 +72,7 @@ import se.sics.mspsim.util.MapTable;
 /**
  * @author Fredrik Osterlind
  */
-public abstract class MspMote implements Mote, WatchpointMote {
+public abstract class MspMote implements EmulatedMote, WatchpointMote {
   private static Logger logger = Logger.getLogger(MspMote.class);
 
   /* 3.900 MHz according to Contiki's speed sync loop*/
@@ -298,6 +299,11 @@ public abstract class MspMote implements Mote, WatchpointMote {
   private int[] pcHistory = new int[5];
 
   /* return false when done - e.g. true means more work to do before finished with this tick */
+  public long getLocalTime() {
+    /* The CPU may have executed past the cycle counter, see tick() */
+    return getCPU().cycles * Simulation.MILLISECOND / NR_CYCLES_PER_MSEC - usDrift;
+  }
+
   public boolean tick(long simTime) {
     if (stopNextInstruction) {
       stopNextInstruction = false;
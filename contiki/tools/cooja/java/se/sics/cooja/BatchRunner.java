@@ -0,0 +1,449 @@
+/*
+ * Copyright (c) 2009, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+package se.sics.cooja;
+
+import java.io.BufferedReader;
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.FileOutputStream;
+import java.io.FileReader;
+import java.io.FileWriter;
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.OutputStream;
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.LinkedHashMap;
+import java.util.concurrent.Callable;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import java.util.regex.Matcher;
+import java.util.regex.Pattern;
+
+import org.apache.log4j.Logger;
+
+/**
+ * Runs a matrix of simulations without GUI, several at a time.
+ *
+ * The scenario matrix is a text file of "key = value" lines:
+ * <pre>
+ * template = ptunes.csc          # simulation config, ${NAME} is substituted
+ * workers = 4                    # concurrent simulations, default #cores
+ * output = results.txt           # results file, one row per run
+ * param.Tl = 100 200 500         # parameter axes: all combinations are run
+ * param.SEED = 1 2 3
+ * build.dir = ../../../apps/adaptive-mac      # optional firmware build,
+ * build.command = make adaptive-mac.sky TARGET=sky DEFINES=TL=${Tl},SERIAL_BINARY=0
+ * build.firmware = adaptive-mac.sky
+ * </pre>
+ *
+ * Each run gets its own directory with the instantiated config, in which a
+ * separate Cooja JVM executes it using -nogui. The test script of the
+ * config (ScriptRunner) decides when a run ends, and must log the mote
+ * output to the test log. Firmware builds, if any, are made one at a time
+ * before the runs start, since they share the Contiki build directory;
+ * ${FIRMWARE} is substituted with the firmware copied into the run
+ * directory.
+ *
+ * The results file has a header line and one whitespace separated row per
+ * run, summarizing the pTunes sink output ("A o=.. seq=.. tx=.. ...") in
+ * the test log: number of nodes, received packets, end-to-end PRR, average
+ * radio duty cycle (energest) and average end-to-end latency. The sink
+ * must therefore print text lines rather than binary frames, i.e. be
+ * built with SERIAL_BINARY=0 as in the example above.
+ */
+public class BatchRunner {
+  private static Logger logger = Logger.getLogger(BatchRunner.class);
+
+  private static final Pattern SINK_OUTPUT = Pattern.compile(
+      "A o=(\\d+) seq=(\\d+) .*tx=(\\d+) rx=(\\d+) lpm=(\\d+) cpu=(\\d+)( lat=(\\d+))?");
+  private static final Pattern VARIABLE = Pattern.compile("\\$\\{(\\w+)\\}");
+
+  private File matrixFile;
+  private String[] workerArgs;
+
+  private LinkedHashMap<String, String> settings = new LinkedHashMap<String, String>();
+  private LinkedHashMap<String, String[]> axes = new LinkedHashMap<String, String[]>();
+
+  /**
+   * @param matrixFile Scenario matrix
+   * @param workerArgs Extra Cooja arguments for each run, e.g. -contiki=..
+   */
+  public BatchRunner(File matrixFile, String[] workerArgs) {
+    this.matrixFile = matrixFile;
+    this.workerArgs = workerArgs;
+  }
+
+  /**
+   * Runs all scenarios of the matrix and writes the results file.
+   *
+   * @return True if all runs completed with TEST OK
+   */
+  public boolean runBatch() throws IOException {
+    readMatrix();
+
+    File template = resolve(getSetting("template", null));
+    if (template == null || !template.exists()) {
+      throw new IOException("Simulation template not found: " + template);
+    }
+    String config = readFile(template);
+    File runsDir = resolve(getSetting("runs",
+        matrixFile.getName().replaceAll("\\.[^.]*$", "") + "_runs"));
+    File output = resolve(getSetting("output", "results.txt"));
+    int nrWorkers = Integer.parseInt(getSetting("workers",
+        "" + Runtime.getRuntime().availableProcessors()));
+
+    /* Instantiate all runs, building firmware one at a time */
+    ArrayList<HashMap<String, String>> runs = expandAxes();
+    ArrayList<File> runDirs = new ArrayList<File>();
+    for (int i=0; i < runs.size(); i++) {
+      HashMap<String, String> run = runs.get(i);
+      File runDir = new File(runsDir, "run" + i);
+      if (!runDir.isDirectory() && !runDir.mkdirs()) {
+        throw new IOException("Could not create run directory: " + runDir);
+      }
+      runDirs.add(runDir);
+
+      if (settings.containsKey("build.command")) {
+        run.put("FIRMWARE", buildFirmware(run, runDir).getAbsolutePath());
+      }
+      writeFile(new File(runDir, "sim.csc"), substitute(config, run));
+    }
+    logger.info("Running " + runs.size() + " simulations, " + nrWorkers + " at a time");
+
+    /* Execute runs */
+    ExecutorService executor = Executors.newFixedThreadPool(nrWorkers);
+    ArrayList<Future<String>> results = new ArrayList<Future<String>>();
+    for (final File runDir: runDirs) {
+      results.add(executor.submit(new Callable<String>() {
+        public String call() throws Exception {
+          return executeRun(runDir);
+        }
+      }));
+    }
+    executor.shutdown();
+
+    /* Write results, in run order */
+    boolean allOK = true;
+    StringBuilder sb = new StringBuilder();
+    sb.append("run");
+    for (String name: axes.keySet()) {
+      sb.append(' ').append(name);
+    }
+    sb.append(" status nodes packets prr duty_cycle latency\n");
+    for (int i=0; i < runs.size(); i++) {
+      String summary;
+      try {
+        summary = results.get(i).get();
+      } catch (Exception e) {
+        logger.fatal("Run " + i + " failed: " + e.getMessage(), e);
+        summary = "ERROR - - - - -";
+      }
+      if (!summary.startsWith("OK")) {
+        allOK = false;
+      }
+
+      sb.append(i);
+      for (String name: axes.keySet()) {
+        sb.append(' ').append(runs.get(i).get(name));
+      }
+      sb.append(' ').append(summary).append('\n');
+    }
+    writeFile(output, sb.toString());
+    logger.info("Results written to: " + output);
+    return allOK;
+  }
+
+  private void readMatrix() throws IOException {
+    BufferedReader reader = new BufferedReader(new FileReader(matrixFile));
+    try {
+      String line;
+      while ((line = reader.readLine()) != null) {
+        int comment = line.indexOf('#');
+        if (comment >= 0) {
+          line = line.substring(0, comment);
+        }
+        line = line.trim();
+        if (line.length() == 0) {
+          continue;
+        }
+        int eq = line.indexOf('=');
+        if (eq < 0) {
+          throw new IOException("Bad scenario matrix line: " + line);
+        }
+        String key = line.substring(0, eq).trim();
+        String value = line.substring(eq + 1).trim();
+        if (key.startsWith("param.")) {
+          axes.put(key.substring("param.".length()), value.split("\\s+"));
+        } else {
+          settings.put(key, value);
+        }
+      }
+    } finally {
+      reader.close();
+    }
+  }
+
+  /* All parameter combinations, the last axis varying fastest */
+  private ArrayList<HashMap<String, String>> expandAxes() {
+    ArrayList<HashMap<String, String>> runs = new ArrayList<HashMap<String, String>>();
+    runs.add(new HashMap<String, String>());
+    for (String name: axes.keySet()) {
+      ArrayList<HashMap<String, String>> expanded = new ArrayList<HashMap<String, String>>();
+      for (HashMap<String, String> run: runs) {
+        for (String value: axes.get(name)) {
+          HashMap<String, String> r = new HashMap<String, String>(run);
+          r.put(name, value);
+          expanded.add(r);
+        }
+      }
+      runs = expanded;
+    }
+    return runs;
+  }
+
+  private File buildFirmware(HashMap<String, String> run, File runDir)
+  throws IOException {
+    File buildDir = resolve(substitute(getSetting("build.dir", "."), run));
+    String command = substitute(settings.get("build.command"), run);
+    File firmware = new File(buildDir, substitute(getSetting("build.firmware", ""), run));
+
+    logger.info("> " + command);
+    int ret = execute(new String[] { "sh", "-c", command }, buildDir,
+        new File(runDir, "build.log"));
+    if (ret != 0 || !firmware.isFile()) {
+      throw new IOException("Firmware build failed, see " + new File(runDir, "build.log"));
+    }
+
+    File copy = new File(runDir, firmware.getName());
+    copyFile(firmware, copy);
+    return copy;
+  }
+
+  private String executeRun(File runDir) throws Exception {
+    ArrayList<String> command = new ArrayList<String>();
+    command.add(new File(System.getProperty("java.home"), "bin/java").getPath());
+    command.add("-mx512m");
+    command.add("-cp");
+    command.add(getClassPath());
+    command.add(GUI.class.getName());
+    command.add("-nogui=sim.csc");
+    for (String arg: workerArgs) {
+      command.add(arg);
+    }
+
+    long startTime = System.currentTimeMillis();
+    execute(command.toArray(new String[0]), runDir, new File(runDir, "cooja.out"));
+    logger.info("Finished " + runDir + " in " + (System.currentTimeMillis() - startTime) + " ms");
+
+    File testLog = new File(runDir, "COOJA.testlog");
+    if (!testLog.exists()) {
+      return "ERROR - - - - -";
+    }
+    return summarize(testLog);
+  }
+
+  /* Class path of this JVM with absolute entries, as runs execute in
+   * their own directories */
+  private static String getClassPath() {
+    StringBuilder sb = new StringBuilder();
+    for (String entry: System.getProperty("java.class.path").split(File.pathSeparator)) {
+      if (entry.length() == 0) {
+        continue;
+      }
+      if (sb.length() > 0) {
+        sb.append(File.pathSeparator);
+      }
+      sb.append(new File(entry).getAbsolutePath());
+    }
+    return sb.toString();
+  }
+
+  /* Summarizes the sink output of one run */
+  private static String summarize(File testLog) throws IOException {
+    boolean ok = false;
+    int packets = 0;
+    long latencySum = 0;
+    int latencyCount = 0;
+    HashMap<Integer, long[]> first = new HashMap<Integer, long[]>();
+    HashMap<Integer, long[]> last = new HashMap<Integer, long[]>();
+
+    BufferedReader reader = new BufferedReader(new FileReader(testLog));
+    try {
+      String line;
+      while ((line = reader.readLine()) != null) {
+        if (line.contains("TEST OK")) {
+          ok = true;
+        }
+        Matcher m = SINK_OUTPUT.matcher(line);
+        if (!m.find()) {
+          continue;
+        }
+        /* seq, tx, rx, lpm, cpu */
+        long[] sample = new long[5];
+        for (int i=0; i < sample.length; i++) {
+          sample[i] = Long.parseLong(m.group(i+2));
+        }
+        Integer origin = Integer.valueOf(m.group(1));
+        if (!first.containsKey(origin)) {
+          first.put(origin, sample);
+        }
+        last.put(origin, sample);
+        packets++;
+        if (m.group(8) != null) {
+          latencySum += Long.parseLong(m.group(8));
+          latencyCount++;
+        }
+      }
+    } finally {
+      reader.close();
+    }
+    if (packets == 0) {
+      logger.warn("No sink output in " + testLog + ", was the firmware built with SERIAL_BINARY=0?");
+    }
+
+    /* PRR from sequence numbers, duty cycle from energest deltas */
+    long expected = 0;
+    double dutyCycleSum = 0;
+    int dutyCycleCount = 0;
+    for (Integer origin: first.keySet()) {
+      long[] f = first.get(origin);
+      long[] l = last.get(origin);
+      expected += l[0] - f[0] + 1;
+      long radio = (l[1] - f[1]) + (l[2] - f[2]);
+      long total = (l[3] - f[3]) + (l[4] - f[4]);
+      if (total > 0) {
+        dutyCycleSum += 100.0 * radio / total;
+        dutyCycleCount++;
+      }
+    }
+
+    return (ok?"OK":"FAILED") +
+        " " + first.size() +
+        " " + packets +
+        " " + (expected > 0?String.format("%.4f", (double)packets/expected):"-") +
+        " " + (dutyCycleCount > 0?String.format("%.3f", dutyCycleSum/dutyCycleCount):"-") +
+        " " + (latencyCount > 0?String.format("%.1f", (double)latencySum/latencyCount):"-");
+  }
+
+  /* Executes command, waits for it to finish and returns its exit value */
+  private static int execute(String[] command, File dir, File outputFile)
+  throws IOException {
+    ProcessBuilder pb = new ProcessBuilder(command);
+    pb.directory(dir);
+    pb.redirectErrorStream(true);
+    Process process = pb.start();
+    OutputStream out = new FileOutputStream(outputFile);
+    try {
+      copyStream(process.getInputStream(), out);
+      return process.waitFor();
+    } catch (InterruptedException e) {
+      process.destroy();
+      throw new IOException("Interrupted: " + command[command.length-1]);
+    } finally {
+      out.close();
+    }
+  }
+
+  private String getSetting(String key, String defaultValue) {
+    String value = settings.get(key);
+    return value != null?value:defaultValue;
+  }
+
+  private File resolve(String path) {
+    if (path == null) {
+      return null;
+    }
+    File file = new File(path);
+    if (!file.isAbsolute()) {
+      file = new File(matrixFile.getAbsoluteFile().getParentFile(), path);
+    }
+    return file;
+  }
+
+  private static String substitute(String text, HashMap<String, String> values) {
+    Matcher m = VARIABLE.matcher(text);
+    StringBuffer sb = new StringBuffer();
+    while (m.find()) {
+      String value = values.get(m.group(1));
+      m.appendReplacement(sb, Matcher.quoteReplacement(value != null?value:m.group()));
+    }
+    m.appendTail(sb);
+    return sb.toString();
+  }
+
+  private static String readFile(File file) throws IOException {
+    StringBuilder sb = new StringBuilder();
+    BufferedReader reader = new BufferedReader(new FileReader(file));
+    try {
+      String line;
+      while ((line = reader.readLine()) != null) {
+        sb.append(line).append('\n');
+      }
+    } finally {
+      reader.close();
+    }
+    return sb.toString();
+  }
+
+  private static void writeFile(File file, String text) throws IOException {
+    FileWriter writer = new FileWriter(file);
+    try {
+      writer.write(text);
+    } finally {
+      writer.close();
+    }
+  }
+
+  private static void copyFile(File src, File dst) throws IOException {
+    InputStream in = new FileInputStream(src);
+    try {
+      OutputStream out = new FileOutputStream(dst);
+      try {
+        copyStream(in, out);
+      } finally {
+        out.close();
+      }
+    } finally {
+      in.close();
+    }
+  }
+
+  private static void copyStream(InputStream in, OutputStream out) throws IOException {
+    byte[] buf = new byte[4096];
+    int n;
+    while ((n = in.read(buf)) > 0) {
+      out.write(buf, 0, n);
+    }
+  }
+
+}
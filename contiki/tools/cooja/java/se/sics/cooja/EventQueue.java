@@ -38,8 +38,10 @@ import java.util.ArrayList;
  */
 public class EventQueue {
 
-  private TimeEvent first;
+  /* Binary min-heap ordered by time, then by insertion order */
+  private TimeEvent[] heap = new TimeEvent[64];
   private int eventCount = 0;
+  private long insertions = 0;
 
   /* For scheduling events from outside simulation thread effectively */
   private boolean hasUnsortedEvents = false;
@@ -89,6 +91,8 @@ public class EventQueue {
   /**
    * Should only be called from simulation thread!
    *
+   * Events with the same time are executed in the order they were added.
+   *
    * @param event Event
    */
   public void addEvent(TimeEvent event) {
@@ -96,29 +100,18 @@ public class EventQueue {
       removeFromQueue(event);
     }
 
-    if (first == null) {
-      first = event;
-    } else {
-      TimeEvent pos = first;
-      TimeEvent lastPos = first;
-      while (pos != null && pos.time <= event.time) {
-        lastPos = pos;
-        pos = pos.nextEvent;
-      }
-      // Here pos will be the first TE after event
-      // and lastPos the first before
-      if (pos == first) {
-        // Before all other
-        event.nextEvent = pos;
-        first = event;
-      } else {
-        event.nextEvent = pos;
-        lastPos.nextEvent = event;
-      }
+    if (eventCount == heap.length) {
+      TimeEvent[] grown = new TimeEvent[2 * heap.length];
+      System.arraycopy(heap, 0, grown, 0, eventCount);
+      heap = grown;
     }
+    event.order = insertions++;
     event.removed = false;
     event.queue = this;
+    heap[eventCount] = event;
+    event.heapIndex = eventCount;
     eventCount++;
+    siftUp(event.heapIndex);
   }
 
   /**
@@ -128,30 +121,68 @@ public class EventQueue {
    * @return True if event was removed
    */
   private boolean removeFromQueue(TimeEvent event) {
-    TimeEvent pos = first;
-    TimeEvent lastPos = first;
-
-    while (pos != null && pos != event) {
-      lastPos = pos;
-      pos = pos.nextEvent;
-    }
-    if (pos == null) {
+    int pos = event.heapIndex;
+    if (event.queue != this || pos < 0 || pos >= eventCount || heap[pos] != event) {
       return false;
     }
-    // pos == event!
-    if (pos == first) {
-      // remove it from first pos.
-      first = pos.nextEvent;
+    removeAt(pos);
+    return true;
+  }
+
+  private void removeAt(int pos) {
+    TimeEvent event = heap[pos];
+    eventCount--;
+    if (pos != eventCount) {
+      /* Fill the hole with the last event */
+      heap[pos] = heap[eventCount];
+      heap[pos].heapIndex = pos;
+      heap[eventCount] = null;
+      siftDown(pos);
+      siftUp(pos);
     } else {
-      // else link prev to next...
-      lastPos.nextEvent = pos.nextEvent;
+      heap[pos] = null;
     }
     // unlink
-    pos.nextEvent = null;
-
+    event.heapIndex = -1;
     event.queue = null;
-    eventCount--;
-    return true;
+  }
+
+  private static boolean before(TimeEvent a, TimeEvent b) {
+    return a.time < b.time || (a.time == b.time && a.order < b.order);
+  }
+
+  private void siftUp(int pos) {
+    TimeEvent event = heap[pos];
+    while (pos > 0) {
+      int parent = (pos - 1) >>> 1;
+      if (!before(event, heap[parent])) {
+        break;
+      }
+      heap[pos] = heap[parent];
+      heap[pos].heapIndex = pos;
+      pos = parent;
+    }
+    heap[pos] = event;
+    event.heapIndex = pos;
+  }
+
+  private void siftDown(int pos) {
+    TimeEvent event = heap[pos];
+    int half = eventCount >>> 1;
+    while (pos < half) {
+      int child = 2 * pos + 1;
+      if (child + 1 < eventCount && before(heap[child + 1], heap[child])) {
+        child++;
+      }
+      if (!before(heap[child], event)) {
+        break;
+      }
+      heap[pos] = heap[child];
+      heap[pos].heapIndex = pos;
+      pos = child;
+    }
+    heap[pos] = event;
+    event.heapIndex = pos;
   }
 
   public void removeAll() {
@@ -161,6 +192,30 @@ public class EventQueue {
     }
   }
 
+  /**
+   * Marks all scheduled events of the given mote as removed.
+   * Should only be called from simulation thread!
+   *
+   * Like the other heap operations, this does not lock; only the
+   * unsorted events are shared with other threads.
+   *
+   * @param mote Mote
+   */
+  public void removeMoteEvents(Mote mote) {
+    for (int i = 0; i < eventCount; i++) {
+      if (heap[i] instanceof MoteTimeEvent && ((MoteTimeEvent)heap[i]).getMote() == mote) {
+        heap[i].remove();
+      }
+    }
+    synchronized (this) {
+      for (TimeEvent e: unsortedEvents) {
+        if (e instanceof MoteTimeEvent && ((MoteTimeEvent)e).getMote() == mote) {
+          e.remove();
+        }
+      }
+    }
+  }
+
   /**
    * Should only be called from simulation thread!
    *
@@ -171,24 +226,17 @@ public class EventQueue {
       sortEvents();
     }
 
-    TimeEvent tmp = first;
-    if (tmp == null) {
-      return null;
-    }
-
-    first = tmp.nextEvent;
-    // Unlink.
-    tmp.nextEvent = null;
+    while (eventCount > 0) {
+      TimeEvent tmp = heap[0];
+      // No longer scheduled!
+      removeAt(0);
 
-    // No longer scheduled!
-    tmp.queue = null;
-    eventCount--;
-
-    if (tmp.removed) {
+      if (!tmp.removed) {
+        return tmp;
+      }
       /* pop and return another event instead */
-      return popFirst();
     }
-    return tmp;
+    return null;
   }
 
   public TimeEvent peekFirst() {
@@ -196,7 +244,7 @@ public class EventQueue {
       sortEvents();
     }
 
-    return first;
+    return eventCount > 0 ? heap[0] : null;
   }
 
   public String toString() {
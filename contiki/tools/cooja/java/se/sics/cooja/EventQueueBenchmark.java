@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2009, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+package se.sics.cooja;
+
+import java.util.Random;
+
+/**
+ * Measures the event throughput of the event queue with the classic
+ * hold model: the queue holds a fixed number of pending events, and
+ * each step pops the first event and schedules it again a random
+ * delay later, as a mote does with its next timer event. The binary
+ * heap of EventQueue is compared against the sorted linked list it
+ * replaced.
+ *
+ * Run with "ant benchmark", or with the pending event counts as
+ * arguments: java se.sics.cooja.EventQueueBenchmark 10 100 1000
+ */
+public class EventQueueBenchmark {
+
+  private static final int WARMUP_STEPS = 200000;
+  private static final int STEPS = 2000000;
+
+  /* Delays of the rescheduled events, in microseconds */
+  private static final int MAX_DELAY = 10000;
+
+  private static class HoldEvent extends TimeEvent {
+    public HoldEvent(long time) {
+      super(time);
+    }
+    public void execute(long t) {
+    }
+  }
+
+  /* The sorted singly linked list used before the heap */
+  private static class ListEvent {
+    long time;
+    ListEvent nextEvent;
+  }
+
+  private static class ListQueue {
+    private ListEvent first;
+
+    public void addEvent(ListEvent event) {
+      if (first == null || event.time < first.time) {
+        event.nextEvent = first;
+        first = event;
+        return;
+      }
+      ListEvent pos = first;
+      while (pos.nextEvent != null && pos.nextEvent.time <= event.time) {
+        pos = pos.nextEvent;
+      }
+      event.nextEvent = pos.nextEvent;
+      pos.nextEvent = event;
+    }
+
+    public ListEvent popFirst() {
+      ListEvent tmp = first;
+      if (tmp != null) {
+        first = tmp.nextEvent;
+        tmp.nextEvent = null;
+      }
+      return tmp;
+    }
+  }
+
+  private static long holdHeap(int pending, int steps, long seed) {
+    Random random = new Random(seed);
+    EventQueue queue = new EventQueue();
+    for (int i = 0; i < pending; i++) {
+      queue.addEvent(new HoldEvent(0), random.nextInt(MAX_DELAY));
+    }
+    long start = System.nanoTime();
+    for (int i = 0; i < steps; i++) {
+      TimeEvent event = queue.popFirst();
+      queue.addEvent(event, event.getTime() + 1 + random.nextInt(MAX_DELAY));
+    }
+    return System.nanoTime() - start;
+  }
+
+  private static long holdList(int pending, int steps, long seed) {
+    Random random = new Random(seed);
+    ListQueue queue = new ListQueue();
+    for (int i = 0; i < pending; i++) {
+      ListEvent event = new ListEvent();
+      event.time = random.nextInt(MAX_DELAY);
+      queue.addEvent(event);
+    }
+    long start = System.nanoTime();
+    for (int i = 0; i < steps; i++) {
+      ListEvent event = queue.popFirst();
+      event.time += 1 + random.nextInt(MAX_DELAY);
+      queue.addEvent(event);
+    }
+    return System.nanoTime() - start;
+  }
+
+  private static String rate(long nanos, int steps) {
+    return String.format("%12.0f", steps * 1e9 / nanos);
+  }
+
+  public static void main(String[] args) {
+    int[] pendings = { 10, 100, 500, 1000, 5000 };
+    if (args.length > 0) {
+      pendings = new int[args.length];
+      for (int i = 0; i < args.length; i++) {
+        pendings[i] = Integer.parseInt(args[i]);
+      }
+    }
+
+    System.out.println("Pending events      heap [events/s]      list [events/s]");
+    for (int pending: pendings) {
+      /* Fewer steps for long lists, where each step is O(n) */
+      int steps = pending > 1000 ? STEPS / 10 : STEPS;
+      holdHeap(pending, WARMUP_STEPS, 1);
+      holdList(pending, WARMUP_STEPS / 10, 1);
+      long heapNanos = holdHeap(pending, steps, 2);
+      long listNanos = holdList(pending, steps, 2);
+      System.out.println(String.format("%14d    ", pending) + rate(heapNanos, steps)
+          + "         " + rate(listNanos, steps));
+    }
+  }
+}
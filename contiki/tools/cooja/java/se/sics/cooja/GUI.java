@@ -3074,6 +3074,20 @@ public class GUI extends Observable {
         }
       }
       
+    } else if (args.length > 0 && args[0].startsWith("-batch=")) {
+
+      /* Run scenario matrix, each simulation in a separate -nogui JVM */
+      File matrixFile = new File(args[0].substring("-batch=".length()));
+      String[] workerArgs = new String[args.length-1];
+      System.arraycopy(args, 1, workerArgs, 0, workerArgs.length);
+      try {
+        boolean ok = new BatchRunner(matrixFile, workerArgs).runBatch();
+        System.exit(ok?0:1);
+      } catch (IOException e) {
+        logger.fatal("Batch run failed: " + e.getMessage(), e);
+        System.exit(1);
+      }
+
     } else if (args.length > 0 && args[0].startsWith("-applet")) {
 
       String tmpWebPath=null, tmpBuildPath=null, tmpEsbFirmware=null, tmpSkyFirmware=null;
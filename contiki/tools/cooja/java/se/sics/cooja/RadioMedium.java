@@ -135,6 +135,48 @@ public abstract class RadioMedium {
    */
   public abstract RadioConnection[] getLastTickConnections();
 
+  /**
+   * Returns the minimum simulated time (us) between a radio event and its
+   * first effect on any other radio, e.g. propagation plus reception delay.
+   * Emulated motes may be ticked in parallel within windows no longer than
+   * this, with their radio events deferred and taking effect this long
+   * after they were raised.
+   *
+   * @return Lookahead, or 0 if radio events cannot be deferred
+   */
+  public long getLookahead() {
+    return 0;
+  }
+
+  /**
+   * Starts or stops deferring radio events. While deferring, radio events
+   * may be raised from several threads, and are only handled by
+   * handleDeferredRadioEvents(long).
+   *
+   * @param defer True to defer radio events
+   */
+  public void setDeferRadioEvents(boolean defer) {
+  }
+
+  /**
+   * @return Time when the earliest deferred radio event takes effect, or
+   * Long.MAX_VALUE if there is none
+   */
+  public long getNextDeferredRadioEventTime() {
+    return Long.MAX_VALUE;
+  }
+
+  /**
+   * Handles the deferred radio events that take effect at or before the
+   * given time, radio by radio in registration order so that the result
+   * does not depend on thread scheduling. Must be called from the
+   * simulation thread, with the simulation time set to the given time.
+   *
+   * @param time Simulation time
+   */
+  public void handleDeferredRadioEvents(long time) {
+  }
+
   /**
    * Returns XML elements representing the current config of this radio medium.
    * This is fetched by the simulator for example when saving a simulation
@@ -110,6 +110,52 @@ public class SectionMoteMemory implements MoteMemory, AddressMemory {
     sections.add(new MoteMemorySection(address, data));
   }
 
+  /**
+   * Returns the start address of the part of a section that has been
+   * written since the last call to clearDirty().
+   *
+   * @param sectionNr
+   *          Section position
+   * @return Start address of written part, or -1 if nothing was written
+   */
+  public int getDirtyStartAddrOfSection(int sectionNr) {
+    if (sectionNr >= sections.size()) {
+      return -1;
+    }
+    MoteMemorySection section = sections.elementAt(sectionNr);
+    if (section.dirtyEnd <= section.dirtyStart) {
+      return -1;
+    }
+    return section.startAddr + section.dirtyStart;
+  }
+
+  /**
+   * Returns the size of the part of a section that has been written since
+   * the last call to clearDirty().
+   *
+   * @param sectionNr
+   *          Section position
+   * @return Size of written part
+   */
+  public int getDirtySizeOfSection(int sectionNr) {
+    if (sectionNr >= sections.size()) {
+      return 0;
+    }
+    MoteMemorySection section = sections.elementAt(sectionNr);
+    return Math.max(0, section.dirtyEnd - section.dirtyStart);
+  }
+
+  /**
+   * Marks all sections as unwritten, e.g. after the memory was copied
+   * to or from the Contiki core.
+   */
+  public void clearDirty() {
+    for (MoteMemorySection section : sections) {
+      section.dirtyStart = section.getSize();
+      section.dirtyEnd = 0;
+    }
+  }
+
   public int getTotalSize() {
     int totalSize = 0;
     for (MoteMemorySection section : sections) {
@@ -325,8 +371,13 @@ public class SectionMoteMemory implements MoteMemory, AddressMemory {
 
     private int startAddr;
 
+    /* Written part of the section, relative to startAddr */
+    private int dirtyStart;
+    private int dirtyEnd;
+
     /**
      * Create a new memory section.
+     * The entire section is marked as written.
      *
      * @param startAddr
      *          Start address of section
@@ -336,6 +387,8 @@ public class SectionMoteMemory implements MoteMemory, AddressMemory {
     public MoteMemorySection(int startAddr, byte[] data) {
       this.startAddr = startAddr;
       this.data = data;
+      this.dirtyStart = 0;
+      this.dirtyEnd = data.length;
     }
 
     /**
@@ -406,6 +459,8 @@ public class SectionMoteMemory implements MoteMemory, AddressMemory {
      */
     public void setMemorySegment(int addr, byte[] data) {
       System.arraycopy(data, 0, this.data, addr - startAddr, data.length);
+      dirtyStart = Math.min(dirtyStart, addr - startAddr);
+      dirtyEnd = Math.max(dirtyEnd, addr - startAddr + data.length);
     }
 
     public MoteMemorySection clone() {
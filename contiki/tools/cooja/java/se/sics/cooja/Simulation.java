@@ -35,6 +35,11 @@ import java.util.Observable;
 import java.util.Observer;
 import java.util.Random;
 import java.util.Vector;
+import java.util.concurrent.Callable;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
 
 import org.apache.log4j.Logger;
 import org.jdom.Element;
@@ -150,7 +155,7 @@ public class Simulation extends Observable implements Runnable {
     }
   }
 
-  private Mote[] emulatedMoteArray;
+  private EmulatedMote[] emulatedMoteArray;
   private TimeEvent tickEmulatedMotesEvent = new TimeEvent(0) {
     public void execute(long t) {
       /*logger.info("MSP motes tick at: " + t);*/
@@ -158,6 +163,13 @@ public class Simulation extends Observable implements Runnable {
         return;
       }
 
+      long lookahead = currentRadioMedium==null?0:currentRadioMedium.getLookahead();
+      if (parallelEmulatedMotes && emulatedMoteArray.length > 1 && lookahead > 0) {
+        tickEmulatedMotesParallel(t, lookahead);
+        scheduleEventUnsafe(this, t+1000);
+        return;
+      }
+
       /* Tick MSP motes */
       boolean wantMoreTicks = true;
       while (wantMoreTicks) {
@@ -229,18 +241,101 @@ public class Simulation extends Observable implements Runnable {
     }
   };
   
+  /*
+   * Parallel tick of emulated motes (PARALLEL_EMULATED_MOTES).
+   *
+   * Motes only interact via the radio medium, and a radio event cannot
+   * affect another radio until the radio medium lookahead has passed. The
+   * millisecond is therefore divided into windows that are no longer than
+   * the lookahead and that end no later than the first deferred radio event
+   * takes effect. Within a window the motes are ticked on worker threads,
+   * where the simulation time is the time of the ticked mote, and the radio
+   * medium defers their radio events. Between windows the simulation time
+   * advances to the window end, and the radio events that take effect then
+   * are handled on the simulation thread, in mote registration order,
+   * keeping the simulation deterministic.
+   *
+   * Observers of a mote and its interfaces, e.g. radio observers, run on
+   * the worker thread ticking that mote.
+   */
+  private boolean parallelEmulatedMotes = false;
+  private volatile boolean tickingInParallel = false;
+  private ThreadLocal<EmulatedMote> tickedMote = new ThreadLocal<EmulatedMote>();
+  private ExecutorService tickExecutor = null;
+
+  private void tickEmulatedMotesParallel(long t, long lookahead) {
+    int nrWorkers = Math.min(emulatedMoteArray.length, Runtime.getRuntime().availableProcessors());
+    if (tickExecutor == null) {
+      tickExecutor = Executors.newFixedThreadPool(nrWorkers);
+    }
+
+    /* Static partitioning: mote i is always ticked by task i % nrWorkers */
+    ArrayList<Callable<Object>> tasks = new ArrayList<Callable<Object>>();
+    final long[] windowEnd = new long[1];
+    for (int w=0; w < nrWorkers; w++) {
+      final int first = w;
+      final int step = nrWorkers;
+      tasks.add(new Callable<Object>() {
+        public Object call() {
+          /* Mote.tick() ticks up to one millisecond after the given time */
+          long tickTime = windowEnd[0] - MILLISECOND;
+          for (int i=first; i < emulatedMoteArray.length; i += step) {
+            tickedMote.set(emulatedMoteArray[i]);
+            while (emulatedMoteArray[i].tick(tickTime)) {
+              ;
+            }
+          }
+          tickedMote.set(null);
+          return null;
+        }
+      });
+    }
+
+    long window = t;
+    try {
+      while (window < t + MILLISECOND) {
+        /* Radio events raised in this window take effect at its end or later */
+        long end = Math.min(window + lookahead, t + MILLISECOND);
+        end = Math.min(end, currentRadioMedium.getNextDeferredRadioEventTime());
+        windowEnd[0] = Math.max(end, window + 1);
+
+        currentRadioMedium.setDeferRadioEvents(true);
+        tickingInParallel = true;
+        try {
+          for (Future<Object> f: tickExecutor.invokeAll(tasks)) {
+            f.get();
+          }
+        } catch (InterruptedException e) {
+          throw new RuntimeException("Interrupted while ticking emulated motes", e);
+        } catch (ExecutionException e) {
+          if (e.getCause() instanceof RuntimeException) {
+            throw (RuntimeException) e.getCause();
+          }
+          throw new RuntimeException("Error when ticking emulated motes", e.getCause());
+        } finally {
+          tickingInParallel = false;
+          currentRadioMedium.setDeferRadioEvents(false);
+        }
+
+        window = windowEnd[0];
+        currentSimulationTime = window;
+        currentRadioMedium.handleDeferredRadioEvents(window);
+      }
+    } finally {
+      /* Back to the time of this event, the event loop continues from it */
+      currentSimulationTime = t;
+    }
+  }
+
   private void recreateMoteLists() {
     /* Tick MSP motes separately */
-    ArrayList<Mote> emulatedMotes = new ArrayList<Mote>();
+    ArrayList<EmulatedMote> emulatedMotes = new ArrayList<EmulatedMote>();
     for (Mote mote: motes) {
-      /* TODO: fixe an emulatedMote generic class */
-      if (mote.getType().getClass().toString().contains(".mspmote.")) {
-        emulatedMotes.add(mote);
-      } else if (mote.getType().getClass().toString().contains(".avrmote.")) {
-        emulatedMotes.add(mote);
+      if (mote instanceof EmulatedMote) {
+        emulatedMotes.add((EmulatedMote) mote);
       }
     }
-    emulatedMoteArray = emulatedMotes.toArray(new Mote[emulatedMotes.size()]);
+    emulatedMoteArray = emulatedMotes.toArray(new EmulatedMote[emulatedMotes.size()]);
   }
 
   private boolean rescheduleEvents = false;
@@ -248,6 +343,12 @@ public class Simulation extends Observable implements Runnable {
     long lastStartTime = System.currentTimeMillis();
     logger.info("Simulation main loop started, system time: " + lastStartTime);
     isRunning = true;
+    parallelEmulatedMotes = Boolean.parseBoolean(
+        GUI.getExternalToolsSetting("PARALLEL_EMULATED_MOTES", "false"));
+    if (!parallelEmulatedMotes && currentRadioMedium != null) {
+      /* Radio events still deferred from an earlier parallel run */
+      currentRadioMedium.handleDeferredRadioEvents(Long.MAX_VALUE);
+    }
     
     /* Schedule tick events */
     delayLastSim = System.currentTimeMillis();
@@ -295,6 +396,10 @@ public class Simulation extends Observable implements Runnable {
     }
     isRunning = false;
     simulationThread = null;
+    if (tickExecutor != null) {
+      tickExecutor.shutdown();
+      tickExecutor = null;
+    }
     stopSimulation = false;
 
     // Notify observers simulation has stopped
@@ -655,18 +760,8 @@ public class Simulation extends Observable implements Runnable {
         setChanged();
         notifyObservers(mote);
 
-        /* Loop through all scheduled events.
-         * Delete all events associated with deleted mote. */
-        TimeEvent ev = eventQueue.peekFirst();
-        while (ev != null) {
-          if (ev instanceof MoteTimeEvent) {
-            if (((MoteTimeEvent)ev).getMote() == mote) {
-              ev.remove();
-            }
-          }
-          
-          ev = ev.nextEvent;
-        }
+        /* Delete all events associated with deleted mote. */
+        eventQueue.removeMoteEvents(mote);
         
         recreateMoteLists();
       }
@@ -864,11 +959,19 @@ public class Simulation extends Observable implements Runnable {
   }
 
   /**
-   * Returns current simulation time.
+   * Returns current simulation time. While emulated motes are ticked in
+   * parallel, this is the local time of the mote ticked by the calling
+   * thread.
    *
    * @return Simulation time (microseconds)
    */
   public long getSimulationTime() {
+    if (tickingInParallel) {
+      EmulatedMote mote = tickedMote.get();
+      if (mote != null) {
+        return mote.getLocalTime();
+      }
+    }
     return currentSimulationTime;
   }
 
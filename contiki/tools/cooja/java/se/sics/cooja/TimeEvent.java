@@ -35,8 +35,9 @@ package se.sics.cooja;
  * @author Joakim Eriksson (ported to COOJA by Fredrik Osterlind)
  */
 public abstract class TimeEvent {
-  TimeEvent nextEvent;
-  TimeEvent prevEvent;
+  /* Position in the heap of the event queue, and insertion order for ties */
+  int heapIndex = -1;
+  long order;
 
   EventQueue queue = null;
   String name;
@@ -182,6 +182,10 @@ public class ContikiMoteType implements MoteType {
   // Initial memory for all motes of this type
   private SectionMoteMemory initialMemory = null;
 
+  // Mote memory currently held by the Contiki core, equal to the core
+  // except for parts written since (see SectionMoteMemory.clearDirty)
+  private SectionMoteMemory coreMemoryOwner = null;
+
   /**
    * Creates a new uninitialized Contiki mote type. This mote type needs to load
    * a library file and parse a map file before it can be used.
@@ -483,11 +487,25 @@ public class ContikiMoteType implements MoteType {
    *          New memory
    */
   public void setCoreMemory(SectionMoteMemory mem) {
-    for (int i = 0; i < mem.getNumberOfSections(); i++) {
-      setCoreMemory(
-          mem.getStartAddrOfSection(i),
-          mem.getSizeOfSection(i), mem.getDataOfSection(i));
+    if (mem != coreMemoryOwner) {
+      for (int i = 0; i < mem.getNumberOfSections(); i++) {
+        setCoreMemory(
+            mem.getStartAddrOfSection(i),
+            mem.getSizeOfSection(i), mem.getDataOfSection(i));
+      }
+    } else {
+      /* The core still holds this memory, only copy what has been written since */
+      for (int i = 0; i < mem.getNumberOfSections(); i++) {
+        int dirtyAddr = mem.getDirtyStartAddrOfSection(i);
+        if (dirtyAddr < 0) {
+          continue;
+        }
+        int dirtySize = mem.getDirtySizeOfSection(i);
+        setCoreMemory(dirtyAddr, dirtySize, mem.getMemorySegment(dirtyAddr, dirtySize));
+      }
     }
+    mem.clearDirty();
+    coreMemoryOwner = mem;
   }
 
   /**
@@ -586,6 +604,8 @@ public class ContikiMoteType implements MoteType {
 
       getCoreMemory(startAddr, size, data);
     }
+    mem.clearDirty();
+    coreMemoryOwner = mem;
   }
 
   public String getIdentifier() {
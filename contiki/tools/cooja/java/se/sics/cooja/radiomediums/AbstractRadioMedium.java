@@ -165,206 +165,297 @@ public abstract class AbstractRadioMedium extends RadioMedium {
       }
 
       Radio radio = (Radio) obs;
+      Radio.RadioEvent event = radio.getLastEvent();
+      Object data = null;
+      RadioPacket packet = null;
+      if (event == Radio.RadioEvent.CUSTOM_DATA_TRANSMITTED) {
+        data = ((CustomDataRadio) radio).getLastCustomDataTransmitted();
+      } else if (event == Radio.RadioEvent.PACKET_TRANSMITTED) {
+        packet = radio.getLastPacketTransmitted();
+      }
 
-      // Handle radio event
-      final Radio.RadioEvent event = radio.getLastEvent();
+      if (deferRadioEvents) {
+        /* Only the thread ticking the mote of this radio adds to its list,
+         * and on that thread the simulation time is the mote's own time */
+        ArrayList<DeferredRadioEvent> events = deferredRadioEvents.get(radio);
+        if (events != null) {
+          events.add(new DeferredRadioEvent(
+              simulation.getSimulationTime() + getLookahead(), event, data, packet));
+          return;
+        }
+      }
+      handleRadioEvent(radio, event, data, packet);
+    }
+  };
 
-      // Ignore reception events
-      if (event == Radio.RadioEvent.RECEPTION_STARTED
-          || event == Radio.RadioEvent.RECEPTION_INTERFERED
-          || event == Radio.RadioEvent.RECEPTION_FINISHED) {
-        return;
+  /* Radio events raised while deferring, see RadioMedium.setDeferRadioEvents() */
+  private static class DeferredRadioEvent {
+    private final long time; /* When the event takes effect */
+    private final Radio.RadioEvent event;
+    private final Object data;
+    private final RadioPacket packet;
+
+    private DeferredRadioEvent(long time, Radio.RadioEvent event, Object data, RadioPacket packet) {
+      this.time = time;
+      this.event = event;
+      this.data = data;
+      this.packet = packet;
+    }
+  }
+  private volatile boolean deferRadioEvents = false;
+  private IdentityHashMap<Radio, ArrayList<DeferredRadioEvent>> deferredRadioEvents =
+    new IdentityHashMap<Radio, ArrayList<DeferredRadioEvent>>();
+
+  /**
+   * A receiver cannot notice a transmission before it has propagated and
+   * the receiver's radio has averaged the signal strength over it.
+   */
+  public long getLookahead() {
+    return getMinimumPropagationDelay() + RECEPTION_DELAY;
+  }
+
+  /**
+   * CC2420 RSSI (and hence CCA) averaging time, 8 symbol periods.
+   */
+  public static final long RECEPTION_DELAY = 128;
+
+  /**
+   * @return Minimum destination delay (us) of any connection this radio
+   * medium may create
+   */
+  protected long getMinimumPropagationDelay() {
+    return 0;
+  }
+
+  public void setDeferRadioEvents(boolean defer) {
+    deferRadioEvents = defer;
+  }
+
+  public long getNextDeferredRadioEventTime() {
+    long next = Long.MAX_VALUE;
+    for (Radio radio : registeredRadios) {
+      ArrayList<DeferredRadioEvent> events = deferredRadioEvents.get(radio);
+      if (!events.isEmpty() && events.get(0).time < next) {
+        next = events.get(0).time;
       }
+    }
+    return next;
+  }
 
-      if (event == Radio.RadioEvent.HW_OFF) {
-        // Destroy any(?) transfers
-        removeFromActiveConnections(radio);
+  public void handleDeferredRadioEvents(long time) {
+    for (Radio radio : registeredRadios) {
+      ArrayList<DeferredRadioEvent> events = deferredRadioEvents.get(radio);
+      int handled = 0;
+      while (handled < events.size() && events.get(handled).time <= time) {
+        DeferredRadioEvent e = events.get(handled++);
+        handleRadioEvent(radio, e.event, e.data, e.packet);
+      }
+      events.subList(0, handled).clear();
+    }
+  }
 
-        // Recalculate signal strengths on all radios
-        updateSignalStrengths();
-      } else if (event == Radio.RadioEvent.HW_ON) {
-        // No action
-        // TODO Maybe set signal strength levels now?
+  /**
+   * Handles a radio event, for example a new transmission.
+   *
+   * @param radio Radio that raised the event
+   * @param event Event
+   * @param data Custom data transmitted, if any
+   * @param packet Packet transmitted, if any
+   */
+  private void handleRadioEvent(Radio radio, final Radio.RadioEvent event, Object data, RadioPacket packet) {
+    // Ignore reception events
+    if (event == Radio.RadioEvent.RECEPTION_STARTED
+        || event == Radio.RadioEvent.RECEPTION_INTERFERED
+        || event == Radio.RadioEvent.RECEPTION_FINISHED) {
+      return;
+    }
 
-        // Recalculate signal strengths on all radios
-        updateSignalStrengths();
+    if (event == Radio.RadioEvent.HW_OFF) {
+      // Destroy any(?) transfers
+      removeFromActiveConnections(radio);
+
+      // Recalculate signal strengths on all radios
+      updateSignalStrengths();
+    } else if (event == Radio.RadioEvent.HW_ON) {
+      // No action
+      // TODO Maybe set signal strength levels now?
+
+      // Recalculate signal strengths on all radios
+      updateSignalStrengths();
 
-      } else if (event == Radio.RadioEvent.TRANSMISSION_STARTED) {
-        /* Create radio connections */
+    } else if (event == Radio.RadioEvent.TRANSMISSION_STARTED) {
+      /* Create radio connections */
+
+      RadioConnection newConnection = createConnections(radio);
+      activeConnections.add(newConnection);
+      for (Radio r: newConnection.getDestinations()) {
+        if (newConnection.getDestinationDelay(r) == 0) {
+          r.signalReceptionStart();
+        } else {
+
+          /* EXPERIMENTAL: Simulating propagation delay */
+          final Radio delayedRadio = r;
+          TimeEvent delayedEvent = new TimeEvent(0) {
+            public void execute(long t) {
+              delayedRadio.signalReceptionStart();
+            }
+          };
+          simulation.scheduleEvent(
+              delayedEvent,
+              simulation.getSimulationTime() + newConnection.getDestinationDelay(r));
+
+        }
+      }
 
-        RadioConnection newConnection = createConnections(radio);
-        activeConnections.add(newConnection);
-        for (Radio r: newConnection.getDestinations()) {
-          if (newConnection.getDestinationDelay(r) == 0) {
-            r.signalReceptionStart();
+      // Recalculate signal strengths on all radios
+      updateSignalStrengths();
+
+      /* Notify observers */
+      radioMediumObservable.setRadioMediumChanged();
+
+    } else if (event == Radio.RadioEvent.TRANSMISSION_FINISHED) {
+      /* Remove active connection */
+
+      // Find corresponding connection of radio
+      RadioConnection connection = null;
+      for (RadioConnection conn : activeConnections) {
+        if (conn.getSource() == radio) {
+          connection = conn;
+          break;
+        }
+      }
+
+      if (connection == null) {
+        logger.fatal("Can't find active connection to remove, source=" + radio);
+      } else {
+        activeConnections.remove(connection);
+        lastConnection = connection;
+        COUNTER_TX++;
+        for (Radio dstRadio : connection.getDestinations()) {
+          COUNTER_RX++;
+          if (connection.getDestinationDelay(dstRadio) == 0) {
+            dstRadio.signalReceptionEnd();
           } else {
 
             /* EXPERIMENTAL: Simulating propagation delay */
-            final Radio delayedRadio = r;
+            final Radio delayedRadio = dstRadio;
             TimeEvent delayedEvent = new TimeEvent(0) {
               public void execute(long t) {
-                delayedRadio.signalReceptionStart();
+                delayedRadio.signalReceptionEnd();
               }
             };
             simulation.scheduleEvent(
                 delayedEvent,
-                simulation.getSimulationTime() + newConnection.getDestinationDelay(r));
-
+                simulation.getSimulationTime() + connection.getDestinationDelay(dstRadio));
           }
         }
+        for (Radio dstRadio : connection.getInterfered()) {
+          COUNTER_INTERFERED++;
+          dstRadio.signalReceptionEnd();
+        }
+      }
+      
+      // Recalculate signal strengths on all radios
+      updateSignalStrengths();
 
-        // Recalculate signal strengths on all radios
-        updateSignalStrengths();
-
-        /* Notify observers */
-        radioMediumObservable.setRadioMediumChanged();
+      /* Notify observers */
+      radioMediumObservable.setRadioMediumChanged();
+      radioMediumObservable.notifyObservers();
 
-      } else if (event == Radio.RadioEvent.TRANSMISSION_FINISHED) {
-        /* Remove active connection */
+    } else if (event == Radio.RadioEvent.CUSTOM_DATA_TRANSMITTED) {
+      /* Forward custom data, if any */
 
-        // Find corresponding connection of radio
-        RadioConnection connection = null;
-        for (RadioConnection conn : activeConnections) {
-          if (conn.getSource() == radio) {
-            connection = conn;
-            break;
-          }
+      // Find corresponding connection of radio
+      RadioConnection connection = null;
+      for (RadioConnection conn : activeConnections) {
+        if (conn.getSource() == radio) {
+          connection = conn;
+          break;
         }
+      }
+      if (connection == null) {
+        logger.fatal("Can't find active connection to forward custom data in");
+        return;
+      }
 
-        if (connection == null) {
-          logger.fatal("Can't find active connection to remove, source=" + radio);
-        } else {
-          activeConnections.remove(connection);
-          lastConnection = connection;
-          COUNTER_TX++;
-          for (Radio dstRadio : connection.getDestinations()) {
-            COUNTER_RX++;
-            if (connection.getDestinationDelay(dstRadio) == 0) {
-              dstRadio.signalReceptionEnd();
-            } else {
-
-              /* EXPERIMENTAL: Simulating propagation delay */
-              final Radio delayedRadio = dstRadio;
-              TimeEvent delayedEvent = new TimeEvent(0) {
-                public void execute(long t) {
-                  delayedRadio.signalReceptionEnd();
-                }
-              };
-              simulation.scheduleEvent(
-                  delayedEvent,
-                  simulation.getSimulationTime() + connection.getDestinationDelay(dstRadio));
-            }
-          }
-          for (Radio dstRadio : connection.getInterfered()) {
-            COUNTER_INTERFERED++;
-            dstRadio.signalReceptionEnd();
-          }
-        }
-        
-        // Recalculate signal strengths on all radios
-        updateSignalStrengths();
-
-        /* Notify observers */
-        radioMediumObservable.setRadioMediumChanged();
-        radioMediumObservable.notifyObservers();
-
-      } else if (event == Radio.RadioEvent.CUSTOM_DATA_TRANSMITTED) {
-        /* Forward custom data, if any */
-
-        // Find corresponding connection of radio
-        RadioConnection connection = null;
-        for (RadioConnection conn : activeConnections) {
-          if (conn.getSource() == radio) {
-            connection = conn;
-            break;
-          }
-        }
-        if (connection == null) {
-          logger.fatal("Can't find active connection to forward custom data in");
-          return;
-        }
+      if (data == null) {
+        logger.fatal("Custom data object is null");
+        return;
+      }
 
-        Object data = ((CustomDataRadio) radio).getLastCustomDataTransmitted();
-        if (data == null) {
-          logger.fatal("Custom data object is null");
-          return;
-        }
+      for (Radio dstRadio : connection.getDestinations()) {
+        if (dstRadio instanceof CustomDataRadio) {
+          if (connection.getDestinationDelay(dstRadio) == 0) {
+            ((CustomDataRadio) dstRadio).receiveCustomData(data);
+          } else {
 
-        for (Radio dstRadio : connection.getDestinations()) {
-          if (dstRadio instanceof CustomDataRadio) {
-            if (connection.getDestinationDelay(dstRadio) == 0) {
-              ((CustomDataRadio) dstRadio).receiveCustomData(data);
-            } else {
-
-              /* EXPERIMENTAL: Simulating propagation delay */
-              final CustomDataRadio delayedRadio = (CustomDataRadio) dstRadio;
-              final Object delayedData = data;
-              TimeEvent delayedEvent = new TimeEvent(0) {
-                public void execute(long t) {
-                  delayedRadio.receiveCustomData(delayedData);
-                }
-              };
-              simulation.scheduleEvent(
-                  delayedEvent,
-                  simulation.getSimulationTime() + connection.getDestinationDelay(dstRadio));
+            /* EXPERIMENTAL: Simulating propagation delay */
+            final CustomDataRadio delayedRadio = (CustomDataRadio) dstRadio;
+            final Object delayedData = data;
+            TimeEvent delayedEvent = new TimeEvent(0) {
+              public void execute(long t) {
+                delayedRadio.receiveCustomData(delayedData);
+              }
+            };
+            simulation.scheduleEvent(
+                delayedEvent,
+                simulation.getSimulationTime() + connection.getDestinationDelay(dstRadio));
 
-            }
           }
         }
+      }
 
-      } else if (event == Radio.RadioEvent.PACKET_TRANSMITTED) {
-        /* Forward packet, if any */
-
-        // Find corresponding connection of radio
-        RadioConnection connection = null;
-        for (RadioConnection conn : activeConnections) {
-          if (conn.getSource() == radio) {
-            connection = conn;
-            break;
-          }
-        }
-        if (connection == null) {
-          logger.fatal("Can't find active connection to forward packet in");
-          return;
-        }
+    } else if (event == Radio.RadioEvent.PACKET_TRANSMITTED) {
+      /* Forward packet, if any */
 
-        RadioPacket packet = radio.getLastPacketTransmitted();
-        if (packet == null) {
-          logger.fatal("Radio packet is null");
-          return;
+      // Find corresponding connection of radio
+      RadioConnection connection = null;
+      for (RadioConnection conn : activeConnections) {
+        if (conn.getSource() == radio) {
+          connection = conn;
+          break;
         }
+      }
+      if (connection == null) {
+        logger.fatal("Can't find active connection to forward packet in");
+        return;
+      }
 
-        Radio srcRadio = connection.getSource();
-        for (Radio dstRadio : connection.getDestinations()) {
-          if (!(srcRadio instanceof CustomDataRadio) ||
-              !(dstRadio instanceof CustomDataRadio)) {
-            if (connection.getDestinationDelay(dstRadio) == 0) {
-              dstRadio.setReceivedPacket(packet);
-            } else {
-
-              /* EXPERIMENTAL: Simulating propagation delay */
-              final Radio delayedRadio = dstRadio;
-              final RadioPacket delayedPacket = packet;
-              TimeEvent delayedEvent = new TimeEvent(0) {
-                public void execute(long t) {
-                  delayedRadio.setReceivedPacket(delayedPacket);
-                }
-              };
-              simulation.scheduleEvent(
-                  delayedEvent,
-                  simulation.getSimulationTime() + connection.getDestinationDelay(dstRadio));
+      if (packet == null) {
+        logger.fatal("Radio packet is null");
+        return;
+      }
+
+      Radio srcRadio = connection.getSource();
+      for (Radio dstRadio : connection.getDestinations()) {
+        if (!(srcRadio instanceof CustomDataRadio) ||
+            !(dstRadio instanceof CustomDataRadio)) {
+          if (connection.getDestinationDelay(dstRadio) == 0) {
+            dstRadio.setReceivedPacket(packet);
+          } else {
+
+            /* EXPERIMENTAL: Simulating propagation delay */
+            final Radio delayedRadio = dstRadio;
+            final RadioPacket delayedPacket = packet;
+            TimeEvent delayedEvent = new TimeEvent(0) {
+              public void execute(long t) {
+                delayedRadio.setReceivedPacket(delayedPacket);
+              }
+            };
+            simulation.scheduleEvent(
+                delayedEvent,
+                simulation.getSimulationTime() + connection.getDestinationDelay(dstRadio));
 
-            }
           }
         }
-
-      } else if (event == Radio.RadioEvent.UNKNOWN) {
-        // Do nothing
-      } else {
-        logger.fatal("Unsupported radio event: " + event);
       }
+
+    } else if (event == Radio.RadioEvent.UNKNOWN) {
+      // Do nothing
+    } else {
+      logger.fatal("Unsupported radio event: " + event);
     }
-  };
+  }
 
   public void registerMote(Mote mote, Simulation sim) {
     registerRadioInterface(mote.getInterfaces().getRadio(), sim);
@@ -378,6 +469,7 @@ public abstract class AbstractRadioMedium extends RadioMedium {
     if (radio != null) {
       // Register and start observing radio
       registeredRadios.add(radio);
+      deferredRadioEvents.put(radio, new ArrayList<DeferredRadioEvent>());
       radio.addObserver(radioEventsObserver);
 
       // Set initial signal strength
@@ -393,6 +485,7 @@ public abstract class AbstractRadioMedium extends RadioMedium {
 
     radio.deleteObserver(radioEventsObserver);
     registeredRadios.remove(radio);
+    deferredRadioEvents.remove(radio);
 
     removeFromActiveConnections(radio);
   }
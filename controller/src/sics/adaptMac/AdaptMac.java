@@ -38,11 +38,14 @@ import java.io.OutputStreamWriter;
 import java.util.HashSet;
 import java.util.LinkedList;
 import java.util.Properties;
-import java.util.StringTokenizer;
 
 import org.apache.log4j.Logger;
 import org.apache.log4j.PropertyConfigurator;
 
+import sics.adaptMac.models.ClassSolver;
+import sics.adaptMac.models.LookupTable;
+import sics.adaptMac.models.MacModel;
+import sics.adaptMac.models.ParallelOptimizer;
 import sics.adaptMac.triggers.AbstractTrigger;
 import sics.adaptMac.triggers.AdaptiveTimedTrigger;
 import sics.adaptMac.triggers.EstimationTrigger;
@@ -65,6 +68,9 @@ public class AdaptMac {
 	
 	// Statistics logger
 	private static Logger statsLogger = Logger.getLogger("stats");
+
+	// Packet log message, only used by the topology updater thread
+	private static final StringBuilder packetLogMessage = new StringBuilder();
 	
 	// Sequence of recently seen topologies
 	private static LinkedList<Topology> topologyHistory;
@@ -75,9 +81,6 @@ public class AdaptMac {
 	// Controller start-up time: used to compute initial packet rates
 	private static final long startTime = System.currentTimeMillis() / AdaptMac.TIME_SCALE_PACKET_RATE;
 
-	// Flushes some lines from the serial buffers before the actual parsing
-	private static final int SERIAL_FLUSH_LINES = 5;
-
 	// Representation of sink node
 	private static NodeTopologyInfo sink;
 	
@@ -95,11 +98,23 @@ public class AdaptMac {
 	private static double latencyConstraint;
 	private static boolean withEstimation;
 	private static boolean withOptimizationTrigger;
+	private static boolean withNativeEstimation;
+	private static boolean estimationCrossCheck;
+	private static boolean withNativeOptimization;
+	private static boolean optimizerSpeedupReport;
+	private static int optimizationThreads;
+	private static boolean withLookupTable;
+	private static String lookupTablePath;
+	private static int macClasses;
+	private static int macClassMembers;
 	private static String eclPath;
 	private static String eclipsePath;
 	private static String serialDumpPath;
 	private static String optimizationTriggerName;
 	private static String serialPort;
+	private static String serialReader;
+	private static int ingestQueueCapacity;
+	private static String macProtocol;
 	
 	private static EstimationTrigger estimationTrigger;
 	private static AbstractTrigger optimizationTrigger;
@@ -188,22 +203,44 @@ public class AdaptMac {
 		logger.info("Started purge old topologies thread with PurgeCheckInterval " + purgeCheckInterval + " minutes");
 		
 		// Connect to serial port using serialdump
-		String connectToCom = serialDumpPath + " " + "-b" + serialDumpBaudrate + " " + serialPort;
-		BufferedWriter serialOutput = connectToCOMPort(connectToCom);
+		SpscQueue<PhaseSnapshot> ingestQueue = new SpscQueue<PhaseSnapshot>(ingestQueueCapacity);
+		BufferedWriter serialOutput;
+		if (serialReader.equals("direct")) {
+			// Read the serial port in-process
+			serialOutput = openSerialPort(ingestQueue);
+		} else {
+			// Connect to serial port using serialdump
+			String connectToCom = serialDumpPath + " " + "-b" + serialDumpBaudrate + " " + serialPort;
+			serialOutput = connectToCOMPort(connectToCom, ingestQueue);
+		}
 		logger.info("Connected to serial port");
+		startTopologyUpdater(ingestQueue);
 		
 		// Create ECLiPSe driver
 		EclipseDriver driver = new EclipseDriver(eclPath, eclipsePath);
 		
 		// Start periodic network performance estimation if selected 
 		if (withEstimation) {
-			estimationTrigger = new EstimationTrigger(driver, topologyHistory);
+			MacModel model = withNativeEstimation ? MacModel.create(macProtocol) : null;
+			estimationTrigger = new EstimationTrigger(driver, topologyHistory, model, estimationCrossCheck);
+		}
+		
+		// Solve the optimization problem natively or using ECLiPSe
+		Solver solver = driver;
+		if (withNativeOptimization) {
+			solver = new ParallelOptimizer(MacModel.create(macProtocol), optimizationThreads, optimizerSpeedupReport);
+		}
+		if (withLookupTable) {
+			solver = new LookupTable(MacModel.create(macProtocol), lookupTablePath, solver);
+		}
+		if (macClasses > 1) {
+			solver = new ClassSolver(MacModel.create(macProtocol), solver, macClasses, macClassMembers);
 		}
 		
 		// Create and start optimization trigger if selected
 		if (withOptimizationTrigger) {
 			if (optimizationTriggerName.equals("TimedTrigger")) {
-				optimizationTrigger = new TimedTrigger(driver,
+				optimizationTrigger = new TimedTrigger(solver,
 						topologyHistory,
 						optimizationInitialDelay,
 						optimizationPeriod,
@@ -212,7 +249,7 @@ public class AdaptMac {
 						reliabilityConstraint,
 						latencyConstraint);
 			} else if (optimizationTriggerName.equals("AdaptiveTimedTrigger")) {
-				optimizationTrigger = new AdaptiveTimedTrigger(driver,
+				optimizationTrigger = new AdaptiveTimedTrigger(solver,
 						topologyHistory,
 						optimizationInitialDelay,
 						optimizationRetryPeriod,
@@ -220,7 +257,7 @@ public class AdaptMac {
 						reliabilityConstraint,
 						latencyConstraint);			
 			} else if (optimizationTriggerName.equals("TimedPerformanceTrigger")) {
-				optimizationTrigger = new TimedPerformanceTrigger(driver,
+				optimizationTrigger = new TimedPerformanceTrigger(solver,
 						topologyHistory,
 						optimizationInitialDelay,
 						optimizationPeriod,
@@ -229,7 +266,7 @@ public class AdaptMac {
 						reliabilityConstraint,
 						latencyConstraint);
 			} else if (optimizationTriggerName.equals("UnifiedDataRateTrigger")) {
-				optimizationTrigger = new UnifiedDataRateTrigger(driver,
+				optimizationTrigger = new UnifiedDataRateTrigger(solver,
 						topologyHistory,
 						optimizationInitialDelay,
 						optimizationPeriod,
@@ -238,7 +275,7 @@ public class AdaptMac {
 						reliabilityConstraint,
 						latencyConstraint);
 			} else if (optimizationTriggerName.equals("InitialOptimizationTrigger")) {
-				optimizationTrigger = new InitialOptimizationTrigger(driver,
+				optimizationTrigger = new InitialOptimizationTrigger(solver,
 						topologyHistory,
 						optimizationInitialDelay,
 						serialOutput,
@@ -294,73 +331,30 @@ public class AdaptMac {
 		return s;
 	}
 	
-	/**
-	 * Parses GLOSSY message received from the sink. 
-	 * 
-	 * @param msg The Glossy message. 
-	 * @return NodeTopologyInfo object representing information about a single node.
-	 */
-	private static NodeTopologyInfo processMsg(String msg) {
-
-		StringTokenizer tokenizer = new StringTokenizer(msg, " ");
-
-		int nodeId = 0, parentId = 0, prr = 0, tl = 0, ts = 0, n = 0;
-		double pktRate = 0.0;
-		
-		// Examines the string
-		while (tokenizer.hasMoreTokens()) {
-
-			String token = tokenizer.nextToken();
-
-			if (token.startsWith("o=")) {
-				nodeId = Integer.valueOf(token.substring(token.indexOf('=') + 1));
-			} else if (token.startsWith("p=")) {
-				parentId = Integer.valueOf(token.substring(token.indexOf('=') + 1));
-			} else if (token.startsWith("pr=")) {
-				pktRate = (double) (1.0 / Double.valueOf(token.substring(token.indexOf('=') + 1)));
-			} else if (token.startsWith("prr=")) {
-				prr = Integer.valueOf(token.substring(token.indexOf('=') + 1));
-			} else if (token.startsWith("tl=")) {
-				tl = Integer.valueOf(token.substring(token.indexOf('=') + 1));
-			} else if (token.startsWith("ts=")) {
-				ts = Integer.valueOf(token.substring(token.indexOf('=') + 1));
-			} else if (token.startsWith("n=")) {
-				n = Integer.valueOf(token.substring(token.indexOf('=') + 1));
-			}
-		}
-		
-		return new NodeTopologyInfo(nodeId, parentId, pktRate, prr, new MacConfiguration(tl, ts, n));
-	}
-
 	private static void updateTopologyHistory(NodeTopologyInfo nodeInfo) {
 
 		synchronized (topologyHistory) {
 			if (!topologyHistory.isEmpty()) {
 				// Check the last known topology
 				Topology lastTopology = topologyHistory.getFirst();
-				if (!lastTopology.getNodes().contains(nodeInfo)) {
+				NodeTopologyInfo knownNodeInfo = lastTopology.getNodeInfo(nodeInfo.getNodeId());
+				if (knownNodeInfo == null) {
 					// This is a new node
 					// Create a new topology by adding the new node
 					topologyHistory.addFirst(new Topology(lastTopology,	nodeInfo));
 				} else {
-					// Check node info
-					LinkedList<NodeTopologyInfo> nodes = new LinkedList<NodeTopologyInfo>(lastTopology.getNodes());
-					NodeTopologyInfo knownNodeInfo = nodes.get(nodes.indexOf(nodeInfo));
-
 					// Topology was created less than 5 seconds ago, so we only update. Otherwise, we create a new topology.
 					if (lastTopology.getTimestamp() + 5 > System.currentTimeMillis() / AdaptMac.TIME_SCALE_PACKET_RATE) {
 /*					// Check whether the parent has changed
 					if (knownNodeInfo.getParentId() == nodeInfo.getParentId()) {
 */						// The parent hasn't changed: update node info
 						// and re-stamp topology and node
-						// PRR = 0 points to a corrupted message, so we don't update
-						if (nodeInfo.getPrr() != 0) {
-							knownNodeInfo.setPrr(nodeInfo.getPrr());
+						// PRR = 0 points to a corrupted message, so we keep the known PRR
+						if (nodeInfo.getPrr() == 0) {
+							nodeInfo.setPrr(knownNodeInfo.getPrr());
 						}
-						knownNodeInfo.setParentId(nodeInfo.getParentId());
-						knownNodeInfo.setMacConf(nodeInfo.getMacConf());
-						knownNodeInfo.setPktRate(nodeInfo.getPktRate());
-						knownNodeInfo.setTimestamp();
+						// The known node info may be shared with older topologies
+						lastTopology.update(nodeInfo);
 						
 						lastTopology.setTimestamp();
 					} else {
@@ -387,7 +381,86 @@ public class AdaptMac {
 		}
 	}
 		
-	private static BufferedWriter connectToCOMPort(String connectoToCom) {
+	/**
+	 * Processes the snapshot of one (or, if the updater fell behind,
+	 * several) Glossy phases handed over by the serial reader.
+	 * 
+	 * @param snapshot The snapshot.
+	 */
+	private static void processSnapshot(PhaseSnapshot snapshot) {
+		if (logger.isInfoEnabled()) {
+			for (int i = 0; i < snapshot.getLineCount(); i++) {
+				logger.info("SERIAL OUT: " + snapshot.getLine(i));
+			}
+		}
+		if (statsLogger.isInfoEnabled()) {
+			for (int i = 0; i < snapshot.getPacketCount(); i++) {
+				packetLogMessage.setLength(0);
+				snapshot.appendPacket(i, packetLogMessage);
+				statsLogger.info(packetLogMessage);
+			}
+		}
+		for (NodeTopologyInfo nodeInfo : snapshot.getReports()) {
+			updateTopologyHistory(nodeInfo);
+		}
+		if (snapshot.getClosedReason() != null) {
+			logger.error(snapshot.getClosedReason() + ", exiting");
+			System.exit(1);
+		}
+		collectionFinished();
+	}
+
+	private static void collectionFinished() {
+		if (!topologyHistory.isEmpty()) {
+			if (topologyHistory.getFirst().isConsistent()) {
+				statsLogger.info(generatePRRLogMessage(topologyHistory.getFirst()));
+			}
+		}
+		printCurrentTopology();
+		if (withEstimation) {
+			estimationTrigger.collectionFinished();
+		}
+		if (withOptimizationTrigger) {
+			optimizationTrigger.collectionFinished();
+		}
+	}
+
+	private static BufferedWriter openSerialPort(SpscQueue<PhaseSnapshot> ingestQueue) {
+		logger.debug("Opening serial port " + serialPort);
+		
+		try {
+			SerialPort port = new SerialPort(serialPort, serialDumpBaudrate);
+			new Thread(new SerialIngest(port.getInputStream(), ingestQueue), "serial reader").start();
+			logger.info("Started thread reading from serial port " + serialPort);
+			
+			return new BufferedWriter(new OutputStreamWriter(port.getOutputStream()));
+			
+		} catch (IOException e) {
+			logger.error("Opening serial port " + serialPort + " failed, exiting", e);
+			System.exit(1);
+		}
+		
+		return null;
+	}
+	
+	private static void startTopologyUpdater(final SpscQueue<PhaseSnapshot> ingestQueue) {
+		new Thread(new Runnable() {
+			public void run() {
+				while (true) {
+					try {
+						processSnapshot(ingestQueue.take());
+					} catch (InterruptedException e) {
+						logger.error("Error while running topology updater thread", e);
+					} catch (ArithmeticException e) {
+						logger.warn("Not enough stats have been collected for the figures to be meaningful", e); 
+					}
+				}
+			}
+		}, "topology updater").start();
+		logger.info("Started topology updater thread with IngestQueueCapacity " + ingestQueueCapacity);
+	}
+	
+	private static BufferedWriter connectToCOMPort(String connectoToCom, SpscQueue<PhaseSnapshot> ingestQueue) {
 		logger.debug("Connecting to serial port using " + connectoToCom);
 		
 		// Connect to COM using external serialdump application
@@ -395,62 +468,10 @@ public class AdaptMac {
 			String[] cmd = connectoToCom.split(" ");
 
 			Process serialDumpProcess = Runtime.getRuntime().exec(cmd);
-			final BufferedReader input = new BufferedReader(new InputStreamReader(serialDumpProcess.getInputStream()));
 			final BufferedReader err = new BufferedReader(new InputStreamReader(serialDumpProcess.getErrorStream()));
 
-			// Start thread listening on stdout
-			new Thread(new Runnable() {
-				public void run() {
-					String line;
-					try {
-						// Flushes out the first few lines in the serial buffer,
-						// this is to avoid using stale info
-						int flushLines = SERIAL_FLUSH_LINES;
-						while (flushLines > 0 && input.readLine() != null) {
-							flushLines--;
-						}
-
-						while ((line = input.readLine()) != null) {
-							// Remove all non-printable characters
-							line = line.replaceAll("[^\\p{Print}]", "");
-							logger.info("SERIAL OUT: " + line);
-							try {
-								if (line.startsWith("A")) {
-									statsLogger.info(generatePacketLogMessage(line));
-									printCurrentTopology();
-								} else if (line.startsWith("G")) {
-									updateTopologyHistory(processMsg(line));
-								} else if (line.startsWith("F")) {
-									if (!topologyHistory.isEmpty()) {
-										if (topologyHistory.getFirst().isConsistent()) {
-											statsLogger.info(generatePRRLogMessage(topologyHistory.getFirst()));
-										}
-									}
-									printCurrentTopology();
-									if (withEstimation) {
-										estimationTrigger.collectionFinished();
-									}
-									if (withOptimizationTrigger) {
-										optimizationTrigger.collectionFinished();
-									}
-								} else {
-									logger.warn("Unknown serial message");
-								}
-							} catch (ArithmeticException e) {
-								logger.warn("Not enough stats have been collected for the figures to be meaningful", e); 
-							} catch (NumberFormatException e) {
-								logger.warn("Received corrupted data from serialdump", e);
-							}
-						}
-						input.close();
-						logger.warn("Serialdump process shut down, exiting");
-						System.exit(1);
-					} catch (IOException e) {
-						logger.error("Reading from serialdump stdout failed", e);
-						System.exit(1);
-					}
-				}
-			}, "read input stream thread").start();
+			// Start thread reading from stdout
+			new Thread(new SerialIngest(serialDumpProcess.getInputStream(), ingestQueue), "serial reader").start();
 			logger.info("Started thread listening on serialdump stdout");
 			
 			// Start thread listening on stderr
@@ -519,6 +540,24 @@ public class AdaptMac {
 			optimizationRetryPeriod = Integer.parseInt(p.getProperty("OptimizationRetryPeriod"));
 			withEstimation = Boolean.parseBoolean(p.getProperty("WithEstimation"));
 			withOptimizationTrigger = Boolean.parseBoolean(p.getProperty("WithOptimizationTrigger"));
+			withNativeEstimation = Boolean.parseBoolean(p.getProperty("WithNativeEstimation", "false"));
+			estimationCrossCheck = Boolean.parseBoolean(p.getProperty("EstimationCrossCheck", "false"));
+			withNativeOptimization = Boolean.parseBoolean(p.getProperty("WithNativeOptimization", "false"));
+			optimizationThreads = Integer.parseInt(p.getProperty("OptimizationThreads", "0"));
+			optimizerSpeedupReport = Boolean.parseBoolean(p.getProperty("OptimizerSpeedupReport", "false"));
+			withLookupTable = Boolean.parseBoolean(p.getProperty("WithLookupTable", "false"));
+			lookupTablePath = p.getProperty("LookupTablePath", "lookup.tbl");
+			macClasses = Integer.parseInt(p.getProperty("MacClasses", "1"));
+			macClassMembers = Integer.parseInt(p.getProperty("MacClassMembers", "16"));
+			macProtocol = p.getProperty("MacProtocol", "XMAC");
+			if (MacModel.create(macProtocol) == null) {
+				throw new Exception("Unknown MacProtocol " + macProtocol);
+			}
+			if (withLookupTable && macProtocol.equals("XMAC")) {
+				// The nodes send bursts (XMAC_CONF_BURST), which the
+				// estimation and the other solvers model but the table does not
+				throw new Exception("WithLookupTable does not support MacProtocol XMAC");
+			}
 			eclPath = p.getProperty("EclPath");
 			if (eclPath == null) {
 				throw new Exception("EclPath not defined");
@@ -539,6 +578,11 @@ public class AdaptMac {
 			if (serialPort == null) {
 				throw new Exception("SerialPort not defined");
 			}
+			serialReader = p.getProperty("SerialReader", "serialdump");
+			if (!serialReader.equals("serialdump") && !serialReader.equals("direct")) {
+				throw new Exception("Unknown SerialReader " + serialReader);
+			}
+			ingestQueueCapacity = Integer.parseInt(p.getProperty("IngestQueueCapacity", "16"));
 		} catch (Exception e) {
 			logger.error("Parsing configuration failed, exiting", e);
 			System.exit(1);
@@ -551,6 +595,10 @@ public class AdaptMac {
 		c.append(serialDumpBaudrate);		
 		c.append("\nSerialPort = ");
 		c.append(serialPort);
+		c.append("\nSerialReader = ");
+		c.append(serialReader);
+		c.append("\nIngestQueueCapacity = ");
+		c.append(ingestQueueCapacity);
 		c.append("\nSinkId = ");
 		c.append(sinkId);
 		c.append("\nEclipsePath = ");
@@ -567,6 +615,12 @@ public class AdaptMac {
 		c.append(withEstimation);
 		c.append("\nEstimationInterval = ");
 		c.append(estimationInterval);
+		c.append("\nWithNativeEstimation = ");
+		c.append(withNativeEstimation);
+		c.append("\nEstimationCrossCheck = ");
+		c.append(estimationCrossCheck);
+		c.append("\nMacProtocol = ");
+		c.append(macProtocol);
 		c.append("\nWithOptimizationTrigger = ");
 		c.append(withOptimizationTrigger);		
 		c.append("\nOptimizationTrigger = ");
@@ -577,6 +631,20 @@ public class AdaptMac {
 		c.append(optimizationPeriod);
 		c.append("\nOptimizationRetryPeriod = ");
 		c.append(optimizationRetryPeriod);
+		c.append("\nWithNativeOptimization = ");
+		c.append(withNativeOptimization);
+		c.append("\nOptimizationThreads = ");
+		c.append(optimizationThreads);
+		c.append("\nOptimizerSpeedupReport = ");
+		c.append(optimizerSpeedupReport);
+		c.append("\nWithLookupTable = ");
+		c.append(withLookupTable);
+		c.append("\nLookupTablePath = ");
+		c.append(lookupTablePath);
+		c.append("\nMacClasses = ");
+		c.append(macClasses);
+		c.append("\nMacClassMembers = ");
+		c.append(macClassMembers);
 		c.append("\nReliabilityConstraint = ");
 		c.append(reliabilityConstraint);
 		c.append("\nLatencyConstraint = ");
@@ -588,78 +656,6 @@ public class AdaptMac {
 		System.err.println("Usage: java -jar AdaptMac.jar <configFile>");
 	}
 	
-	private static String generatePacketLogMessage(String msg) {
-		int nodeId = 0, seqNo = 0;
-		int queuing_delay = 0, dropped_packets_count = 0, queue_size = 0;
-		long t_tx = 0, t_rx = 0, t_cpu = 0, t_lpm = 0;
-		long t_glossy_tx = 0, t_glossy_rx = 0, t_glossy_cpu = 0;
-		long latency = 0;
-		
-		StringTokenizer tokenizer = new StringTokenizer(msg, " ");
-		while (tokenizer.hasMoreTokens()) {
-			String token = tokenizer.nextToken();
-
-			if (token.startsWith("o=")) {
-				nodeId = Integer.valueOf(token.substring(token.indexOf('=') + 1));
-			} else if (token.startsWith("seq=")) {
-				seqNo = Integer.valueOf(token.substring(token.indexOf('=') + 1));
-			} else if (token.startsWith("qd=")) {
-				queuing_delay = Integer.valueOf(token.substring(token.indexOf('=') + 1));
-			} else if (token.startsWith("dp=")) {
-				dropped_packets_count = Integer.valueOf(token.substring(token.indexOf('=') + 1));
-			} else if (token.startsWith("qs=")) {
-				queue_size = Integer.valueOf(token.substring(token.indexOf('=') + 1));
-			} else if (token.startsWith("tx=")) {
-				t_tx = Long.valueOf(token.substring(token.indexOf('=') + 1));
-			} else if (token.startsWith("rx=")) {
-				t_rx = Long.valueOf(token.substring(token.indexOf('=') + 1));
-			} else if (token.startsWith("cpu=")) {
-				t_cpu = Long.valueOf(token.substring(token.indexOf('=') + 1));
-			} else if (token.startsWith("lpm=")) {
-				t_lpm = Long.valueOf(token.substring(token.indexOf('=') + 1));
-			} else if (token.startsWith("lat=")) {
-				latency = Long.valueOf(token.substring(token.indexOf('=') + 1));
-			} else if (token.startsWith("gtx=")) {
-				t_glossy_tx = Long.valueOf(token.substring(token.indexOf('=') + 1));
-			} else if (token.startsWith("grx=")) {
-				t_glossy_rx = Long.valueOf(token.substring(token.indexOf('=') + 1));
-			} else if (token.startsWith("gcpu=")) {
-				t_glossy_cpu = Long.valueOf(token.substring(token.indexOf('=') + 1));
-			}
-		}
-		
-		StringBuffer buf = new StringBuffer();
-		buf.append("PACKET");
-		buf.append(" ");
-		buf.append(nodeId);
-		buf.append(" ");
-		buf.append(seqNo);
-		buf.append(" ");
-		buf.append(queuing_delay);
-		buf.append(" ");
-		buf.append(dropped_packets_count);
-		buf.append(" ");
-		buf.append(queue_size);
-		buf.append(" ");
-		buf.append(t_rx);
-		buf.append(" ");
-		buf.append(t_tx);
-		buf.append(" ");
-		buf.append(t_cpu);
-		buf.append(" ");
-		buf.append(t_lpm);
-		buf.append(" ");
-		buf.append(t_glossy_rx);
-		buf.append(" ");
-		buf.append(t_glossy_tx);
-		buf.append(" ");
-		buf.append(t_glossy_cpu);
-		buf.append(" ");
-		buf.append(latency);
-		
-		return buf.toString();
-	}
-	
 	private static String generatePRRLogMessage(Topology t) {
 		PRRStatistics s = computePRRStats(t);
 		
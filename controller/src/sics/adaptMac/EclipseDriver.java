@@ -56,7 +56,7 @@ import com.parctechnologies.eclipse.ToEclipseQueue;
  * @author Luca Mottola (luca.mottola@polimi.it)
  *
  */
-public class EclipseDriver {
+public class EclipseDriver implements Solver {
 	
 	// Controller logger
 	private static Logger logger = Logger.getLogger(EclipseDriver.class.getName());
@@ -31,6 +31,7 @@ package sics.adaptMac;
 
 import java.io.BufferedWriter;
 import java.io.IOException;
+import java.util.Arrays;
 
 import org.apache.log4j.Logger;
 
@@ -38,6 +39,12 @@ import org.apache.log4j.Logger;
  * Simple class encapsulating the MAC parameters considered
  * for adaptation using pTunes.
  * 
+ * The parameters apply to all nodes, unless the configuration holds
+ * further MAC classes: class i (from 1) then applies to the nodes
+ * listed in its members, and the base parameters (i.e., class 0) to
+ * all other nodes. The sink floods classes and members as part of the
+ * Glossy config, see GLOSSY_MAC_CLASSES in adaptive-mac.
+ * 
  * @author Marco Zimmerling (zimmerling@tik.ee.eth.ch)
  * @author Luca Mottola (luca.mottola@polimi.it)
  *
@@ -52,6 +59,11 @@ public class MacConfiguration {
 	private int ts;
 	private int n;
 
+	// MAC classes 1, 2, ... and their members, or null if all nodes
+	// use the parameters above
+	private MacConfiguration[] classes;
+	private int[][] members;
+
 	public MacConfiguration() {
 		this.tl = 0;
 		this.ts = 0;
@@ -88,12 +100,66 @@ public class MacConfiguration {
 		this.n = n;
 	}
 
+	public MacConfiguration[] getClasses() {
+		return classes;
+	}
+
+	public int[][] getMembers() {
+		return members;
+	}
+
+	/**
+	 * Sets the MAC classes beyond class 0.
+	 * 
+	 * @param classes Parameters of classes 1, 2, ..., or null.
+	 * @param members Node ids of the members of each class.
+	 */
+	public void setClasses(MacConfiguration[] classes, int[][] members) {
+		this.classes = classes;
+		this.members = members;
+	}
+
+	/**
+	 * Returns the MAC parameters that apply to the given node.
+	 */
+	public MacConfiguration forNode(int id) {
+		if (classes != null) {
+			for (int i = 0; i < classes.length; i++) {
+				for (int m : members[i]) {
+					if (m == id) {
+						return classes[i];
+					}
+				}
+			}
+		}
+		return this;
+	}
+
 	public String toString() {
-		return "MacConf: t_l=" + tl + " t_s=" + ts + " n=" + n;
+		StringBuffer buf = new StringBuffer();
+		buf.append("MacConf: t_l=" + tl + " t_s=" + ts + " n=" + n);
+		if (classes != null) {
+			for (int i = 0; i < classes.length; i++) {
+				buf.append(" class" + (i + 1) + "=(" + classes[i].tl + "," + classes[i].ts + "," + classes[i].n
+						+ ") members=" + Arrays.toString(members[i]));
+			}
+		}
+		return buf.toString();
 	}
 
 	public void inject(BufferedWriter output) throws IOException {
-		String inject = tl + "," + ts + "," + n + ",\n";
+		StringBuffer buf = new StringBuffer();
+		buf.append(tl + "," + ts + "," + n + ",");
+		if (classes != null) {
+			for (int i = 0; i < classes.length; i++) {
+				buf.append(classes[i].tl + "," + classes[i].ts + "," + classes[i].n + "," + members[i].length + ",");
+				for (int m : members[i]) {
+					buf.append(m + ",");
+				}
+			}
+		}
+		buf.append("\n");
+		String inject = buf.toString();
 		logger.info("MAC_CONFIGURATION: Injecting string " + inject);
 
 		output.write(inject);
@@ -106,6 +172,7 @@ public class MacConfiguration {
 		}
 		MacConfiguration c = (MacConfiguration) o;
 		
-		return (c.tl == this.tl && c.ts == this.ts && c.n == this.n);
+		return (c.tl == this.tl && c.ts == this.ts && c.n == this.n
+				&& Arrays.equals(c.classes, this.classes) && Arrays.deepEquals(c.members, this.members));
 	}
 }
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2013 ETH Zurich and SICS Swedish ICT 
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+package sics.adaptMac;
+
+import java.util.List;
+
+/**
+ * Persistent map from node id to NodeTopologyInfo, implemented as a
+ * 32-way trie indexed by the bits of the node id. Updates copy only
+ * the path from the root to the changed entry and share everything
+ * else with the original map, so each topology version in the history
+ * costs memory proportional to the nodes that changed. Lookups take
+ * one array access per level, that is, two levels for 8-bit node ids.
+ * 
+ * @author Marco Zimmerling (zimmerling@tik.ee.eth.ch)
+ */
+final class NodeTrie {
+
+	private static final int BITS = 5;
+	private static final int WIDTH = 1 << BITS;
+	private static final int MASK = WIDTH - 1;
+
+	static final NodeTrie EMPTY = new NodeTrie(new Object[WIDTH], 0, 0);
+
+	// Inner levels hold Object[] children, the last level NodeTopologyInfo
+	private final Object[] root;
+	private final int shift;
+	private final int size;
+
+	private NodeTrie(Object[] root, int shift, int size) {
+		this.root = root;
+		this.shift = shift;
+		this.size = size;
+	}
+
+	int size() {
+		return size;
+	}
+
+	NodeTopologyInfo get(int nodeId) {
+		if (nodeId < 0 || (nodeId >>> shift) >= WIDTH) {
+			return null;
+		}
+		Object[] node = root;
+		for (int s = shift; s > 0; s -= BITS) {
+			node = (Object[]) node[(nodeId >>> s) & MASK];
+			if (node == null) {
+				return null;
+			}
+		}
+		return (NodeTopologyInfo) node[nodeId & MASK];
+	}
+
+	/**
+	 * Returns a map that contains n in place of any previous entry with
+	 * the same node id.
+	 */
+	NodeTrie put(NodeTopologyInfo n) {
+		int nodeId = n.getNodeId();
+		if (nodeId < 0) {
+			throw new IllegalArgumentException("Negative node id " + nodeId);
+		}
+
+		// Add levels until the node id fits
+		Object[] r = root;
+		int s = shift;
+		while ((nodeId >>> s) >= WIDTH) {
+			Object[] grown = new Object[WIDTH];
+			grown[0] = r;
+			r = grown;
+			s += BITS;
+		}
+
+		Object[] newRoot = r.clone();
+		Object[] node = newRoot;
+		for (int level = s; level > 0; level -= BITS) {
+			int i = (nodeId >>> level) & MASK;
+			Object[] child = (Object[]) node[i];
+			child = (child == null) ? new Object[WIDTH] : child.clone();
+			node[i] = child;
+			node = child;
+		}
+		boolean replaced = node[nodeId & MASK] != null;
+		node[nodeId & MASK] = n;
+		return new NodeTrie(newRoot, s, replaced ? size : size + 1);
+	}
+
+	/**
+	 * Returns a map without the entry with the given node id.
+	 */
+	NodeTrie remove(int nodeId) {
+		if (get(nodeId) == null) {
+			return this;
+		}
+		Object[] newRoot = root.clone();
+		Object[] node = newRoot;
+		for (int s = shift; s > 0; s -= BITS) {
+			int i = (nodeId >>> s) & MASK;
+			Object[] child = ((Object[]) node[i]).clone();
+			node[i] = child;
+			node = child;
+		}
+		node[nodeId & MASK] = null;
+		return new NodeTrie(newRoot, shift, size - 1);
+	}
+
+	/**
+	 * Appends all entries in ascending order of node id.
+	 */
+	void addTo(List<NodeTopologyInfo> nodes) {
+		addTo(root, shift, nodes);
+	}
+
+	private static void addTo(Object[] node, int s, List<NodeTopologyInfo> nodes) {
+		for (Object o : node) {
+			if (o == null) {
+				continue;
+			}
+			if (s > 0) {
+				addTo((Object[]) o, s - BITS, nodes);
+			} else {
+				nodes.add((NodeTopologyInfo) o);
+			}
+		}
+	}
+}
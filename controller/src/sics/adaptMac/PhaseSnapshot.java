@@ -0,0 +1,182 @@
+/*
+ * Copyright 2013 ETH Zurich and SICS Swedish ICT 
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+package sics.adaptMac;
+
+import java.nio.charset.Charset;
+import java.util.ArrayList;
+
+/**
+ * Everything the sink reported in one Glossy phase, that is, between
+ * two F markers: the packet log messages and Glossy reports parsed by
+ * the serial reader, and the raw text lines for logging. If the
+ * topology updater falls behind, consecutive phases are merged into
+ * a single snapshot rather than dropped.
+ * 
+ * Packets are kept as numbers and text lines as bytes, and both are
+ * only formatted by the updater, so the serial reader does not
+ * allocate per packet or line.
+ * 
+ * @author Marco Zimmerling (zimmerling@tik.ee.eth.ch)
+ */
+public class PhaseSnapshot {
+
+	private static final Charset US_ASCII = Charset.forName("US-ASCII");
+
+	// Packets, PACKET_FIELDS values each in the order of addPacket
+	private static final int PACKET_FIELDS = 13;
+	private long[] packets = new long[16 * PACKET_FIELDS];
+	private int packetCount = 0;
+
+	// Glossy reports in the order they were received
+	private final ArrayList<NodeTopologyInfo> reports = new ArrayList<NodeTopologyInfo>();
+
+	// Text lines received from the sink, back to back, and the end of
+	// each line in lineBytes
+	private byte[] lineBytes = new byte[4096];
+	private int[] lineEnds = new int[64];
+	private int lineCount = 0;
+
+	// Number of F markers merged into this snapshot
+	private int phases = 0;
+
+	// Why the serial input ended, or null if it is still open
+	private String closedReason = null;
+
+	public void addPacket(int nodeId, int seqNo, int queuingDelay, int droppedPacketsCount, int queueSize,
+			long tTx, long tRx, long tCpu, long tLpm, long tGlossyTx, long tGlossyRx, long tGlossyCpu, long latency) {
+		int i = packetCount * PACKET_FIELDS;
+		if (i == packets.length) {
+			long[] grown = new long[2 * packets.length];
+			System.arraycopy(packets, 0, grown, 0, packets.length);
+			packets = grown;
+		}
+		packets[i++] = nodeId;
+		packets[i++] = seqNo;
+		packets[i++] = queuingDelay;
+		packets[i++] = droppedPacketsCount;
+		packets[i++] = queueSize;
+		packets[i++] = tRx;
+		packets[i++] = tTx;
+		packets[i++] = tCpu;
+		packets[i++] = tLpm;
+		packets[i++] = tGlossyRx;
+		packets[i++] = tGlossyTx;
+		packets[i++] = tGlossyCpu;
+		packets[i++] = latency;
+		packetCount++;
+	}
+
+	public void addReport(NodeTopologyInfo nodeInfo) {
+		reports.add(nodeInfo);
+	}
+
+	/**
+	 * Adds a text line by copying its bytes, so the caller may reuse
+	 * its buffer.
+	 * 
+	 * @param line Buffer holding the line.
+	 * @param length Length of the line.
+	 */
+	public void addLine(byte[] line, int length) {
+		int start = lineCount > 0 ? lineEnds[lineCount - 1] : 0;
+		if (start + length > lineBytes.length) {
+			byte[] grown = new byte[Math.max(2 * lineBytes.length, start + length)];
+			System.arraycopy(lineBytes, 0, grown, 0, start);
+			lineBytes = grown;
+		}
+		if (lineCount == lineEnds.length) {
+			int[] grown = new int[2 * lineEnds.length];
+			System.arraycopy(lineEnds, 0, grown, 0, lineCount);
+			lineEnds = grown;
+		}
+		System.arraycopy(line, 0, lineBytes, start, length);
+		lineEnds[lineCount++] = start + length;
+	}
+
+	public void phaseFinished() {
+		phases++;
+	}
+
+	public int getPacketCount() {
+		return packetCount;
+	}
+
+	/**
+	 * Appends the log message of a packet, i.e., "PACKET" followed by
+	 * node id, sequence number, queuing delay, dropped packets, queue
+	 * size, rx, tx, cpu, lpm, Glossy rx, tx, cpu, and latency.
+	 * 
+	 * @param index Index of the packet, from 0 to getPacketCount() - 1.
+	 * @param buf Buffer to append to.
+	 */
+	public void appendPacket(int index, StringBuilder buf) {
+		buf.append("PACKET");
+		for (int i = index * PACKET_FIELDS; i < (index + 1) * PACKET_FIELDS; i++) {
+			buf.append(' ');
+			buf.append(packets[i]);
+		}
+	}
+
+	public ArrayList<NodeTopologyInfo> getReports() {
+		return reports;
+	}
+
+	public int getLineCount() {
+		return lineCount;
+	}
+
+	/**
+	 * Returns a text line as a new string.
+	 * 
+	 * @param index Index of the line, from 0 to getLineCount() - 1.
+	 */
+	public String getLine(int index) {
+		int start = index > 0 ? lineEnds[index - 1] : 0;
+		return new String(lineBytes, start, lineEnds[index] - start, US_ASCII);
+	}
+
+	public int getPhases() {
+		return phases;
+	}
+
+	/**
+	 * Marks this as the last snapshot, after which the serial input ended.
+	 */
+	public void inputClosed(String reason) {
+		closedReason = reason;
+	}
+
+	/**
+	 * Why the serial input ended after this snapshot, or null if it did not.
+	 */
+	public String getClosedReason() {
+		return closedReason;
+	}
+}
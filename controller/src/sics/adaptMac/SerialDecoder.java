@@ -0,0 +1,291 @@
+/*
+ * Copyright 2013 ETH Zurich and SICS Swedish ICT 
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+package sics.adaptMac;
+
+import java.io.BufferedInputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.nio.charset.Charset;
+
+/**
+ * Decodes the output of the sink as forwarded by serialdump. The sink
+ * either prints text lines or sends binary frames of the form
+ * 
+ *   SYNC | type | length | payload | CRC16
+ * 
+ * (see contiki/apps/adaptive-mac/serial_frame.h), and both may be
+ * interleaved. Decoding a frame does not allocate: the fields of the
+ * last frame are read from an internal buffer through the getters,
+ * and neither does a text line: its bytes stay in the line buffer
+ * until the next call to next().
+ * 
+ * @author Marco Zimmerling (zimmerling@tik.ee.eth.ch)
+ */
+public class SerialDecoder {
+
+	// Result of next()
+	public static final int EOF = -1;
+	public static final int TEXT = 0;
+	public static final int PACKET = 'A';
+	public static final int REPORT = 'G';
+	public static final int FINISHED = 'F';
+
+	// Framing, see serial_frame.h
+	private static final int SYNC = 0x01;
+	private static final int MAX_LENGTH = 64;
+	private static final int MAX_LINE_LENGTH = 512;
+
+	// Payload lengths per frame type
+	private static final int PACKET_LENGTH = 45;
+	private static final int REPORT_LENGTH = 11;
+	private static final int FINISHED_LENGTH = 0;
+	private static final Charset US_ASCII = Charset.forName("US-ASCII");
+
+	private final InputStream in;
+	private final byte[] payload = new byte[MAX_LENGTH];
+	private final byte[] line = new byte[MAX_LINE_LENGTH];
+	private int lineLength;
+	private int textLength;
+	private long corruptFrames;
+
+	public SerialDecoder(InputStream in) {
+		this.in = new BufferedInputStream(in);
+		this.lineLength = 0;
+		this.corruptFrames = 0;
+	}
+
+	/**
+	 * Reads the next message from the serial line.
+	 * 
+	 * @return The type of the message (TEXT, PACKET, REPORT, or FINISHED), or
+	 * EOF at the end of the stream.
+	 */
+	public int next() throws IOException {
+		int b;
+		while ((b = in.read()) != -1) {
+			if (b == SYNC) {
+				in.mark(MAX_LENGTH + 4);
+				int type = readFrame();
+				if (type != EOF) {
+					return type;
+				}
+				// Not a valid frame: the SYNC byte was part of the text,
+				// so continue right after it
+				corruptFrames++;
+				in.reset();
+			} else if (b == '\n') {
+				textLength = lineLength;
+				lineLength = 0;
+				return TEXT;
+			} else if (lineLength < MAX_LINE_LENGTH) {
+				line[lineLength++] = (byte) b;
+			}
+		}
+		return EOF;
+	}
+
+	/**
+	 * Reads the frame after a SYNC byte into the payload buffer.
+	 * 
+	 * @return The type of the frame, or EOF if it is invalid or incomplete.
+	 */
+	private int readFrame() throws IOException {
+		int type = in.read();
+		int length = in.read();
+		if (type == -1 || length == -1 || length != expectedLength(type)) {
+			return EOF;
+		}
+		int crc = crc16Add(type, 0);
+		crc = crc16Add(length, crc);
+		for (int i = 0; i < length; i++) {
+			int b = in.read();
+			if (b == -1) {
+				return EOF;
+			}
+			payload[i] = (byte) b;
+			crc = crc16Add(b, crc);
+		}
+		int crcLow = in.read();
+		int crcHigh = in.read();
+		if (crcLow == -1 || crcHigh == -1 || ((crcHigh << 8) | crcLow) != crc) {
+			return EOF;
+		}
+		return type;
+	}
+
+	private static int expectedLength(int type) {
+		switch (type) {
+		case PACKET:
+			return PACKET_LENGTH;
+		case REPORT:
+			return REPORT_LENGTH;
+		case FINISHED:
+			return FINISHED_LENGTH;
+		default:
+			return -1;
+		}
+	}
+
+	/**
+	 * Port of crc16_add in contiki/core/lib/crc16.c.
+	 */
+	private static int crc16Add(int b, int acc) {
+		acc ^= b & 0xff;
+		acc = ((acc >> 8) | (acc << 8)) & 0xffff;
+		acc ^= ((acc & 0xff00) << 4) & 0xffff;
+		acc ^= (acc >> 8) >> 4;
+		acc ^= (acc & 0xff00) >> 5;
+		return acc & 0xffff;
+	}
+
+	private int u8(int offset) {
+		return payload[offset] & 0xff;
+	}
+
+	private int u16(int offset) {
+		return u8(offset) | (u8(offset + 1) << 8);
+	}
+
+	private long u32(int offset) {
+		return (long) u16(offset) | ((long) u16(offset + 2) << 16);
+	}
+
+	/**
+	 * Buffer holding the text line of the last TEXT message, without the
+	 * newline, in its first getLineLength() bytes. Only valid until the
+	 * next call to next().
+	 */
+	public byte[] getLine() {
+		return line;
+	}
+
+	public int getLineLength() {
+		return textLength;
+	}
+
+	/**
+	 * Text line of the last TEXT message, without the newline. Unlike
+	 * getLine(), this builds a new string on every call.
+	 */
+	public String getText() {
+		return new String(line, 0, textLength, US_ASCII);
+	}
+
+	/**
+	 * Number of SYNC bytes that did not start a valid frame so far.
+	 */
+	public long getCorruptFrames() {
+		return corruptFrames;
+	}
+
+	// Fields of the last PACKET message, see print_process in adaptive-mac.c
+
+	public int getPacketNodeId() {
+		return u8(0);
+	}
+
+	public int getPacketSeqNo() {
+		return u16(1);
+	}
+
+	public int getQueuingDelay() {
+		return u16(3);
+	}
+
+	public int getDroppedPacketsCount() {
+		return u16(5);
+	}
+
+	public int getQueueSize() {
+		return u8(7);
+	}
+
+	public long getTimeTx() {
+		return u32(8);
+	}
+
+	public long getTimeRx() {
+		return u32(12);
+	}
+
+	public long getTimeLpm() {
+		return u32(16);
+	}
+
+	public long getTimeCpu() {
+		return u32(20);
+	}
+
+	public long getLatency() {
+		return u32(24);
+	}
+
+	public long getGlossyTimeTx() {
+		return u32(33);
+	}
+
+	public long getGlossyTimeRx() {
+		return u32(37);
+	}
+
+	public long getGlossyTimeCpu() {
+		return u32(41);
+	}
+
+	// Fields of the last REPORT message, see glossy_print_report_process in glossy_interface.h
+
+	public int getReportNodeId() {
+		return u8(0);
+	}
+
+	public int getReportParentId() {
+		return u8(1);
+	}
+
+	public int getReportPktRate() {
+		return u16(2);
+	}
+
+	public int getReportPrr() {
+		return u16(4);
+	}
+
+	public int getReportTl() {
+		return u16(6);
+	}
+
+	public int getReportTs() {
+		return u16(8);
+	}
+
+	public int getReportN() {
+		return u8(10);
+	}
+}
@@ -0,0 +1,336 @@
+/*
+ * Copyright 2013 ETH Zurich and SICS Swedish ICT 
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+package sics.adaptMac;
+
+import java.io.IOException;
+import java.io.InputStream;
+
+import org.apache.log4j.Logger;
+
+/**
+ * Reads the output of the sink, parses it into records, and hands
+ * one PhaseSnapshot per Glossy phase to the topology updater through
+ * a bounded queue. The reader does nothing but decoding and parsing,
+ * so it keeps up with the serial line no matter how long logging and
+ * updating the topology take. If the queue is full, the current
+ * snapshot is kept and extended by the next phase instead. When the
+ * serial input ends, the last snapshot tells the updater why.
+ * 
+ * @author Marco Zimmerling (zimmerling@tik.ee.eth.ch)
+ */
+public class SerialIngest implements Runnable {
+
+	// Controller logger
+	private static Logger logger = Logger.getLogger(SerialIngest.class.getName());
+
+	// Number of messages to be flushed from serial buffer on startup
+	private static final int SERIAL_FLUSH_MESSAGES = 5;
+
+	private final SerialDecoder decoder;
+	private final SpscQueue<PhaseSnapshot> queue;
+
+	// Snapshot of the current phase
+	private PhaseSnapshot snapshot;
+
+	// Last text line without non-printable characters, and the
+	// key=value token of it being parsed
+	private final byte[] text;
+	private int textLength;
+	private int tokenStart, tokenEquals, tokenEnd;
+
+	/**
+	 * Creates the serial reader.
+	 * 
+	 * @param in Output of the sink, either from serialdump or the serial port.
+	 * @param queue Queue to the topology updater.
+	 */
+	public SerialIngest(InputStream in, SpscQueue<PhaseSnapshot> queue) {
+		this.decoder = new SerialDecoder(in);
+		this.queue = queue;
+		this.snapshot = new PhaseSnapshot();
+		this.text = new byte[decoder.getLine().length];
+	}
+
+	public void run() {
+		int type;
+		try {
+			// Flushes out the first few messages in the serial buffer,
+			// this is to avoid using stale info
+			int flushMessages = SERIAL_FLUSH_MESSAGES;
+			while (flushMessages > 0 && decoder.next() != SerialDecoder.EOF) {
+				flushMessages--;
+			}
+
+			while ((type = decoder.next()) != SerialDecoder.EOF) {
+				try {
+					switch (type) {
+					case SerialDecoder.TEXT:
+						processLine(decoder.getLine(), decoder.getLineLength());
+						break;
+					case SerialDecoder.PACKET:
+						processPacket(decoder);
+						break;
+					case SerialDecoder.REPORT:
+						snapshot.addReport(processReport(decoder));
+						break;
+					case SerialDecoder.FINISHED:
+						phaseFinished();
+						break;
+					}
+				} catch (NumberFormatException e) {
+					logger.warn("Received corrupted data from the sink", e);
+				}
+			}
+			inputClosed("Serial input shut down (" + decoder.getCorruptFrames() + " corrupt frames)");
+		} catch (IOException e) {
+			logger.error("Reading serial input failed", e);
+			inputClosed("Reading serial input failed: " + e.getMessage());
+		}
+	}
+
+	/**
+	 * Hands the current snapshot over to the topology updater as the
+	 * last one, waiting for room in the queue if necessary.
+	 */
+	private void inputClosed(String reason) {
+		snapshot.inputClosed(reason);
+		while (!queue.offer(snapshot)) {
+			try {
+				Thread.sleep(10);
+			} catch (InterruptedException e) {
+				Thread.currentThread().interrupt();
+				return;
+			}
+		}
+	}
+
+	/**
+	 * Hands the snapshot over to the topology updater, or merges it with
+	 * the next phase if the updater has not yet caught up.
+	 */
+	private void phaseFinished() {
+		snapshot.phaseFinished();
+		if (queue.offer(snapshot)) {
+			snapshot = new PhaseSnapshot();
+		} else {
+			logger.warn("Topology updater is " + snapshot.getPhases() + " phases behind, merging phases");
+		}
+	}
+
+	/**
+	 * Parses a text line received from the sink. The line is parsed in
+	 * place, so that no strings are built.
+	 * 
+	 * @param line The text line.
+	 * @param length Length of the line.
+	 */
+	private void processLine(byte[] line, int length) {
+		// Remove all non-printable characters
+		textLength = 0;
+		for (int i = 0; i < length; i++) {
+			if (line[i] >= 0x20 && line[i] < 0x7f) {
+				text[textLength++] = line[i];
+			}
+		}
+		snapshot.addLine(text, textLength);
+		if (textLength == 0) {
+			return;
+		}
+		tokenEnd = 0;
+		if (text[0] == 'A') {
+			processPacketLine();
+		} else if (text[0] == 'G') {
+			snapshot.addReport(processMsg());
+		} else if (text[0] == 'F') {
+			phaseFinished();
+		}
+	}
+
+	/**
+	 * Moves to the next space-separated token of the text line.
+	 * 
+	 * @return False if there is none.
+	 */
+	private boolean nextToken() {
+		int i = tokenEnd;
+		while (i < textLength && text[i] == ' ') {
+			i++;
+		}
+		if (i == textLength) {
+			return false;
+		}
+		tokenStart = i;
+		tokenEquals = -1;
+		while (i < textLength && text[i] != ' ') {
+			if (text[i] == '=' && tokenEquals < 0) {
+				tokenEquals = i;
+			}
+			i++;
+		}
+		tokenEnd = i;
+		return true;
+	}
+
+	/**
+	 * Returns true if the current token is key=value.
+	 */
+	private boolean keyIs(String key) {
+		if (tokenEquals - tokenStart != key.length()) {
+			return false;
+		}
+		for (int i = 0; i < key.length(); i++) {
+			if (text[tokenStart + i] != key.charAt(i)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Parses the value of the current key=value token.
+	 */
+	private long value() {
+		int i = tokenEquals + 1;
+		boolean negative = i < tokenEnd && text[i] == '-';
+		if (negative) {
+			i++;
+		}
+		if (i == tokenEnd) {
+			throw new NumberFormatException("Missing value");
+		}
+		long value = 0;
+		for (; i < tokenEnd; i++) {
+			int digit = text[i] - '0';
+			if (digit < 0 || digit > 9) {
+				throw new NumberFormatException("Not a number");
+			}
+			value = 10 * value + digit;
+		}
+		return negative ? -value : value;
+	}
+
+	/**
+	 * Parses GLOSSY message received from the sink. 
+	 * 
+	 * @return NodeTopologyInfo object representing information about a single node.
+	 */
+	private NodeTopologyInfo processMsg() {
+		int nodeId = 0, parentId = 0, prr = 0, tl = 0, ts = 0, n = 0;
+		double pktRate = 0.0;
+		
+		// Examines the line
+		while (nextToken()) {
+			if (keyIs("o")) {
+				nodeId = (int) value();
+			} else if (keyIs("p")) {
+				parentId = (int) value();
+			} else if (keyIs("pr")) {
+				pktRate = 1.0 / (double) value();
+			} else if (keyIs("prr")) {
+				prr = (int) value();
+			} else if (keyIs("tl")) {
+				tl = (int) value();
+			} else if (keyIs("ts")) {
+				ts = (int) value();
+			} else if (keyIs("n")) {
+				n = (int) value();
+			}
+		}
+		
+		return new NodeTopologyInfo(nodeId, parentId, pktRate, prr, new MacConfiguration(tl, ts, n));
+	}
+
+	/**
+	 * Same as processMsg, but for a binary GLOSSY report. 
+	 * 
+	 * @param decoder The decoder holding the report.
+	 * @return NodeTopologyInfo object representing information about a single node.
+	 */
+	private static NodeTopologyInfo processReport(SerialDecoder decoder) {
+		double pktRate = 1.0 / (double) decoder.getReportPktRate();
+		MacConfiguration macConf = new MacConfiguration(decoder.getReportTl(), decoder.getReportTs(), decoder.getReportN());
+		return new NodeTopologyInfo(decoder.getReportNodeId(), decoder.getReportParentId(), pktRate, decoder.getReportPrr(), macConf);
+	}
+
+	/**
+	 * Adds the packet of a text A line to the snapshot.
+	 */
+	private void processPacketLine() {
+		int nodeId = 0, seqNo = 0;
+		int queuing_delay = 0, dropped_packets_count = 0, queue_size = 0;
+		long t_tx = 0, t_rx = 0, t_cpu = 0, t_lpm = 0;
+		long t_glossy_tx = 0, t_glossy_rx = 0, t_glossy_cpu = 0;
+		long latency = 0;
+		
+		while (nextToken()) {
+			if (keyIs("o")) {
+				nodeId = (int) value();
+			} else if (keyIs("seq")) {
+				seqNo = (int) value();
+			} else if (keyIs("qd")) {
+				queuing_delay = (int) value();
+			} else if (keyIs("dp")) {
+				dropped_packets_count = (int) value();
+			} else if (keyIs("qs")) {
+				queue_size = (int) value();
+			} else if (keyIs("tx")) {
+				t_tx = value();
+			} else if (keyIs("rx")) {
+				t_rx = value();
+			} else if (keyIs("cpu")) {
+				t_cpu = value();
+			} else if (keyIs("lpm")) {
+				t_lpm = value();
+			} else if (keyIs("lat")) {
+				latency = value();
+			} else if (keyIs("gtx")) {
+				t_glossy_tx = value();
+			} else if (keyIs("grx")) {
+				t_glossy_rx = value();
+			} else if (keyIs("gcpu")) {
+				t_glossy_cpu = value();
+			}
+		}
+		
+		snapshot.addPacket(nodeId, seqNo, queuing_delay, dropped_packets_count, queue_size,
+				t_tx, t_rx, t_cpu, t_lpm, t_glossy_tx, t_glossy_rx, t_glossy_cpu, latency);
+	}
+
+	/**
+	 * Same as processPacketLine, but for a binary PACKET frame.
+	 * 
+	 * @param d The decoder holding the packet.
+	 */
+	private void processPacket(SerialDecoder d) {
+		snapshot.addPacket(d.getPacketNodeId(), d.getPacketSeqNo(), d.getQueuingDelay(),
+				d.getDroppedPacketsCount(), d.getQueueSize(), d.getTimeTx(), d.getTimeRx(), d.getTimeCpu(),
+				d.getTimeLpm(), d.getGlossyTimeTx(), d.getGlossyTimeRx(), d.getGlossyTimeCpu(), d.getLatency());
+	}
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2013 ETH Zurich and SICS Swedish ICT 
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+package sics.adaptMac;
+
+import java.io.FileInputStream;
+import java.io.FileOutputStream;
+import java.io.FilterOutputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.OutputStream;
+
+import org.apache.log4j.Logger;
+
+/**
+ * Serial port the sink is connected to, opened directly instead of
+ * through serialdump. The port is configured like serialdump does
+ * (raw, 8N1, given baudrate) using stty, so this only works on Linux.
+ * Paths outside /dev (e.g., a file with recorded output) are read as
+ * they are, which allows to replay an experiment.
+ * 
+ * @author Marco Zimmerling (zimmerling@tik.ee.eth.ch)
+ */
+public class SerialPort {
+
+	// Controller logger
+	private static Logger logger = Logger.getLogger(SerialPort.class.getName());
+
+	// Delay (in milliseconds) after each byte written, as in serialdump
+	private static final long WRITE_DELAY = 6;
+
+	private final InputStream in;
+	private final OutputStream out;
+
+	/**
+	 * Configures and opens the serial port.
+	 * 
+	 * @param port Path of the serial port.
+	 * @param baudrate Baudrate.
+	 */
+	public SerialPort(String port, long baudrate) throws IOException {
+		if (port.startsWith("/dev/")) {
+			configure(port, baudrate);
+		} else {
+			logger.info(port + " is not a device, reading it without configuration");
+		}
+		this.in = new FileInputStream(port);
+		// Appending does not truncate a file standing in for the port
+		this.out = new PacedOutputStream(new FileOutputStream(port, true));
+	}
+
+	public InputStream getInputStream() {
+		return in;
+	}
+
+	public OutputStream getOutputStream() {
+		return out;
+	}
+
+	private static void configure(String port, long baudrate) throws IOException {
+		String[] cmd = { "stty", "-F", port, Long.toString(baudrate), "raw", "-echo",
+				"cs8", "-parenb", "-cstopb", "clocal", "cread" };
+		try {
+			int exitValue = Runtime.getRuntime().exec(cmd).waitFor();
+			if (exitValue != 0) {
+				throw new IOException("stty exited with " + exitValue + " for " + port);
+			}
+		} catch (InterruptedException e) {
+			throw new IOException("Interrupted while configuring " + port);
+		}
+	}
+
+	/**
+	 * Writes byte by byte and slowly, so that the sink does not miss any
+	 * input while it is busy.
+	 */
+	private static class PacedOutputStream extends FilterOutputStream {
+
+		PacedOutputStream(OutputStream out) {
+			super(out);
+		}
+
+		public void write(int b) throws IOException {
+			out.write(b);
+			out.flush();
+			try {
+				Thread.sleep(WRITE_DELAY);
+			} catch (InterruptedException e) {
+				throw new IOException("Interrupted while writing to serial port");
+			}
+		}
+	}
+}
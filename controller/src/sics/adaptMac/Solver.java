@@ -0,0 +1,63 @@
+/*
+ * Copyright 2013 ETH Zurich and SICS Swedish ICT 
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+package sics.adaptMac;
+
+import java.util.Collection;
+
+/**
+ * Interface of the components that evaluate and optimize the MAC
+ * protocol models on behalf of the triggers: the ECLiPSe driver and
+ * the native parallel optimizer.
+ * 
+ * @author Marco Zimmerling (zimmerling@tik.ee.eth.ch)
+ */
+public interface Solver {
+
+	/**
+	 * Estimates the network performance of the most recent topology
+	 * given the current MAC configuration.
+	 * 
+	 * @param topologies Topologies as prepared by the triggers.
+	 * @param macConf The current MAC configuration.
+	 * @return The estimated network performance, or null on failure.
+	 */
+	public NetworkPerformance performance(Collection<Object> topologies, MacConfiguration macConf);
+
+	/**
+	 * Determines the MAC configuration that maximizes network lifetime
+	 * subject to the end-to-end constraints.
+	 * 
+	 * @param topologies Topologies as prepared by the triggers.
+	 * @param reliabilityConstraint Minimum end-to-end reliability.
+	 * @param latencyConstraint Maximum end-to-end latency (in seconds).
+	 * @return The optimal MAC configuration, or null on failure.
+	 */
+	public MacConfiguration optimize(Collection<Object> topologies, double reliabilityConstraint, double latencyConstraint);
+}
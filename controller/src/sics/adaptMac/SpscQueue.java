@@ -0,0 +1,119 @@
+/*
+ * Copyright 2013 ETH Zurich and SICS Swedish ICT 
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+package sics.adaptMac;
+
+import java.util.concurrent.locks.LockSupport;
+
+/**
+ * Bounded lock-free queue for exactly one producer and one consumer
+ * thread. The producer never blocks: offer() fails if the queue is
+ * full. The consumer parks in take() until an element is available.
+ * 
+ * @author Marco Zimmerling (zimmerling@tik.ee.eth.ch)
+ */
+public class SpscQueue<T> {
+
+	private final Object[] buffer;
+	private final int mask;
+
+	// Index of the next element to take, only written by the consumer
+	private volatile long head;
+
+	// Index of the next element to offer, only written by the producer
+	private volatile long tail;
+
+	// Consumer thread, set while it waits in take()
+	private volatile Thread consumer;
+
+	/**
+	 * Creates a queue.
+	 * 
+	 * @param capacity Capacity, rounded up to the next power of two.
+	 */
+	public SpscQueue(int capacity) {
+		int size = 1;
+		while (size < capacity) {
+			size <<= 1;
+		}
+		this.buffer = new Object[size];
+		this.mask = size - 1;
+		this.head = 0;
+		this.tail = 0;
+	}
+
+	/**
+	 * Appends an element. Must only be called by the producer.
+	 * 
+	 * @return False if the queue is full.
+	 */
+	public boolean offer(T e) {
+		long t = tail;
+		if (t - head == buffer.length) {
+			return false;
+		}
+		buffer[(int) (t & mask)] = e;
+		// The volatile write publishes the element to the consumer
+		tail = t + 1;
+		Thread c = consumer;
+		if (c != null) {
+			LockSupport.unpark(c);
+		}
+		return true;
+	}
+
+	/**
+	 * Removes the oldest element, waiting until there is one. Must only
+	 * be called by the consumer.
+	 */
+	@SuppressWarnings("unchecked")
+	public T take() throws InterruptedException {
+		consumer = Thread.currentThread();
+		try {
+			while (true) {
+				long h = head;
+				if (h != tail) {
+					int i = (int) (h & mask);
+					T e = (T) buffer[i];
+					buffer[i] = null;
+					head = h + 1;
+					return e;
+				}
+				// An offer() between the check above and park() leaves
+				// a permit, so park() returns immediately
+				LockSupport.park();
+				if (Thread.interrupted()) {
+					throw new InterruptedException();
+				}
+			}
+		} finally {
+			consumer = null;
+		}
+	}
+}
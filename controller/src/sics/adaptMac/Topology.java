@@ -29,8 +29,13 @@
 
 package sics.adaptMac;
 
+import java.util.ArrayList;
 import java.util.Collection;
+import java.util.Collections;
+import java.util.HashMap;
 import java.util.HashSet;
+import java.util.LinkedList;
+import java.util.List;
 
 import org.apache.log4j.Logger;
 
@@ -38,6 +43,10 @@ import org.apache.log4j.Logger;
  * Representation of a complete tree-based routing topology
  * as captured by pTunes at a specific moment in time.
  * 
+ * Topologies in the history share the NodeTopologyInfo objects of
+ * the nodes that did not change (see NodeTrie), so node infos must
+ * never be modified once added; use update() instead.
+ * 
  * @author Marco Zimmerling (zimmerling@tik.ee.eth.ch)
  * @author Luca Mottola (luca.mottola@polimi.it)
  *
@@ -47,40 +56,42 @@ public class Topology {
 	// Controller logger
 	private static Logger logger = Logger.getLogger(Topology.class.getName());
 	
+	// Determines whether paths start from leaf nodes are from any node (besides the sink) in the tree 
+	private static final boolean FROM_LEAVES = false;
+	
 	private long currentTimestamp;
 	private long initialTimestamp;
-	private HashSet<NodeTopologyInfo> nodes;
+	// Replaced as a whole by update(); volatile so that getNodeInfo()
+	// can read the immutable trie without taking the lock
+	private volatile NodeTrie nodes;
+
+	// Derived from nodes on demand, reset by update()
+	private List<NodeTopologyInfo> nodeList;
+	private NodeTopologyInfo sink;
+	private HashMap<Integer, List<NodeTopologyInfo>> children;
+	private Boolean consistent;
+	private List<Object> export;
 
 	public Topology(NodeTopologyInfo sink, NodeTopologyInfo n) {
-		this.nodes = new HashSet<NodeTopologyInfo>();
-		nodes.add(sink);
-		nodes.add(n);
+		this.nodes = NodeTrie.EMPTY.put(sink).put(n);
 		setTimestamp();
 		initialTimestamp = this.getTimestamp();
 	}
 
 	public Topology(Topology t, NodeTopologyInfo n) {
-		this.nodes = new HashSet<NodeTopologyInfo>();
-
-		for (NodeTopologyInfo node : t.nodes) {
-			nodes.add((NodeTopologyInfo) node.clone());
-		}
-		// Removes the info on node n if any: id-based comparison
-		nodes.remove(n);
-		nodes.add(n); // Adds the new info
+		// Replaces the info on node n if any: id-based comparison
+		this.nodes = t.nodes.put(n);
 		setTimestamp();
 		initialTimestamp = this.getTimestamp();
 	}
 	
 	public Topology(Topology t, HashSet<NodeTopologyInfo> toPurge) {
-		this.nodes = new HashSet<NodeTopologyInfo>();
-
-		for (NodeTopologyInfo n : t.nodes) {
-			if (!toPurge.contains(n)) {
-				logger.debug("adding node id = " + n.getNodeId());
-				nodes.add((NodeTopologyInfo) n.clone());
-			}
+		NodeTrie remaining = t.nodes;
+		for (NodeTopologyInfo n : toPurge) {
+			logger.debug("removing node id = " + n.getNodeId());
+			remaining = remaining.remove(n.getNodeId());
 		}
+		this.nodes = remaining;
 		setTimestamp();
 		initialTimestamp = this.getTimestamp();
 	}
@@ -89,8 +100,16 @@ public class Topology {
 		return initialTimestamp;
 	}
 
-	public Collection<NodeTopologyInfo> getNodes() {
-		return nodes;
+	/**
+	 * Returns the nodes in ascending order of node id.
+	 */
+	public synchronized Collection<NodeTopologyInfo> getNodes() {
+		if (nodeList == null) {
+			List<NodeTopologyInfo> l = new ArrayList<NodeTopologyInfo>(nodes.size());
+			nodes.addTo(l);
+			nodeList = Collections.unmodifiableList(l);
+		}
+		return nodeList;
 	}
 
 	public long getTimestamp() {
@@ -101,26 +120,68 @@ public class Topology {
 		this.currentTimestamp = System.currentTimeMillis() / AdaptMac.TIME_SCALE_PACKET_RATE;
 	}
 
+	/**
+	 * Replaces the info on a node in this topology, without affecting
+	 * older topologies that share the previous info.
+	 * 
+	 * @param n The new info on the node.
+	 */
+	public synchronized void update(NodeTopologyInfo n) {
+		nodes = nodes.put(n);
+		nodeList = null;
+		sink = null;
+		children = null;
+		consistent = null;
+		export = null;
+	}
+
 	public NodeTopologyInfo getNodeInfo(int nodeId) {
-		for (NodeTopologyInfo n : nodes) {
-			if (nodeId == n.getNodeId()) {
-				return n;
+		return nodes.get(nodeId);
+	}
+
+	public synchronized NodeTopologyInfo getSink() {
+		if (sink == null) {
+			for (NodeTopologyInfo n : getNodes()) {
+				if (n.isSink()) {
+					sink = n;
+					break;
+				}
 			}
 		}
-		return null;
+		return sink;
 	}
 
-	public NodeTopologyInfo getSink() {
-		for (NodeTopologyInfo n : nodes) {
-			if (n.isSink()) {
-				return n;
+	/**
+	 * Returns the nodes whose parent is the given node, in ascending
+	 * order of node id.
+	 */
+	public synchronized List<NodeTopologyInfo> getChildren(int nodeId) {
+		if (children == null) {
+			children = new HashMap<Integer, List<NodeTopologyInfo>>();
+			for (NodeTopologyInfo n : getNodes()) {
+				if (!n.isSink()) {
+					List<NodeTopologyInfo> c = children.get(n.getParentId());
+					if (c == null) {
+						c = new ArrayList<NodeTopologyInfo>();
+						children.put(n.getParentId(), c);
+					}
+					c.add(n);
+				}
 			}
 		}
-		return null;
+		List<NodeTopologyInfo> c = children.get(nodeId);
+		return (c == null) ? Collections.<NodeTopologyInfo>emptyList() : Collections.unmodifiableList(c);
 	}
 	
-	public boolean isConsistent() {
-		for (NodeTopologyInfo n : nodes) {
+	public synchronized boolean isConsistent() {
+		if (consistent == null) {
+			consistent = Boolean.valueOf(checkConsistency());
+		}
+		return consistent.booleanValue();
+	}
+
+	private boolean checkConsistency() {
+		for (NodeTopologyInfo n : getNodes()) {
 			if (!n.isSink() && getNodeInfo(n.getParentId()) == null) {
 				// Node doesn't have a parent
 				logger.debug("Topology contains a node without a parent (node = " + n.getNodeId() + "), discarding");
@@ -128,25 +189,15 @@ public class Topology {
 			}
 		}
 
-/*		for (NodeTopologyInfo n : nodes) {
-			for (NodeTopologyInfo m : nodes) {
-				// Checking MAC params: if some are different; Trickle is not yet done
-				if (!n.isSink() && !m.isSink() && !(n.getMacConf().equals(m.getMacConf()))) {
-					logger.debug("Node " + n.getNodeId() + " and "
-							+ m.getNodeId() + " have diff MAC" + n.getMacConf()
-							+ " " + m.getMacConf());
-					return false;
-				}
-			}
-		}
-*/		
-		for (NodeTopologyInfo n : nodes) {
+		// Nodes whose path is known to end at the sink, so each node is walked over only once
+		HashSet<Integer> reachSink = new HashSet<Integer>();
+		for (NodeTopologyInfo n : getNodes()) {
 			if (!n.isSink()) {
 				NodeTopologyInfo currentNode = n;
 				HashSet<Integer> visitedNodes = new HashSet<Integer>();
 				visitedNodes.add(currentNode.getNodeId());
 				// Walk up the path in the tree as long as the current node's parent is not the sink and not the node from which we started
-				while (!getNodeInfo(currentNode.getParentId()).isSink()) {
+				while (!reachSink.contains(currentNode.getNodeId()) && !getNodeInfo(currentNode.getParentId()).isSink()) {
 					// If the parent of the current node is among the nodes we already visited, we detected a cycle.
 					if (visitedNodes.contains(currentNode.getParentId())) {
 						logger.debug("Topology contains a cycle starting at node " + currentNode.getParentId());
@@ -157,19 +208,121 @@ public class Topology {
 					currentNode = getNodeInfo(currentNode.getParentId());
 					visitedNodes.add(currentNode.getNodeId());
 				}
+				reachSink.addAll(visitedNodes);
 			}
 		}
 		
 		return true;
 	}
 	
+	/**
+	 * Returns the lists that describe this topology to the solvers, i.e.,
+	 * [NodeIds,PRRs,Fs,ParentList,ChildrenList,PathList] as expected by
+	 * createTopologies/2 in cp/adaptmac-e2e.ecl. The lists are built in
+	 * a single pass over the nodes and cached until the next update(),
+	 * so they must not be modified.
+	 */
+	public synchronized List<Object> export() {
+		if (export != null) {
+			return export;
+		}
+
+		LinkedList<Integer> nodeIds = new LinkedList<Integer>();
+		LinkedList<Double> prrs = new LinkedList<Double>();
+		LinkedList<Double> fs = new LinkedList<Double>();
+		LinkedList<LinkedList<Integer>> parentList = new LinkedList<LinkedList<Integer>>();
+		LinkedList<LinkedList<Integer>> childrenList = new LinkedList<LinkedList<Integer>>();
+		LinkedList<LinkedList<Integer>> pathList = new LinkedList<LinkedList<Integer>>();
+		// Path of each node to the sink, so every path is built from the one of the parent
+		HashMap<Integer, LinkedList<Integer>> paths = new HashMap<Integer, LinkedList<Integer>>();
+
+		for (NodeTopologyInfo n : getNodes()) {
+			nodeIds.add(n.getNodeId());
+			prrs.add(Math.sqrt((double) n.getPrr() / 1000.0));
+			fs.add(n.getPktRate());
+
+			LinkedList<Integer> parentOfN = new LinkedList<Integer>();
+			// Adds nothing if the node is the sink
+			if (!n.isSink()) {
+				parentOfN.add(n.getParentId());
+			}
+			parentList.add(parentOfN);
+
+			LinkedList<Integer> childrenOfN = new LinkedList<Integer>();
+			for (NodeTopologyInfo c : getChildren(n.getNodeId())) {
+				childrenOfN.add(c.getNodeId());
+			}
+			childrenList.add(childrenOfN);
+
+			if (!n.isSink() && (!FROM_LEAVES || childrenOfN.isEmpty())) {
+				pathList.add(pathToSink(n, paths));
+			}
+		}
+
+		logger.debug("TOPOLOGY: nodeIds:" + nodeIds);
+		logger.debug("TOPOLOGY: prrs:" + prrs);
+		logger.debug("TOPOLOGY: fs:" + fs);
+		logger.debug("TOPOLOGY: parentList:" + parentList);
+		logger.debug("TOPOLOGY: childrenList:" + childrenList);
+		logger.debug("TOPOLOGY: pathList:" + pathList);
+
+		export = new ArrayList<Object>(6);
+		export.add(nodeIds);
+		export.add(prrs);
+		export.add(fs);
+		export.add(parentList);
+		export.add(childrenList);
+		export.add(pathList);
+		export = Collections.unmodifiableList(export);
+		return export;
+	}
+
+	/**
+	 * Returns the path from node n to the sink, ending with the sink.
+	 * Only the part of the path that is not yet in paths is walked.
+	 * Requires a consistent topology.
+	 */
+	private LinkedList<Integer> pathToSink(NodeTopologyInfo n, HashMap<Integer, LinkedList<Integer>> paths) {
+		LinkedList<Integer> path = paths.get(n.getNodeId());
+		if (path != null) {
+			return path;
+		}
+
+		// Walk up until the sink or a node whose path is known
+		LinkedList<NodeTopologyInfo> walked = new LinkedList<NodeTopologyInfo>();
+		NodeTopologyInfo iterator = n;
+		LinkedList<Integer> known = null;
+		while (iterator.getNodeId() != getSink().getNodeId()) {
+			known = paths.get(iterator.getNodeId());
+			if (known != null) {
+				break;
+			}
+			walked.addFirst(iterator);
+			iterator = getNodeInfo(iterator.getParentId());
+		}
+		if (known == null) {
+			// The path ends with the sink
+			known = new LinkedList<Integer>();
+			known.add(getSink().getNodeId());
+		}
+
+		// Build the paths of the walked nodes, closest to the sink first
+		for (NodeTopologyInfo w : walked) {
+			LinkedList<Integer> p = new LinkedList<Integer>(known);
+			p.addFirst(w.getNodeId());
+			paths.put(w.getNodeId(), p);
+			known = p;
+		}
+		return known;
+	}
+	
 	public String toString() {
-		String s = new String();
-		s = s.concat("Topology @" + currentTimestamp + " since " + initialTimestamp + "\n");
-		for (NodeTopologyInfo n : nodes) {
-			s = s.concat(n.toString() + "\n");
+		StringBuffer s = new StringBuffer();
+		s.append("Topology @" + currentTimestamp + " since " + initialTimestamp + "\n");
+		for (NodeTopologyInfo n : getNodes()) {
+			s.append(n.toString() + "\n");
 		}
-		s = s.concat("\n");
-		return s;
+		s.append("\n");
+		return s.toString();
 	}
 }
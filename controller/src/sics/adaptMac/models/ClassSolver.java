@@ -0,0 +1,286 @@
+/*
+ * Copyright 2013 ETH Zurich and SICS Swedish ICT 
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+package sics.adaptMac.models;
+
+import java.util.ArrayList;
+import java.util.Collection;
+import java.util.LinkedList;
+
+import org.apache.log4j.Logger;
+
+import sics.adaptMac.MacConfiguration;
+import sics.adaptMac.NetworkPerformance;
+import sics.adaptMac.Solver;
+
+/**
+ * Solver that refines the MAC configuration of another solver into
+ * per-class MAC parameters. The other solver determines the best MAC
+ * parameters shared by all nodes. The relays of the most recent
+ * topology are then assigned to classes by their depth: the sink and
+ * the relays next to it, which carry the most traffic, to the highest
+ * class, relays further away to lower classes, and leaves to class 0.
+ * Starting from the shared parameters, the parameters of one class
+ * after the other are optimized over the whole (Tl, Ts, N) domain of
+ * the native MAC model, keeping the other classes fixed.
+ * 
+ * A change to a class is only accepted if it satisfies the queuing
+ * and end-to-end constraints on all topologies and does not decrease
+ * the network lifetime (the cost of cp/adaptmac-e2e.ecl); among those,
+ * the one that maximizes network lifetime and then the minimum
+ * lifetime of the nodes in the class wins. Hence, leaves can sleep
+ * longer than the relays they report to, and the result is never worse
+ * than the shared parameters.
+ * 
+ * @author Marco Zimmerling (zimmerling@tik.ee.eth.ch)
+ */
+public class ClassSolver implements Solver {
+
+	// Controller logger
+	private static Logger logger = Logger.getLogger(ClassSolver.class.getName());
+
+	// MAC protocol model
+	private final MacModel model;
+
+	// Solver for the MAC parameters shared by all nodes
+	private final Solver solver;
+
+	// Number of MAC classes, including class 0
+	private final int classes;
+
+	// Maximum number of nodes listed in classes 1, 2, ...
+	private final int maxMembers;
+
+	/**
+	 * Creates a class solver.
+	 * 
+	 * @param model The MAC protocol model.
+	 * @param solver Solver for the MAC parameters shared by all nodes.
+	 * @param classes Number of MAC classes, see GLOSSY_MAC_CLASSES.
+	 * @param maxMembers Maximum number of class members, see GLOSSY_MAC_CLASS_MEMBERS.
+	 */
+	public ClassSolver(MacModel model, Solver solver, int classes, int maxMembers) {
+		this.model = model;
+		this.solver = solver;
+		this.classes = classes;
+		this.maxMembers = maxMembers;
+
+		logger.info("Started ClassSolver with " + classes + " MAC classes");
+	}
+
+	public NetworkPerformance performance(Collection<Object> topologies, MacConfiguration macConf) {
+		if (macConf.getClasses() == null) {
+			return solver.performance(topologies, macConf);
+		}
+		// Only the native models know about MAC classes
+		return model.performance(topologies, macConf);
+	}
+
+	@SuppressWarnings("unchecked")
+	public synchronized MacConfiguration optimize(Collection<Object> topologies, double reliabilityConstraint, double latencyConstraint) {
+		MacConfiguration base = solver.optimize(topologies, reliabilityConstraint, latencyConstraint);
+		if (base == null || topologies.isEmpty() || classes < 2) {
+			return base;
+		}
+
+		ArrayList<ModelTopology> history = new ArrayList<ModelTopology>(topologies.size());
+		for (Object t : topologies) {
+			history.add(new ModelTopology((Collection<Object>) t));
+		}
+		ModelTopology recent = history.get(0);
+
+		// Start from the shared parameters in all classes
+		MacConfiguration conf = new MacConfiguration(base.getTl(), base.getTs(), base.getN());
+		MacConfiguration[] classConfs = new MacConfiguration[classes - 1];
+		for (int c = 0; c < classes - 1; c++) {
+			// Distinct objects, as nodes are matched to classes by identity
+			classConfs[c] = new MacConfiguration(base.getTl(), base.getTs(), base.getN());
+		}
+		conf.setClasses(classConfs, assignClasses(recent));
+		double lifetime = networkLifetime(recent, conf);
+		if (Double.isNaN(lifetime) || !constraintsHold(history, conf, reliabilityConstraint, latencyConstraint)) {
+			// The shared parameters are those optimized for reliability
+			return base;
+		}
+
+		logger.info("Computing MAC parameters of " + classes + " classes ...");
+		long start = System.nanoTime();
+		for (int c = 0; c < classes; c++) {
+			MacConfiguration best = (c == 0) ? base : classConfs[c - 1];
+			networkLifetime(recent, conf);
+			double bestClassLifetime = classLifetime(recent, conf, c);
+			for (int n = 0; n <= model.maxN(); n++) {
+				for (int ts = model.minTs(); ts <= model.maxTs(); ts++) {
+					for (int tl = model.minTl(ts); tl <= model.maxTl(ts); tl++) {
+						MacConfiguration candidate = new MacConfiguration(tl, ts, n);
+						setClass(conf, c, candidate);
+						double l = networkLifetime(recent, conf);
+						if (Double.isNaN(l) || l < lifetime) {
+							continue;
+						}
+						double cl = classLifetime(recent, conf, c);
+						if (l == lifetime && cl <= bestClassLifetime) {
+							continue;
+						}
+						if (constraintsHold(history, conf, reliabilityConstraint, latencyConstraint)) {
+							best = candidate;
+							lifetime = l;
+							bestClassLifetime = cl;
+						}
+					}
+				}
+			}
+			setClass(conf, c, best);
+		}
+		logger.info("MAC parameters of " + classes + " classes: " + conf + " (" + (System.nanoTime() - start) / 1000000 + " ms)");
+
+		return conf;
+	}
+
+	/**
+	 * Assigns the relays of the topology to classes by their depth and
+	 * returns the members of classes 1, 2, ...
+	 */
+	private int[][] assignClasses(ModelTopology t) {
+		ArrayList<LinkedList<Integer>> lists = new ArrayList<LinkedList<Integer>>(classes - 1);
+		for (int c = 0; c < classes - 1; c++) {
+			lists.add(new LinkedList<Integer>());
+		}
+		for (ModelNode n : t.getNodes()) {
+			if (!n.isSink() && n.children.isEmpty()) {
+				continue;
+			}
+			int depth = 0;
+			for (ModelNode p = n.parent; p != null && depth < classes; p = p.parent) {
+				depth++;
+			}
+			lists.get(Math.max(classes - 1 - Math.max(depth, 1), 0)).add(n.id);
+		}
+
+		// Classes next to the sink take precedence, the remaining nodes
+		// fall back to class 0
+		int[][] members = new int[classes - 1][];
+		int left = maxMembers;
+		for (int c = classes - 2; c >= 0; c--) {
+			int size = Math.min(lists.get(c).size(), left);
+			members[c] = new int[size];
+			for (int i = 0; i < size; i++) {
+				members[c][i] = lists.get(c).get(i);
+			}
+			left -= size;
+		}
+		return members;
+	}
+
+	private static void setClass(MacConfiguration conf, int c, MacConfiguration classConf) {
+		if (c == 0) {
+			conf.setTl(classConf.getTl());
+			conf.setTs(classConf.getTs());
+			conf.setN(classConf.getN());
+		} else {
+			conf.getClasses()[c - 1] = classConf;
+		}
+	}
+
+	/**
+	 * Cost of a configuration like in ParallelOptimizer: the minimum
+	 * lifetime of all relays in the topology.
+	 * 
+	 * @return The network lifetime, or NaN if the queuing constraint is
+	 * violated or a link lies outside the domain of the model.
+	 */
+	private double networkLifetime(ModelTopology t, MacConfiguration conf) {
+		if (!linksInDomain(t, conf)) {
+			return Double.NaN;
+		}
+		model.evaluate(t, conf);
+		double minT = Double.POSITIVE_INFINITY;
+		for (ModelNode node : t.getNodes()) {
+			if (node.isSink()) {
+				continue;
+			}
+			if (node.fqueuing > 0) {
+				return Double.NaN;
+			}
+			if (!node.children.isEmpty()) {
+				minT = Math.min(minT, node.nodeLifetime);
+			}
+		}
+		return minT;
+	}
+
+	/**
+	 * Minimum lifetime of the nodes in class c, as last evaluated by
+	 * networkLifetime.
+	 */
+	private double classLifetime(ModelTopology t, MacConfiguration conf, int c) {
+		MacConfiguration classConf = (c == 0) ? conf : conf.getClasses()[c - 1];
+		double minT = Double.POSITIVE_INFINITY;
+		for (ModelNode node : t.getNodes()) {
+			if (conf.forNode(node.id) == classConf) {
+				minT = Math.min(minT, node.nodeLifetime);
+			}
+		}
+		return minT;
+	}
+
+	private boolean linksInDomain(ModelTopology t, MacConfiguration conf) {
+		for (ModelNode node : t.getNodes()) {
+			if (!model.inDomain(model.linkConfiguration(node, conf))) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * End-to-end constraints on all topologies, see setupEndToEndConstraints/2.
+	 */
+	private boolean constraintsHold(ArrayList<ModelTopology> history, MacConfiguration conf,
+			double reliabilityConstraint, double latencyConstraint) {
+		for (ModelTopology t : history) {
+			if (t.getPaths().isEmpty()) {
+				continue;
+			}
+			if (!linksInDomain(t, conf)) {
+				return false;
+			}
+			model.evaluate(t, conf);
+			double avgR = MacModel.averageReliability(t);
+			if (!(avgR > reliabilityConstraint && avgR <= 1.0)) {
+				return false;
+			}
+			double avgL = MacModel.averageLatency(t);
+			if (!(avgL < latencyConstraint && avgL >= 0.0)) {
+				return false;
+			}
+		}
+		return true;
+	}
+}
@@ -0,0 +1,434 @@
+/*
+ * Copyright 2013 ETH Zurich and SICS Swedish ICT 
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+package sics.adaptMac.models;
+
+import java.io.BufferedOutputStream;
+import java.io.DataOutputStream;
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.nio.ByteBuffer;
+import java.nio.FloatBuffer;
+import java.nio.MappedByteBuffer;
+import java.nio.channels.FileChannel;
+import java.util.ArrayList;
+import java.util.Collection;
+import java.util.HashMap;
+import java.util.List;
+
+import org.apache.log4j.Logger;
+
+import sics.adaptMac.MacConfiguration;
+import sics.adaptMac.NetworkPerformance;
+import sics.adaptMac.Solver;
+
+/**
+ * Solver that answers optimize() from a precomputed table instead of
+ * evaluating the MAC model. For every configuration in the (Tl, Ts, N)
+ * domain and every PRR bucket, the table holds the terms of the model
+ * that only depend on a single link (see MacModel.tabulate). Packet
+ * rates enter the models linearly, so they need no buckets: the
+ * online path accumulates the rates bottom-up in the tree and combines
+ * them with the table rows of the links, and aggregates per-hop
+ * reliability and latency along the paths of the topology.
+ * 
+ * The table is memory-mapped from a file. If the file is missing or
+ * was built for a different model, it is rebuilt by a background
+ * thread; until then optimize() is delegated to the fallback solver.
+ * 
+ * Due to the PRR buckets, the result is an approximation of the
+ * optimum the fallback solver would return. Moreover, the table leaves
+ * out X-MAC bursts, whose share grows with the packet rate (see
+ * XmacModel.burstProbability), so AdaptMac refuses it for X-MAC.
+ * 
+ * @author Marco Zimmerling (zimmerling@tik.ee.eth.ch)
+ */
+public class LookupTable implements Solver {
+
+	// Controller logger
+	private static Logger logger = Logger.getLogger(LookupTable.class.getName());
+
+	// Table file format
+	private static final int MAGIC = 0x70544c54;
+	private static final int VERSION = 2;
+	private static final int HEADER_INTS = 11;
+
+	// PRR buckets: from MIN_PRR to 1.0 in steps of PRR_STEP; lower PRRs
+	// fall into the first bucket
+	private static final double MIN_PRR = 0.5;
+	private static final double PRR_STEP = 0.01;
+	private static final int PRR_BUCKETS = (int) Math.round((1.0 - MIN_PRR) / PRR_STEP) + 1;
+
+	// MAC protocol model
+	private final MacModel model;
+
+	// Solver used until the table is available
+	private final Solver fallback;
+
+	// Table, or null while it is being built
+	private volatile FloatBuffer table;
+
+	/**
+	 * Creates the lookup table solver and maps the table file, or starts
+	 * building it in the background if it is not usable.
+	 * 
+	 * @param model The MAC protocol model.
+	 * @param path Path of the table file.
+	 * @param fallback Solver used for estimation and until the table is built.
+	 */
+	public LookupTable(final MacModel model, final String path, final Solver fallback) {
+		this.model = model;
+		this.fallback = fallback;
+		this.table = map(path);
+		if (table == null) {
+			new Thread(new Runnable() {
+				public void run() {
+					long start = System.currentTimeMillis();
+					if (build(path)) {
+						table = map(path);
+						logger.info("Built lookup table " + path + " in " + (System.currentTimeMillis() - start) + " ms");
+					}
+				}
+			}, "lookup table builder").start();
+			logger.info("Building lookup table " + path + " in the background");
+		} else {
+			logger.info("Mapped lookup table " + path);
+		}
+	}
+
+	public NetworkPerformance performance(Collection<Object> topologies, MacConfiguration macConf) {
+		return fallback.performance(topologies, macConf);
+	}
+
+	@SuppressWarnings("unchecked")
+	public synchronized MacConfiguration optimize(Collection<Object> topologies, double reliabilityConstraint, double latencyConstraint) {
+		FloatBuffer tab = table;
+		if (tab == null) {
+			logger.info("Lookup table not yet available, using fallback solver");
+			return fallback.optimize(topologies, reliabilityConstraint, latencyConstraint);
+		}
+		if (topologies.isEmpty()) {
+			return null;
+		}
+
+		logger.info("Computing optimal MAC configuration from lookup table ...");
+		long start = System.nanoTime();
+		ArrayList<CompiledTopology> history = new ArrayList<CompiledTopology>(topologies.size());
+		for (Object t : topologies) {
+			history.add(new CompiledTopology(new ModelTopology((Collection<Object>) t)));
+		}
+		CompiledTopology recent = history.get(0);
+
+		// Same search order and tie-breaking as solve/2, see ParallelOptimizer
+		MacConfiguration optMacConf = null;
+		double optLifetime = Double.NEGATIVE_INFINITY;
+		for (int n = 0; n <= model.maxN(); n++) {
+			for (int ts = model.minTs(); ts <= model.maxTs(); ts++) {
+				for (int tl = model.minTl(ts); tl <= model.maxTl(ts); tl++) {
+					int base = model.index(tl, ts, n) * PRR_BUCKETS * MacModel.COLUMNS;
+					double lifetime = recent.networkLifetime(tab, base, tl, ts);
+					if (Double.isNaN(lifetime) || lifetime <= optLifetime) {
+						continue;
+					}
+					boolean holds = true;
+					for (int i = 0; i < history.size() && holds; i++) {
+						holds = history.get(i).endToEndConstraintsHold(tab, base, reliabilityConstraint, latencyConstraint);
+					}
+					if (holds) {
+						optMacConf = new MacConfiguration(tl, ts, n);
+						optLifetime = lifetime;
+					}
+				}
+			}
+		}
+
+		if (optMacConf == null) {
+			// End-to-end constraints are not satisfiable, so we return
+			// parameters that are optimized for reliability
+			logger.info("End-to-end constraints are not satisfiable");
+			return model.reliabilityConfiguration();
+		}
+		logger.info("Optimal MAC configuration: " + optMacConf + " (" + (System.nanoTime() - start) / 1000
+				+ " us from lookup table)");
+		return optMacConf;
+	}
+
+	/**
+	 * PRR bucket of a link.
+	 */
+	private static int bucket(double prr) {
+		int b = (int) Math.round((prr - MIN_PRR) / PRR_STEP);
+		return Math.max(0, Math.min(PRR_BUCKETS - 1, b));
+	}
+
+	/**
+	 * Header identifying the model, its constants, and the domain the
+	 * table was built for.
+	 */
+	private int[] header() {
+		return new int[] { MAGIC, VERSION, model.getName().hashCode(), ModelConstants.hash(), model.minTs(), model.maxTs(),
+				model.minTl(model.minTs()), model.tlSpan(), model.maxN(), PRR_BUCKETS, MacModel.COLUMNS };
+	}
+
+	/**
+	 * Maps the table file.
+	 * 
+	 * @return The table, or null if the file does not exist or does not match the model.
+	 */
+	private FloatBuffer map(String path) {
+		File file = new File(path);
+		if (!file.exists()) {
+			return null;
+		}
+		long size = 4L * HEADER_INTS + 4L * model.domainSize() * PRR_BUCKETS * MacModel.COLUMNS;
+		try {
+			RandomAccessFile raf = new RandomAccessFile(file, "r");
+			try {
+				if (raf.length() != size) {
+					logger.warn("Lookup table " + path + " has wrong size, rebuilding it");
+					return null;
+				}
+				MappedByteBuffer buffer = raf.getChannel().map(FileChannel.MapMode.READ_ONLY, 0, size);
+				int[] header = header();
+				for (int i = 0; i < HEADER_INTS; i++) {
+					if (buffer.getInt(4 * i) != header[i]) {
+						logger.warn("Lookup table " + path + " does not match the model, rebuilding it");
+						return null;
+					}
+				}
+				buffer.position(4 * HEADER_INTS);
+				ByteBuffer rows = buffer.slice();
+				return rows.asFloatBuffer();
+			} finally {
+				// The mapping stays valid after closing the file
+				raf.close();
+			}
+		} catch (IOException e) {
+			logger.error("Mapping lookup table " + path + " failed", e);
+			return null;
+		}
+	}
+
+	/**
+	 * Tabulates the model over the whole domain and all PRR buckets. The
+	 * table is written to a temporary file first, so a table file is
+	 * always complete.
+	 * 
+	 * @return True on success.
+	 */
+	private boolean build(String path) {
+		File tmp = new File(path + ".tmp");
+		try {
+			DataOutputStream out = new DataOutputStream(new BufferedOutputStream(new FileOutputStream(tmp), 1 << 16));
+			try {
+				for (int h : header()) {
+					out.writeInt(h);
+				}
+				// Rows in the order of MacModel.index
+				float[] row = new float[MacModel.COLUMNS];
+				for (int n = 0; n <= model.maxN(); n++) {
+					for (int ts = model.minTs(); ts <= model.maxTs(); ts++) {
+						for (int tl = model.minTl(ts); tl <= model.maxTl(ts); tl++) {
+							for (int b = 0; b < PRR_BUCKETS; b++) {
+								model.tabulate(MIN_PRR + b * PRR_STEP, tl, ts, n, row);
+								for (float v : row) {
+									out.writeFloat(v);
+								}
+							}
+						}
+					}
+				}
+			} finally {
+				out.close();
+			}
+		} catch (IOException e) {
+			logger.error("Building lookup table " + path + " failed", e);
+			tmp.delete();
+			return false;
+		}
+		File file = new File(path);
+		file.delete();
+		if (!tmp.renameTo(file)) {
+			logger.error("Renaming lookup table " + tmp + " to " + path + " failed");
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Topology compiled to arrays of node indices, so that a configuration
+	 * is evaluated with table lookups only.
+	 */
+	private class CompiledTopology {
+		// PRR bucket of the outgoing link of each node, -1 for the sink
+		private final int[] buckets;
+		// Packet generation rate of each node
+		private final double[] fs;
+		// Children indices of each node
+		private final int[][] children;
+		// Node indices such that children come before their parent
+		private final int[] postOrder;
+		// Buckets of the links of each path, the sink excluded
+		private final int[][] paths;
+
+		// Scratch space
+		private final double[] fout;
+		private int visited;
+
+		CompiledTopology(ModelTopology t) {
+			List<ModelNode> nodes = t.getNodes();
+			int size = nodes.size();
+			HashMap<ModelNode, Integer> index = new HashMap<ModelNode, Integer>();
+			for (int i = 0; i < size; i++) {
+				index.put(nodes.get(i), i);
+			}
+
+			this.buckets = new int[size];
+			this.fs = new double[size];
+			this.children = new int[size][];
+			for (int i = 0; i < size; i++) {
+				ModelNode n = nodes.get(i);
+				buckets[i] = n.isSink() ? -1 : bucket(n.prr);
+				fs[i] = n.f;
+				children[i] = new int[n.children.size()];
+				for (int c = 0; c < children[i].length; c++) {
+					children[i][c] = index.get(n.children.get(c));
+				}
+			}
+
+			this.postOrder = new int[size];
+			boolean[] done = new boolean[size];
+			this.visited = 0;
+			for (int i = 0; i < size; i++) {
+				visit(i, done);
+			}
+
+			this.paths = new int[t.getPaths().size()][];
+			int p = 0;
+			for (ModelNode[] path : t.getPaths()) {
+				int hops = 0;
+				for (ModelNode n : path) {
+					if (!n.isSink()) {
+						hops++;
+					}
+				}
+				paths[p] = new int[hops];
+				int h = 0;
+				for (ModelNode n : path) {
+					if (!n.isSink()) {
+						paths[p][h++] = bucket(n.prr);
+					}
+				}
+				p++;
+			}
+
+			this.fout = new double[size];
+		}
+
+		/**
+		 * Appends node i to the post-order after its subtree, in the same
+		 * way as packetsToSend/1 recurses.
+		 */
+		private void visit(int i, boolean[] done) {
+			if (done[i]) {
+				return;
+			}
+			done[i] = true;
+			for (int c : children[i]) {
+				visit(c, done);
+			}
+			postOrder[visited++] = i;
+		}
+
+		/**
+		 * Cost of a configuration like ParallelOptimizer, but from the
+		 * table rows starting at base.
+		 * 
+		 * @return The network lifetime, or NaN if the queuing constraint is violated.
+		 */
+		double networkLifetime(FloatBuffer tab, int base, int tl, int ts) {
+			double minT = Double.POSITIVE_INFINITY;
+			for (int i : postOrder) {
+				// Outgoing packet rate and reception terms from the children
+				double f = fs[i];
+				double inA = 0.0;
+				double inB = 0.0;
+				for (int c : children[i]) {
+					int row = base + buckets[c] * MacModel.COLUMNS;
+					f += tab.get(row + MacModel.COLUMN_R) * fout[c];
+					inA += tab.get(row + MacModel.COLUMN_IN_A) * fout[c];
+					inB += tab.get(row + MacModel.COLUMN_IN_B) * fout[c];
+				}
+				if (buckets[i] == -1) {
+					fout[i] = 0.0;
+					continue;
+				}
+				fout[i] = f;
+				int row = base + buckets[i] * MacModel.COLUMNS;
+				if (f > tab.get(row + MacModel.COLUMN_FFWD)) {
+					return Double.NaN;
+				}
+				if (children[i].length > 0) {
+					minT = Math.min(minT, model.tableLifetime(tab.get(row + MacModel.COLUMN_OUT_A),
+							tab.get(row + MacModel.COLUMN_OUT_B), inA, inB, f, tl, ts));
+				}
+			}
+			return minT;
+		}
+
+		/**
+		 * End-to-end constraints like ParallelOptimizer, but from the
+		 * table rows starting at base.
+		 */
+		boolean endToEndConstraintsHold(FloatBuffer tab, int base, double reliabilityConstraint, double latencyConstraint) {
+			if (paths.length == 0) {
+				return true;
+			}
+			double sumR = 0.0;
+			double sumL = 0.0;
+			for (int[] path : paths) {
+				double r = 1.0;
+				for (int b : path) {
+					int row = base + b * MacModel.COLUMNS;
+					r *= tab.get(row + MacModel.COLUMN_R);
+					sumL += tab.get(row + MacModel.COLUMN_L);
+				}
+				sumR += r;
+			}
+			double avgR = sumR / paths.length;
+			if (!(avgR > reliabilityConstraint && avgR <= 1.0)) {
+				return false;
+			}
+			double avgL = sumL / paths.length;
+			return avgL < latencyConstraint && avgL >= 0.0;
+		}
+	}
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright 2013 ETH Zurich and SICS Swedish ICT 
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+package sics.adaptMac.models;
+
+import static sics.adaptMac.models.ModelConstants.*;
+
+import sics.adaptMac.MacConfiguration;
+
+/**
+ * Native implementation of the LPP model in cp/lpp.ecl.
+ * 
+ * @author Marco Zimmerling (zimmerling@tik.ee.eth.ch)
+ */
+public class LppModel extends MacModel {
+
+	public int minTs() {
+		return 0;
+	}
+
+	public int maxTs() {
+		return (int) Math.round(0.5 / SCALE);
+	}
+
+	public int minTl(int ts) {
+		// Tl is fixed by Ts
+		return (int) Math.round((TON + 0.5 * TRANDMAX + TPR + TTURN) / SCALE) + ts;
+	}
+
+	public int maxTl(int ts) {
+		return minTl(ts);
+	}
+
+	public MacConfiguration reliabilityConfiguration() {
+		int ts = 60;
+		return new MacConfiguration((int) Math.round((TON + SCALE * ts + 0.5 * TRANDMAX + TPR + TTURN) / SCALE), ts, 10);
+	}
+
+	public String getName() {
+		return "LPP";
+	}
+
+	public int linkTl(MacConfiguration own, MacConfiguration parent) {
+		// The sender waits for a probe of the receiver for its own Tl
+		return own.getTl();
+	}
+
+	public void tabulate(double prr, int tl, int ts, int nrtx, float[] row) {
+		ModelNode n = new ModelNode(0, prr, 0.0);
+		n.parent = n;
+		perHopReliability(n, tl, ts, nrtx);
+		perHopLatency(n, tl, ts, nrtx);
+		double prr2 = n.prr * n.prr;
+		double prtx = 1.0 - n.ponestrobe * prr2;
+		double nrtxLink = expectedRetransmissions(prtx, nrtx);
+		// Sender of the link, see nodeLifetime/1 and queuingRate/1
+		double don = TON / (TON + SCALE * ts + 0.5 * TRANDMAX);
+		double ttxprx = n.ponestrobe * (n.toneprobe * (1.0 - don) + 4 * TTURN + prr2 * TDACK + (1.0 - prr2) * TDACKTIMEOUT)
+				+ (1.0 - n.ponestrobe) * ((SCALE * tl - 2 * TTURN) * (1.0 - don) + 2 * TTURN);
+		double ttx = (n.toneprobe + 4.0 * TTURN + TDATA + TDACK * prr2 + (TDACKTIMEOUT + n.tbackoff) * (1.0 - prr2)) * n.ponestrobe
+				+ (SCALE * tl + n.tbackoff) * (1.0 - n.ponestrobe);
+		row[COLUMN_R] = (float) n.perHopReliability;
+		row[COLUMN_L] = (float) n.perHopLatency;
+		// Receiver of the link: packets received per packet/s sent by the child
+		row[COLUMN_IN_A] = (float) ((nrtxLink + 1) * n.ponestrobe * n.prr);
+		row[COLUMN_IN_B] = 0.0f;
+		// The receive time of the sender scales with its own reception rate
+		row[COLUMN_OUT_A] = (float) ttxprx;
+		row[COLUMN_OUT_B] = (float) ((nrtxLink + 1) * n.ponestrobe * TDATA);
+		row[COLUMN_FFWD] = (float) (1.0 / ((nrtxLink + 1) * ttx));
+	}
+
+	public double tableLifetime(double outA, double outB, double inA, double inB, double fout, int tl, int ts) {
+		double frx = inA;
+		double fdc = 1.0 / (TON + SCALE * ts + 0.5 * TRANDMAX);
+		double trxdctx = TPR + TDACK * frx / fdc;
+		double trxdcrx = TON - trxdctx;
+		double dtx = fdc * trxdctx + fout * outB;
+		double drx = fdc * trxdcrx + frx * outA;
+		double didle = 1.0 - dtx - drx;
+		double ptotal = dtx * PTX + drx * PRX + didle * PS;
+		return Q * U / ptotal;
+	}
+
+	protected void perHopReliability(ModelNode n, int tl, int ts, int nrtx) {
+		if (n.isSink()) {
+			n.perHopReliability = 1.0;
+			return;
+		}
+		n.k = 1;
+		n.ponestrobe = 1.0 - Math.pow(1.0 - n.prr, n.k);
+		n.perHopReliability = 1.0 - Math.pow(1.0 - n.ponestrobe * n.prr, nrtx + 1);
+	}
+
+	protected void perHopLatency(ModelNode n, int tl, int ts, int nrtx) {
+		if (n.isSink()) {
+			n.perHopLatency = 0.0;
+			return;
+		}
+		// Number of failed transmission Nftx before successful transmission
+		double pf = 1.0 - n.ponestrobe * n.prr;
+		double nftx = expectedFailedTransmissions(pf, nrtx);
+		// Time needed for failed transmission Tftx
+		double ttxdata = 2 * TTURN + TDATA;
+		n.tbackoff = (TON + SCALE * ts) * 1.5;
+		n.toneprobe = TPR + 0.5 * (TON + SCALE * ts + 0.5 * TRANDMAX)
+				* (n.prr + n.k * n.k * (1.0 - n.prr)) / (n.prr + n.k * (1.0 - n.prr));
+		double tftx = (n.toneprobe + ttxdata + TDACKTIMEOUT) * n.ponestrobe + SCALE * tl * (1.0 - n.ponestrobe) + n.tbackoff;
+		// Time needed for successful transmission Tstx
+		double tstx = n.toneprobe + ttxdata;
+		// Per-hop latency L
+		n.perHopLatency = 0.5 * (TON + SCALE * ts) + nftx * tftx + tstx;
+	}
+
+	protected void nodeLifetime(ModelNode n, int tl, int ts, int nrtx) {
+		if (n.isSink()) {
+			n.nodeLifetime = Double.POSITIVE_INFINITY;
+			return;
+		}
+		// Duty-cycle and packet reception
+		double frx = 0.0;
+		for (ModelNode c : n.children) {
+			double prtxi = 1.0 - c.ponestrobe * c.prr * c.prr;
+			double nrtxi = expectedRetransmissions(prtxi, c.nrtx);
+			frx += (nrtxi + 1) * c.fout * c.ponestrobe * c.prr;
+		}
+		double fdc = 1.0 / (TON + SCALE * ts + 0.5 * TRANDMAX);
+		double trxdctx = TPR + TDACK * frx / fdc;
+		double trxdcrx = TON - trxdctx;
+		// Packet transmission
+		double prout2 = n.prr * n.prr;
+		double prtxout = 1.0 - n.ponestrobe * prout2;
+		double nrtxout = expectedRetransmissions(prtxout, nrtx);
+		double ftx = (nrtxout + 1) * n.fout;
+		double don = TON * fdc;
+		double ttxptx = n.ponestrobe * TDATA;
+		double ttxprx = n.ponestrobe * (n.toneprobe * (1.0 - don) + 4 * TTURN + prout2 * TDACK + (1.0 - prout2) * TDACKTIMEOUT)
+				+ (1.0 - n.ponestrobe) * ((SCALE * tl - 2 * TTURN) * (1.0 - don) + 2 * TTURN);
+		// Fractions of time in Tx, Rx, and idle mode
+		double dtx = fdc * trxdctx + ftx * ttxptx;
+		double drx = fdc * trxdcrx + frx * ttxprx;
+		double didle = 1.0 - dtx - drx;
+		// Total power draw
+		double ptotal = dtx * PTX + drx * PRX + didle * PS;
+		// Node lifetime T
+		n.nodeLifetime = Q * U / ptotal;
+	}
+
+	protected void queuingRate(ModelNode n, int tl, int ts, int nrtx) {
+		if (n.isSink()) {
+			n.fqueuing = Double.NEGATIVE_INFINITY;
+			return;
+		}
+		double prout2 = n.prr * n.prr;
+		double prtxout = 1.0 - n.ponestrobe * prout2;
+		double nrtxout = expectedRetransmissions(prtxout, nrtx);
+		double ttx = (n.toneprobe + 4.0 * TTURN + TDATA + TDACK * prout2 + (TDACKTIMEOUT + n.tbackoff) * (1.0 - prout2)) * n.ponestrobe
+				+ (SCALE * tl + n.tbackoff) * (1.0 - n.ponestrobe);
+		double fforwarding = 1.0 / ((nrtxout + 1) * ttx);
+		n.fqueuing = n.fout - fforwarding;
+	}
+}
@@ -0,0 +1,393 @@
+/*
+ * Copyright 2013 ETH Zurich and SICS Swedish ICT 
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+package sics.adaptMac.models;
+
+import java.util.Collection;
+import java.util.List;
+
+import sics.adaptMac.MacConfiguration;
+import sics.adaptMac.NetworkPerformance;
+
+/**
+ * Native (i.e., Java) implementation of the closed-form MAC protocol
+ * models in cp/xmac.ecl and cp/lpp.ecl. Evaluating the models for a
+ * fixed MAC configuration does not need a constraint solver, so the
+ * controller can estimate the network performance without a round
+ * trip to ECLiPSe. The ECLiPSe programs remain the reference; any
+ * change to the models must be applied to both.
+ * 
+ * @author Marco Zimmerling (zimmerling@tik.ee.eth.ch)
+ */
+public abstract class MacModel {
+
+	/**
+	 * Creates the model of the given MAC protocol.
+	 * 
+	 * @param macProtocol Either XMAC or LPP.
+	 * @return The model, or null if the MAC protocol is unknown.
+	 */
+	public static MacModel create(String macProtocol) {
+		if (macProtocol.equals("XMAC")) {
+			return new XmacModel();
+		} else if (macProtocol.equals("LPP")) {
+			return new LppModel();
+		}
+		return null;
+	}
+
+	/**
+	 * Lower bound of the domain of Ts, see createVariables/1.
+	 */
+	public abstract int minTs();
+
+	/**
+	 * Upper bound of the domain of Ts, see createVariables/1.
+	 */
+	public abstract int maxTs();
+
+	/**
+	 * Lower bound of the domain of Tl for a given Ts, see createVariables/1.
+	 */
+	public abstract int minTl(int ts);
+
+	/**
+	 * Upper bound of the domain of Tl for a given Ts, see createVariables/1.
+	 */
+	public abstract int maxTl(int ts);
+
+	/**
+	 * Upper bound of the domain of N, see createVariables/1.
+	 */
+	public int maxN() {
+		return 10;
+	}
+
+	/**
+	 * Number of values of Tl for any given Ts.
+	 */
+	public int tlSpan() {
+		return maxTl(minTs()) - minTl(minTs()) + 1;
+	}
+
+	/**
+	 * Number of configurations in the domain.
+	 */
+	public int domainSize() {
+		return (maxN() + 1) * (maxTs() - minTs() + 1) * tlSpan();
+	}
+
+	/**
+	 * Index of a configuration in the domain, from 0 to domainSize() - 1.
+	 */
+	public int index(int tl, int ts, int nrtx) {
+		return (nrtx * (maxTs() - minTs() + 1) + (ts - minTs())) * tlSpan() + (tl - minTl(ts));
+	}
+
+	/**
+	 * Returns true if the configuration lies within the domain.
+	 */
+	public boolean inDomain(MacConfiguration c) {
+		return c.getN() >= 0 && c.getN() <= maxN()
+			&& c.getTs() >= minTs() && c.getTs() <= maxTs()
+			&& c.getTl() >= minTl(c.getTs()) && c.getTl() <= maxTl(c.getTs());
+	}
+
+	/**
+	 * Protocol parameters geared toward reliability, used if the
+	 * end-to-end constraints are not satisfiable.
+	 */
+	public abstract MacConfiguration reliabilityConfiguration();
+
+	/**
+	 * Name of the MAC protocol, as used in the configuration file.
+	 */
+	public abstract String getName();
+
+	/**
+	 * Tl that governs the link from a node to its parent if the two
+	 * nodes use different MAC parameters. Ts of the link is always the
+	 * one of the parent, as the sender has to hit a wake-up of the
+	 * parent, and N is always the one of the sender.
+	 * 
+	 * @param own MAC parameters of the sender.
+	 * @param parent MAC parameters of the receiver.
+	 */
+	public abstract int linkTl(MacConfiguration own, MacConfiguration parent);
+
+	/**
+	 * MAC parameters that govern the outgoing link of node n, given the
+	 * MAC parameters of all nodes.
+	 */
+	protected MacConfiguration linkConfiguration(ModelNode n, MacConfiguration macConf) {
+		MacConfiguration own = macConf.forNode(n.id);
+		if (n.isSink()) {
+			return own;
+		}
+		MacConfiguration parent = macConf.forNode(n.parent.id);
+		if (parent == own) {
+			return own;
+		}
+		return new MacConfiguration(linkTl(own, parent), parent.getTs(), own.getN());
+	}
+
+	// Columns of a row of the lookup table, which holds the terms of the
+	// model that only depend on the configuration and the PRR of one link
+	public static final int COLUMN_R = 0;		// per-hop reliability
+	public static final int COLUMN_L = 1;		// per-hop latency
+	public static final int COLUMN_IN_A = 2;	// first term per packet/s received over the link
+	public static final int COLUMN_IN_B = 3;	// second term per packet/s received over the link
+	public static final int COLUMN_OUT_A = 4;	// first term of the sender of the link
+	public static final int COLUMN_OUT_B = 5;	// second term per packet/s sent over the link
+	public static final int COLUMN_FFWD = 6;	// maximum forwarding rate over the link
+	public static final int COLUMNS = 7;
+
+	/**
+	 * Computes the row of the lookup table for a link with the given PRR.
+	 */
+	public abstract void tabulate(double prr, int tl, int ts, int nrtx, float[] row);
+
+	/**
+	 * Computes the lifetime of a node from the lookup table.
+	 * 
+	 * @param outA COLUMN_OUT_A of the outgoing link of the node.
+	 * @param outB COLUMN_OUT_B of the outgoing link of the node.
+	 * @param inA Sum of COLUMN_IN_A times fout over the links from all children.
+	 * @param inB Sum of COLUMN_IN_B times fout over the links from all children.
+	 * @param fout Outgoing packet rate of the node.
+	 */
+	public abstract double tableLifetime(double outA, double outB, double inA, double inB, double fout, int tl, int ts);
+
+	/**
+	 * Creates per-hop reliability metric along the outgoing link of node n.
+	 */
+	protected abstract void perHopReliability(ModelNode n, int tl, int ts, int nrtx);
+
+	/**
+	 * Creates per-hop latency metric along the outgoing link of node n.
+	 * Requires perHopReliability and packetsToSend of node n.
+	 */
+	protected abstract void perHopLatency(ModelNode n, int tl, int ts, int nrtx);
+
+	/**
+	 * Creates node lifetime metric of node n. Requires perHopLatency of
+	 * node n, perHopReliability and packetsToSend of its children, and
+	 * packetsToSend of node n.
+	 */
+	protected abstract void nodeLifetime(ModelNode n, int tl, int ts, int nrtx);
+
+	/**
+	 * Creates queuing rate of node n. Requires perHopLatency and
+	 * packetsToSend of node n.
+	 */
+	protected abstract void queuingRate(ModelNode n, int tl, int ts, int nrtx);
+
+	/**
+	 * Determines network performance for the first (i.e., the most recent)
+	 * of the supplied topologies, like the performance predicate in
+	 * cp/adaptmac-e2e.ecl.
+	 * 
+	 * @param topologies Topologies as prepared for ECLiPSe.
+	 * @param macConf The MAC configuration.
+	 * @return The network performance, or null if there is no topology.
+	 */
+	@SuppressWarnings("unchecked")
+	public NetworkPerformance performance(Collection<Object> topologies, MacConfiguration macConf) {
+		if (topologies.isEmpty()) {
+			return null;
+		}
+		return performance(new ModelTopology((Collection<Object>) topologies.iterator().next()), macConf);
+	}
+
+	/**
+	 * Determines network performance for a given topology and MAC
+	 * configuration in terms of
+	 *  - network lifetime = min. node lifetime
+	 *  - average end-to-end reliability
+	 *  - average end-to-end latency
+	 *  - maximum queuing rate.
+	 * 
+	 * @param t The topology.
+	 * @param macConf The MAC configuration.
+	 * @return The network performance, or null if the topology has no paths.
+	 */
+	public NetworkPerformance performance(ModelTopology t, MacConfiguration macConf) {
+		if (t.getPaths().isEmpty()) {
+			return null;
+		}
+		evaluate(t, macConf);
+
+		double minT = Double.POSITIVE_INFINITY;
+		double maxQ = Double.NEGATIVE_INFINITY;
+		for (ModelNode n : t.getNodes()) {
+			minT = Math.min(minT, n.nodeLifetime);
+			maxQ = Math.max(maxQ, n.fqueuing);
+		}
+
+		return new NetworkPerformance(minT, averageReliability(t), averageLatency(t), maxQ);
+	}
+
+	/**
+	 * Computes all metrics of all nodes in the given topology, in the
+	 * order of their dependencies.
+	 */
+	protected void evaluate(ModelTopology t, int tl, int ts, int nrtx) {
+		List<ModelNode> nodes = t.getNodes();
+		for (ModelNode n : nodes) {
+			perHopReliability(n, tl, ts, nrtx);
+			n.nrtx = nrtx;
+			n.foutDone = false;
+		}
+		for (ModelNode n : nodes) {
+			packetsToSend(n);
+		}
+		for (ModelNode n : nodes) {
+			perHopLatency(n, tl, ts, nrtx);
+			queuingRate(n, tl, ts, nrtx);
+			nodeLifetime(n, tl, ts, nrtx);
+		}
+	}
+
+	/**
+	 * Computes all metrics of all nodes in the given topology if nodes
+	 * may use different MAC parameters: the per-hop metrics of a node
+	 * depend on the parameters of its outgoing link, its lifetime on
+	 * its own parameters.
+	 */
+	protected void evaluate(ModelTopology t, MacConfiguration macConf) {
+		List<ModelNode> nodes = t.getNodes();
+		MacConfiguration[] links = new MacConfiguration[nodes.size()];
+		int i = 0;
+		for (ModelNode n : nodes) {
+			MacConfiguration l = linkConfiguration(n, macConf);
+			perHopReliability(n, l.getTl(), l.getTs(), l.getN());
+			n.nrtx = l.getN();
+			n.foutDone = false;
+			links[i++] = l;
+		}
+		for (ModelNode n : nodes) {
+			packetsToSend(n);
+		}
+		i = 0;
+		for (ModelNode n : nodes) {
+			MacConfiguration l = links[i++];
+			perHopLatency(n, l.getTl(), l.getTs(), l.getN());
+			queuingRate(n, l.getTl(), l.getTs(), l.getN());
+			MacConfiguration own = macConf.forNode(n.id);
+			nodeLifetime(n, own.getTl(), own.getTs(), own.getN());
+		}
+	}
+
+	/**
+	 * Computes only the per-hop metrics of all nodes in the given
+	 * topology, which is all the end-to-end metrics depend on.
+	 */
+	protected void evaluateEndToEnd(ModelTopology t, int tl, int ts, int nrtx) {
+		List<ModelNode> nodes = t.getNodes();
+		for (ModelNode n : nodes) {
+			perHopReliability(n, tl, ts, nrtx);
+			n.foutDone = false;
+		}
+		for (ModelNode n : nodes) {
+			packetsToSend(n);
+		}
+		for (ModelNode n : nodes) {
+			perHopLatency(n, tl, ts, nrtx);
+		}
+	}
+
+	/**
+	 * Average end-to-end reliability over all paths in the topology,
+	 * where end-to-end reliability is the product of the per-hop
+	 * reliabilities along a path.
+	 */
+	protected static double averageReliability(ModelTopology t) {
+		double sum = 0.0;
+		for (ModelNode[] p : t.getPaths()) {
+			double r = 1.0;
+			for (ModelNode n : p) {
+				r *= n.perHopReliability;
+			}
+			sum += r;
+		}
+		return sum / t.getPaths().size();
+	}
+
+	/**
+	 * Average end-to-end latency over all paths in the topology, where
+	 * end-to-end latency is the sum of the per-hop latencies along a path.
+	 */
+	protected static double averageLatency(ModelTopology t) {
+		double sum = 0.0;
+		for (ModelNode[] p : t.getPaths()) {
+			for (ModelNode n : p) {
+				sum += n.perHopLatency;
+			}
+		}
+		return sum / t.getPaths().size();
+	}
+
+	/**
+	 * Creates outgoing packet rate metric of node n (and of all nodes
+	 * in its subtree), see packetsToSend/1 in cp/adaptmac-e2e.ecl.
+	 */
+	protected void packetsToSend(ModelNode n) {
+		if (n.foutDone) {
+			return;
+		}
+		if (n.isSink()) {
+			n.fout = 0.0;
+		} else {
+			// We forward packets received from our children and our own packets
+			double fout = n.f;
+			for (ModelNode c : n.children) {
+				packetsToSend(c);
+				fout += c.perHopReliability * c.fout;
+			}
+			n.fout = fout;
+		}
+		n.foutDone = true;
+	}
+
+	/**
+	 * Expected number of retransmissions given the probability p that
+	 * a single transmission fails and at most nrtx retransmissions.
+	 */
+	protected static double expectedRetransmissions(double p, int nrtx) {
+		return p * (1.0 - Math.pow(p, nrtx)) / (1.0 - p);
+	}
+
+	/**
+	 * Expected number of failed transmissions before the final successful
+	 * transmission given the failure probability pf of a single transmission.
+	 */
+	protected static double expectedFailedTransmissions(double pf, int nrtx) {
+		return pf / (1.0 - pf) - (nrtx + 1) * Math.pow(pf, nrtx + 1) / (1.0 - Math.pow(pf, nrtx + 1));
+	}
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2013 ETH Zurich and SICS Swedish ICT 
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+package sics.adaptMac.models;
+
+import java.lang.reflect.Field;
+import java.lang.reflect.Modifier;
+import java.util.Arrays;
+import java.util.Comparator;
+
+/**
+ * Constants used by the X-MAC and LPP models, mirroring
+ * declareConstants/1 in cp/constants.ecl. Keep both in sync.
+ * 
+ * @author Marco Zimmerling (zimmerling@tik.ee.eth.ch)
+ */
+public final class ModelConstants {
+
+	// Hardware-dependent constants (see Tmote Sky datasheet)
+	public static final double ITX = 17.4e-3;		// current at Tx [A]
+	public static final double IRX = 19.7e-3;		// current at Rx [A]
+	public static final double IS = 426e-6;			// current in idle mode [A]
+	public static final double U = 3;				// supply voltage [V]
+	public static final double PTX = U * ITX;		// power consumption at Tx [W]
+	public static final double PRX = U * IRX;		// power consumption at Rx [W]
+	public static final double PS = U * IS;			// power consumption in idle mode [W]
+	public static final double TTURN = 192e-6;		// Rx/Tx turnaround time [s]
+	public static final double Q = 7200;			// battery capacity [As]
+
+	// Implementation-dependent constants
+	public static final double TSL = 4.15e-3;		// duration sender acknowledgment listen [s]
+	public static final double TWAIT = 2.4414e-3;	// duration of sender waiting for data acknowledgment [s]
+	public static final double TTIMEOUT = 5.1269e-3;	// duration of receiver waiting for data packet [s]
+	public static final double SCALE = 1e-3;		// granularity of MAC parameters [s]
+	public static final double TSTR = 416e-6;		// duration of strobe transmission [s]
+	public static final double TACK = 416e-6;		// duration of ack transmission [s]
+	public static final double TDATA = 2.34e-3;		// duration of data transmission [s]
+	public static final double TITER = 2 * TTURN + TSTR + TSL;	// duration of strobe transmission and listen for strobe iteration [s]
+
+	// LPP-specific constants
+	public static final double TON = 7.8125e-3;		// duration of radio on-time [s]
+	public static final double TPR = 416e-6;		// duration of probe transmission [s]
+	public static final double TRANDMAX = 15.625e-3;	// maximum random off-time adjustment [s]
+	public static final double TDACKTIMEOUT = 4.16564941e-3;	// duration of sender waiting for data acknowledgment [s]
+	public static final double TDACK = 416e-6;		// duration of data acknowledgment transmission [s]
+
+	private ModelConstants() {
+	}
+
+	/**
+	 * Hash of the names and values of all constants above, which tells
+	 * whether precomputed model terms (see LookupTable) are still valid.
+	 */
+	public static int hash() {
+		Field[] fields = ModelConstants.class.getDeclaredFields();
+		// The order of getDeclaredFields is unspecified
+		Arrays.sort(fields, new Comparator<Field>() {
+			public int compare(Field a, Field b) {
+				return a.getName().compareTo(b.getName());
+			}
+		});
+		int hash = 1;
+		for (Field f : fields) {
+			if (f.getType() == double.class && Modifier.isStatic(f.getModifiers())) {
+				long bits;
+				try {
+					bits = Double.doubleToLongBits(f.getDouble(null));
+				} catch (IllegalAccessException e) {
+					throw new IllegalStateException(e);
+				}
+				hash = 31 * hash + f.getName().hashCode();
+				hash = 31 * hash + (int) (bits ^ (bits >>> 32));
+			}
+		}
+		return hash;
+	}
+}
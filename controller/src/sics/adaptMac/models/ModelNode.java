@@ -0,0 +1,108 @@
+/*
+ * Copyright 2013 ETH Zurich and SICS Swedish ICT 
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+package sics.adaptMac.models;
+
+import java.util.ArrayList;
+
+/**
+ * Node of a topology as seen by the native MAC models. Mirrors the
+ * node struct exported by cp/xmac.ecl and cp/lpp.ecl: it holds the
+ * inputs (PRR, packet generation rate, parent, children) as well as
+ * the metrics and intermediate terms computed by a model.
+ * 
+ * @author Marco Zimmerling (zimmerling@tik.ee.eth.ch)
+ */
+public class ModelNode {
+
+	// Inputs
+	final int id;
+	final double prr;
+	final double f;
+	ModelNode parent;
+	final ArrayList<ModelNode> children;
+
+	// Metrics
+	double fout;
+	double fqueuing;
+	double nodeLifetime;
+	double perHopLatency;
+	double perHopReliability;
+
+	// Intermediate terms shared between the metrics of a node
+	double k;
+	double ponestrobe;		// X-MAC: probability of one successful strobe, LPP: probability of one successful probe
+	double niter;			// X-MAC only
+	double tmax;			// X-MAC only
+	double psack;			// X-MAC only
+	double pburst;			// X-MAC only: fraction of transmissions sent in a burst
+	double toneprobe;		// LPP only
+	double tbackoff;
+	int nrtx;				// maximum number of retransmissions of the node
+	
+	// True once fout has been computed
+	boolean foutDone;
+
+	public ModelNode(int id, double prr, double f) {
+		this.id = id;
+		// To get node lifetime metric to work (see createTopologies/2)
+		this.prr = (prr == 1.0) ? 0.9999999 : prr;
+		this.f = f;
+		this.parent = null;
+		this.children = new ArrayList<ModelNode>();
+	}
+
+	public int getId() {
+		return id;
+	}
+
+	public boolean isSink() {
+		return parent == null;
+	}
+
+	public double getFout() {
+		return fout;
+	}
+
+	public double getFqueuing() {
+		return fqueuing;
+	}
+
+	public double getNodeLifetime() {
+		return nodeLifetime;
+	}
+
+	public double getPerHopLatency() {
+		return perHopLatency;
+	}
+
+	public double getPerHopReliability() {
+		return perHopReliability;
+	}
+}
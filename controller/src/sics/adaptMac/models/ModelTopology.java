@@ -0,0 +1,115 @@
+/*
+ * Copyright 2013 ETH Zurich and SICS Swedish ICT 
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+package sics.adaptMac.models;
+
+import java.util.ArrayList;
+import java.util.Collection;
+import java.util.HashMap;
+import java.util.Iterator;
+import java.util.List;
+
+/**
+ * Topology as seen by the native MAC models. It is created from the
+ * same seven lists that AbstractTrigger.prepareTopologies sends to
+ * ECLiPSe (duration, node ids, PRRs, Fs, parents, children, paths),
+ * exactly like createTopologies/2 in cp/adaptmac-e2e.ecl does.
+ * 
+ * @author Marco Zimmerling (zimmerling@tik.ee.eth.ch)
+ */
+public class ModelTopology {
+
+	private final long weight;
+	private final ArrayList<ModelNode> nodes;
+	private final ArrayList<ModelNode[]> paths;
+
+	/**
+	 * Creates a topology from the representation sent to ECLiPSe.
+	 * 
+	 * @param topologyInfo List of the form [Duration,NodeIds,PRRs,Fs,ParentList,ChildrenList,PathList].
+	 */
+	@SuppressWarnings("unchecked")
+	public ModelTopology(Collection<Object> topologyInfo) {
+		Iterator<Object> it = topologyInfo.iterator();
+		this.weight = ((Number) it.next()).longValue();
+		Collection<Integer> nodeIds = (Collection<Integer>) it.next();
+		Collection<Double> prrs = (Collection<Double>) it.next();
+		Collection<Double> fs = (Collection<Double>) it.next();
+		Collection<Collection<Integer>> parentList = (Collection<Collection<Integer>>) it.next();
+		Collection<Collection<Integer>> childrenList = (Collection<Collection<Integer>>) it.next();
+		Collection<Collection<Integer>> pathList = (Collection<Collection<Integer>>) it.next();
+
+		// Create the nodes with id, PRR, and packet generation rate
+		this.nodes = new ArrayList<ModelNode>(nodeIds.size());
+		HashMap<Integer, ModelNode> byId = new HashMap<Integer, ModelNode>();
+		Iterator<Double> prrIt = prrs.iterator();
+		Iterator<Double> fIt = fs.iterator();
+		for (Integer id : nodeIds) {
+			ModelNode n = new ModelNode(id.intValue(), prrIt.next().doubleValue(), fIt.next().doubleValue());
+			nodes.add(n);
+			byId.put(id, n);
+		}
+
+		// Set for each node its parent and children (if any)
+		Iterator<Collection<Integer>> childrenIt = childrenList.iterator();
+		Iterator<ModelNode> nodeIt = nodes.iterator();
+		for (Collection<Integer> parentOfN : parentList) {
+			ModelNode n = nodeIt.next();
+			for (Integer parentId : parentOfN) {
+				n.parent = byId.get(parentId);
+			}
+			for (Integer childId : childrenIt.next()) {
+				n.children.add(byId.get(childId));
+			}
+		}
+
+		// Construct paths to the sink
+		this.paths = new ArrayList<ModelNode[]>(pathList.size());
+		for (Collection<Integer> pathOfN : pathList) {
+			ModelNode[] path = new ModelNode[pathOfN.size()];
+			int i = 0;
+			for (Integer id : pathOfN) {
+				path[i++] = byId.get(id);
+			}
+			paths.add(path);
+		}
+	}
+
+	public long getWeight() {
+		return weight;
+	}
+
+	public List<ModelNode> getNodes() {
+		return nodes;
+	}
+
+	public List<ModelNode[]> getPaths() {
+		return paths;
+	}
+}
@@ -0,0 +1,408 @@
+/*
+ * Copyright 2013 ETH Zurich and SICS Swedish ICT 
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+package sics.adaptMac.models;
+
+import java.util.ArrayList;
+import java.util.Collection;
+import java.util.HashMap;
+import java.util.LinkedList;
+import java.util.List;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import java.util.concurrent.ThreadFactory;
+
+import org.apache.log4j.Logger;
+
+import sics.adaptMac.MacConfiguration;
+import sics.adaptMac.NetworkPerformance;
+import sics.adaptMac.Solver;
+
+/**
+ * Native replacement of the optimize predicate in cp/adaptmac-e2e.ecl.
+ * The (Tl, Ts, N) domain of createVariables/1 is partitioned across
+ * worker threads, each of which evaluates the native MAC model on its
+ * own copy of the topologies. The workers share the incumbent (i.e.,
+ * the best network lifetime found so far) and skip the end-to-end
+ * constraints of all topologies in the history whenever the cost
+ * alone already shows that a configuration cannot improve on it.
+ * 
+ * The search is exhaustive, so the result is the exact optimum and
+ * does not depend on the number of workers: ties are broken in the
+ * search order of solve/2, i.e., lexicographically on (N, Tl, Ts).
+ * 
+ * Re-optimizations are incremental: the previously returned MAC
+ * configuration is re-evaluated on the current topologies and, if it
+ * is still feasible, seeds the incumbent. Moreover, the outcome of the
+ * end-to-end constraints is remembered per topology and configuration,
+ * so after a small topology change only the new topology versions are
+ * evaluated, while the unchanged ones in the history are looked up.
+ * 
+ * @author Marco Zimmerling (zimmerling@tik.ee.eth.ch)
+ */
+public class ParallelOptimizer implements Solver {
+
+	// Controller logger
+	private static Logger logger = Logger.getLogger(ParallelOptimizer.class.getName());
+
+	// Statistics logger
+	private static Logger statsLogger = Logger.getLogger("stats");
+
+	// MAC protocol model
+	private final MacModel model;
+
+	// Number of worker threads
+	private final int threads;
+
+	// Worker threads
+	private final ExecutorService executor;
+
+	// True if the speedup per core count is still to be reported
+	private boolean reportSpeedup;
+
+	// Outcome of the end-to-end constraints per configuration, for each
+	// topology (without its weight) seen at the previous optimization
+	private HashMap<List<Object>, byte[]> constraintCache;
+
+	// End-to-end constraints the cache is valid for
+	private double cachedReliabilityConstraint;
+	private double cachedLatencyConstraint;
+
+	// Previously returned MAC configuration, used to warm-start the search
+	private MacConfiguration lastMacConf;
+
+	// Possible outcomes of the end-to-end constraints in the cache
+	private static final byte UNKNOWN = 0;
+	private static final byte SATISFIED = 1;
+	private static final byte VIOLATED = 2;
+
+	/**
+	 * Creates a parallel optimizer.
+	 * 
+	 * @param model The MAC protocol model.
+	 * @param threads Number of worker threads, or 0 to use all available cores.
+	 * @param reportSpeedup If true, reports the speedup per core count at the first optimization.
+	 */
+	public ParallelOptimizer(final MacModel model, final int threads, final boolean reportSpeedup) {
+		this.model = model;
+		this.threads = (threads > 0) ? threads : Runtime.getRuntime().availableProcessors();
+		this.reportSpeedup = reportSpeedup;
+		this.constraintCache = new HashMap<List<Object>, byte[]>();
+		this.lastMacConf = null;
+		this.executor = Executors.newFixedThreadPool(this.threads, new ThreadFactory() {
+			private int count = 0;
+
+			public synchronized Thread newThread(Runnable r) {
+				Thread t = new Thread(r, "optimizer worker " + count++);
+				t.setDaemon(true);
+				return t;
+			}
+		});
+
+		logger.info("Started ParallelOptimizer with " + this.threads + " worker threads");
+	}
+
+	public NetworkPerformance performance(Collection<Object> topologies, MacConfiguration macConf) {
+		return model.performance(topologies, macConf);
+	}
+
+	public synchronized MacConfiguration optimize(Collection<Object> topologies, double reliabilityConstraint, double latencyConstraint) {
+		if (reportSpeedup) {
+			reportSpeedup = false;
+			reportSpeedup(topologies, reliabilityConstraint, latencyConstraint);
+		}
+
+		logger.info("Computing optimal MAC configuration ...");
+		long start = System.nanoTime();
+		MacConfiguration optMacConf = optimize(topologies, reliabilityConstraint, latencyConstraint, threads, true);
+		if (optMacConf != null) {
+			lastMacConf = optMacConf;
+			logger.info("Optimal MAC configuration: " + optMacConf + " (" + (System.nanoTime() - start) / 1000000
+					+ " ms with " + threads + " workers)");
+		}
+
+		return optMacConf;
+	}
+
+	/**
+	 * Solves the optimization problem by partitioning the domain into
+	 * the given number of parts.
+	 * 
+	 * @param incremental If true, warm-starts from the previous result and uses the constraint cache.
+	 * @return The optimal MAC configuration, parameters optimized for
+	 * reliability if the constraints are not satisfiable, or null on failure.
+	 */
+	private MacConfiguration optimize(Collection<Object> topologies, double reliabilityConstraint, double latencyConstraint,
+			int workers, boolean incremental) {
+		if (topologies.isEmpty()) {
+			return null;
+		}
+
+		byte[][] constraints = lookupConstraints(topologies, reliabilityConstraint, latencyConstraint, incremental);
+		Incumbent incumbent = new Incumbent();
+		if (incremental && lastMacConf != null && model.inDomain(lastMacConf)) {
+			// Seed the incumbent with the previous result if it is still feasible
+			new Worker(0, 1, topologies, constraints, reliabilityConstraint, latencyConstraint, incumbent)
+				.search(lastMacConf.getTl(), lastMacConf.getTs(), lastMacConf.getN());
+			logger.debug("Warm start from " + lastMacConf + (incumbent.conf != null ? ", network lifetime " + incumbent.lifetime : ", infeasible"));
+		}
+
+		LinkedList<Future<?>> futures = new LinkedList<Future<?>>();
+		for (int w = 0; w < workers; w++) {
+			futures.add(executor.submit(new Worker(w, workers, topologies, constraints, reliabilityConstraint, latencyConstraint, incumbent)));
+		}
+		try {
+			for (Future<?> f : futures) {
+				f.get();
+			}
+		} catch (InterruptedException e) {
+			logger.error("Computing optimal MAC configuration failed", e);
+			return null;
+		} catch (ExecutionException e) {
+			logger.error("Computing optimal MAC configuration failed", e);
+			return null;
+		}
+
+		if (incumbent.conf == null) {
+			// End-to-end constraints are not satisfiable, so we return
+			// parameters that are optimized for reliability
+			logger.info("End-to-end constraints are not satisfiable");
+			return model.reliabilityConfiguration();
+		}
+		return incumbent.conf;
+	}
+
+	/**
+	 * Returns for each topology the array holding the outcome of the
+	 * end-to-end constraints per configuration. If incremental, arrays
+	 * of topologies seen at the previous optimization are reused, and
+	 * the cache is updated to hold only the current topologies.
+	 */
+	@SuppressWarnings("unchecked")
+	private byte[][] lookupConstraints(Collection<Object> topologies, double reliabilityConstraint, double latencyConstraint, boolean incremental) {
+		if (reliabilityConstraint != cachedReliabilityConstraint || latencyConstraint != cachedLatencyConstraint) {
+			constraintCache.clear();
+			cachedReliabilityConstraint = reliabilityConstraint;
+			cachedLatencyConstraint = latencyConstraint;
+		}
+
+		byte[][] constraints = new byte[topologies.size()][];
+		HashMap<List<Object>, byte[]> cache = new HashMap<List<Object>, byte[]>();
+		int i = 0;
+		int reused = 0;
+		for (Object t : topologies) {
+			// The weight does not affect the constraints, so it is not part of the key
+			List<Object> topologyInfo = new ArrayList<Object>((Collection<Object>) t);
+			List<Object> key = topologyInfo.subList(1, topologyInfo.size());
+			byte[] c = incremental ? constraintCache.get(key) : null;
+			if (c == null) {
+				c = new byte[model.domainSize()];
+			} else {
+				reused++;
+			}
+			cache.put(key, c);
+			constraints[i++] = c;
+		}
+		if (incremental) {
+			constraintCache = cache;
+			logger.debug("Reusing end-to-end constraints of " + reused + " out of " + topologies.size() + " topologies");
+		}
+
+		return constraints;
+	}
+
+	/**
+	 * Solves the given problem with 1, 2, 4, ... workers up to the number
+	 * of threads and reports wall-clock time and speedup to the statistics log.
+	 */
+	private void reportSpeedup(Collection<Object> topologies, double reliabilityConstraint, double latencyConstraint) {
+		LinkedList<Integer> coreCounts = new LinkedList<Integer>();
+		for (int workers = 1; workers < threads; workers *= 2) {
+			coreCounts.add(workers);
+		}
+		coreCounts.add(threads);
+
+		double base = 0.0;
+		for (int workers : coreCounts) {
+			long start = System.nanoTime();
+			optimize(topologies, reliabilityConstraint, latencyConstraint, workers, false);
+			double ms = (System.nanoTime() - start) / 1e6;
+			if (workers == 1) {
+				base = ms;
+			}
+			statsLogger.info("SPEEDUP " + workers + " " + ms + " " + (base / ms));
+		}
+	}
+
+	/**
+	 * Best solution found so far, shared between the workers.
+	 */
+	private static class Incumbent {
+		private volatile double lifetime = Double.NEGATIVE_INFINITY;
+		private MacConfiguration conf = null;
+
+		/**
+		 * Returns false if a configuration with the given network lifetime
+		 * cannot replace the incumbent.
+		 */
+		boolean mayImprove(double l) {
+			return l >= lifetime;
+		}
+
+		synchronized void offer(double l, int tl, int ts, int n) {
+			if (conf == null || l > lifetime || (l == lifetime && precedes(tl, ts, n))) {
+				conf = new MacConfiguration(tl, ts, n);
+				lifetime = l;
+			}
+		}
+
+		private boolean precedes(int tl, int ts, int n) {
+			if (n != conf.getN()) {
+				return n < conf.getN();
+			}
+			if (tl != conf.getTl()) {
+				return tl < conf.getTl();
+			}
+			return ts < conf.getTs();
+		}
+	}
+
+	/**
+	 * Searches the part of the domain with Ts = minTs + worker + k * workers.
+	 */
+	private class Worker implements Runnable {
+		private final int worker;
+		private final int workers;
+		private final byte[][] constraints;
+		private final double reliabilityConstraint;
+		private final double latencyConstraint;
+		private final Incumbent incumbent;
+		private final ArrayList<ModelTopology> history;
+		private final ModelTopology recent;
+
+		@SuppressWarnings("unchecked")
+		Worker(int worker, int workers, Collection<Object> topologies, byte[][] constraints,
+				double reliabilityConstraint, double latencyConstraint, Incumbent incumbent) {
+			this.worker = worker;
+			this.workers = workers;
+			this.constraints = constraints;
+			this.reliabilityConstraint = reliabilityConstraint;
+			this.latencyConstraint = latencyConstraint;
+			this.incumbent = incumbent;
+
+			// Each worker evaluates the model on its own copy of the topologies
+			this.history = new ArrayList<ModelTopology>(topologies.size());
+			for (Object t : topologies) {
+				history.add(new ModelTopology((Collection<Object>) t));
+			}
+			this.recent = history.get(0);
+		}
+
+		public void run() {
+			for (int n = 0; n <= model.maxN(); n++) {
+				for (int ts = model.minTs() + worker; ts <= model.maxTs(); ts += workers) {
+					for (int tl = model.minTl(ts); tl <= model.maxTl(ts); tl++) {
+						search(tl, ts, n);
+					}
+				}
+			}
+		}
+
+		/**
+		 * Offers a configuration to the incumbent if it satisfies all
+		 * constraints and may improve on the incumbent.
+		 */
+		void search(int tl, int ts, int n) {
+			double lifetime = networkLifetime(tl, ts, n);
+			if (Double.isNaN(lifetime) || !incumbent.mayImprove(lifetime)) {
+				return;
+			}
+			if (endToEndConstraintsHold(tl, ts, n)) {
+				incumbent.offer(lifetime, tl, ts, n);
+			}
+		}
+
+		/**
+		 * Cost of a configuration, see setupQueuingConstraint/1 and
+		 * createCost/2: the minimum lifetime of all nodes in the most
+		 * recent topology that have both a parent and children.
+		 * 
+		 * @return The network lifetime, or NaN if the queuing constraint is violated.
+		 */
+		private double networkLifetime(int tl, int ts, int n) {
+			model.evaluate(recent, tl, ts, n);
+			double minT = Double.POSITIVE_INFINITY;
+			for (ModelNode node : recent.getNodes()) {
+				if (node.isSink()) {
+					continue;
+				}
+				if (node.fqueuing > 0) {
+					return Double.NaN;
+				}
+				if (!node.children.isEmpty()) {
+					minT = Math.min(minT, node.nodeLifetime);
+				}
+			}
+			return minT;
+		}
+
+		/**
+		 * End-to-end constraints on all topologies, see setupEndToEndConstraints/2.
+		 * Each topology is only evaluated if the outcome is not yet known.
+		 * Workers never share a configuration, so they write disjoint entries.
+		 */
+		private boolean endToEndConstraintsHold(int tl, int ts, int n) {
+			int idx = model.index(tl, ts, n);
+			for (int i = 0; i < history.size(); i++) {
+				if (constraints[i][idx] == UNKNOWN) {
+					constraints[i][idx] = endToEndConstraintsHold(history.get(i), tl, ts, n) ? SATISFIED : VIOLATED;
+				}
+				if (constraints[i][idx] == VIOLATED) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		private boolean endToEndConstraintsHold(ModelTopology t, int tl, int ts, int n) {
+			if (t.getPaths().isEmpty()) {
+				return true;
+			}
+			model.evaluateEndToEnd(t, tl, ts, n);
+			double avgR = MacModel.averageReliability(t);
+			if (!(avgR > reliabilityConstraint && avgR <= 1.0)) {
+				return false;
+			}
+			double avgL = MacModel.averageLatency(t);
+			return avgL < latencyConstraint && avgL >= 0.0;
+		}
+	}
+}
@@ -0,0 +1,228 @@
+/*
+ * Copyright 2013 ETH Zurich and SICS Swedish ICT 
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+package sics.adaptMac.models;
+
+import static sics.adaptMac.models.ModelConstants.*;
+
+import sics.adaptMac.MacConfiguration;
+
+/**
+ * Native implementation of the X-MAC model in cp/xmac.ecl.
+ * 
+ * @author Marco Zimmerling (zimmerling@tik.ee.eth.ch)
+ */
+public class XmacModel extends MacModel {
+
+	public int minTs() {
+		return (int) Math.round(0.02 / SCALE);
+	}
+
+	public int maxTs() {
+		return (int) Math.round(0.5 / SCALE);
+	}
+
+	public int minTl(int ts) {
+		return (int) Math.ceil((2 * TSTR + 2 * TTURN + TSL) / SCALE);
+	}
+
+	public int maxTl(int ts) {
+		return (int) Math.ceil((3 * TITER + TSTR) / SCALE);
+	}
+
+	public MacConfiguration reliabilityConfiguration() {
+		return new MacConfiguration((int) Math.ceil((3 * TITER + TSTR) / SCALE), 20, 10);
+	}
+
+	public String getName() {
+		return "XMAC";
+	}
+
+	public int linkTl(MacConfiguration own, MacConfiguration parent) {
+		// The sender strobes for as long as the receiver sleeps
+		return parent.getTl();
+	}
+
+	public void tabulate(double prr, int tl, int ts, int nrtx, float[] row) {
+		// Without a packet rate there are no bursts (pburst = 0), which is
+		// why AdaptMac does not use the lookup table with X-MAC
+		ModelNode n = new ModelNode(0, prr, 0.0);
+		n.parent = n;
+		perHopReliability(n, tl, ts, nrtx);
+		perHopLatency(n, tl, ts, nrtx);
+		double prr2 = n.prr * n.prr;
+		double prtx = 1.0 - n.ponestrobe * prr2 * n.prr;
+		double nrtxLink = expectedRetransmissions(prtx, nrtx);
+		// Receiver of the link, see nodeLifetime/1
+		double trxr = 2 * TTURN + (TTURN + TDATA) * prr2 + TTIMEOUT * (1.0 - prr2);
+		double trxt = TACK + TACK * prr2;
+		double frx = (nrtxLink + 1) * n.ponestrobe;
+		// Sender of the link, see nodeLifetime/1 and queuingRate/1
+		double ttxr = (n.niter * (2 * TTURN + TSL) + 2 * TTURN + TACK * prr2 + TWAIT * (1.0 - prr2)) * n.psack
+				+ (n.tmax / TITER) * (2 * TTURN + TSL) * (1.0 - n.psack);
+		double ttxt = (n.niter * TSTR + TDATA) * n.psack + (n.tmax / TITER) * TSTR * (1.0 - n.psack);
+		double ttx = (n.niter * TITER + 2.0 * TTURN + TDATA + TACK * prr2 + (TWAIT + n.tbackoff) * (1.0 - prr2)) * n.psack
+				+ (n.tmax + n.tbackoff) * (1.0 - n.psack);
+		row[COLUMN_R] = (float) n.perHopReliability;
+		row[COLUMN_L] = (float) n.perHopLatency;
+		row[COLUMN_IN_A] = (float) (frx * trxr);
+		row[COLUMN_IN_B] = (float) (frx * trxt);
+		row[COLUMN_OUT_A] = (float) ((nrtxLink + 1) * ttxr);
+		row[COLUMN_OUT_B] = (float) ((nrtxLink + 1) * ttxt);
+		row[COLUMN_FFWD] = (float) (1.0 / ((nrtxLink + 1) * ttx));
+	}
+
+	public double tableLifetime(double outA, double outB, double inA, double inB, double fout, int tl, int ts) {
+		double drxc = inA + fout * outA;
+		double drx = drxc + (1.0 - drxc) * tl / (double) (tl + ts);
+		double dtx = inB + fout * outB;
+		double didle = 1.0 - dtx - drx;
+		double ptotal = dtx * PTX + drx * PRX + didle * PS;
+		return Q * U / ptotal;
+	}
+
+	protected void perHopReliability(ModelNode n, int tl, int ts, int nrtx) {
+		if (n.isSink()) {
+			n.perHopReliability = 1.0;
+			return;
+		}
+		n.k = (SCALE * tl - TSTR) / TITER;
+		n.ponestrobe = 1.0 - Math.pow(1.0 - n.prr, n.k);
+		n.perHopReliability = 1.0 - Math.pow(1.0 - n.ponestrobe * n.prr * n.prr, nrtx + 1);
+	}
+
+	protected void perHopLatency(ModelNode n, int tl, int ts, int nrtx) {
+		if (n.isSink()) {
+			n.perHopLatency = 0.0;
+			return;
+		}
+		// Number of failed transmission Nftx before final successful transmission
+		double pf = 1.0 - n.ponestrobe * n.prr * n.prr;
+		n.niter = (SCALE * (tl + ts)) / (2.0 * TITER);
+		double nftx = expectedFailedTransmissions(pf, nrtx);
+		// Time needed for failed transmission Tftx
+		double ttxdata = 2 * TTURN + TDATA;
+		n.psack = n.ponestrobe * n.prr;
+		n.tmax = SCALE * (2.0 * tl + ts);
+		n.tbackoff = SCALE * (tl + ts) * 1.5;
+		double tftx = (n.niter * TITER + ttxdata + TWAIT) * n.psack + n.tmax * (1.0 - n.psack) + n.tbackoff;
+		// Time needed for successful transmission Tstx, where a packet
+		// sent in a burst does not strobe
+		burstProbability(n, nrtx);
+		double tstx = (1.0 - n.pburst) * n.niter * TITER + ttxdata;
+		// Per-hop latency L; a packet sent in a burst does not wait for
+		// the random send delay either
+		n.perHopLatency = (1.0 - n.pburst) * 0.5 * (tl + ts) * SCALE + nftx * tftx + tstx;
+	}
+
+	/**
+	 * Time the sender needs for one transmission attempt if it strobes.
+	 */
+	private static double strobedTransmissionTime(ModelNode n) {
+		double prout2 = n.prr * n.prr;
+		return (n.niter * TITER + 2.0 * TTURN + TDATA + TACK * prout2 + (TWAIT + n.tbackoff) * (1.0 - prout2)) * n.psack
+				+ (n.tmax + n.tbackoff) * (1.0 - n.psack);
+	}
+
+	/**
+	 * Time the sender needs for one transmission attempt in a burst,
+	 * i.e., right after the previous packet while the receiver is awake.
+	 */
+	private static double burstTransmissionTime(ModelNode n) {
+		double prout2 = n.prr * n.prr;
+		return 2.0 * TTURN + TDATA + TACK * prout2 + (TWAIT + n.tbackoff) * (1.0 - prout2);
+	}
+
+	/**
+	 * Fraction of transmission attempts of node n sent in a burst. The
+	 * queue of the node is not empty after a transmission, and the next
+	 * packet hence follows in a burst, with probability equal to the
+	 * utilization of the node, which in turn depends on the share of
+	 * bursts. Requires packetsToSend of node n.
+	 */
+	private void burstProbability(ModelNode n, int nrtx) {
+		double prtxout = 1.0 - n.ponestrobe * n.prr * n.prr * n.prr;
+		double ftx = (expectedRetransmissions(prtxout, nrtx) + 1) * n.fout;
+		double ttxs = strobedTransmissionTime(n);
+		double ttxb = burstTransmissionTime(n);
+		n.pburst = Math.min(ftx * ttxs / (1.0 + ftx * (ttxs - ttxb)), 1.0);
+	}
+
+	protected void nodeLifetime(ModelNode n, int tl, int ts, int nrtx) {
+		if (n.isSink()) {
+			n.nodeLifetime = Double.POSITIVE_INFINITY;
+			return;
+		}
+		double drxc1 = 0.0;
+		double dtx1 = 0.0;
+		for (ModelNode c : n.children) {
+			double prin2 = c.prr * c.prr;
+			double prtxi = 1.0 - c.ponestrobe * prin2 * c.prr;
+			double nrtxi = expectedRetransmissions(prtxi, c.nrtx);
+			double frxi = (nrtxi + 1) * c.fout * c.ponestrobe;
+			double trxri = 2 * TTURN + (TTURN + TDATA) * prin2 + TTIMEOUT * (1.0 - prin2);
+			drxc1 += frxi * trxri;
+			double trxti = TACK + TACK * prin2;
+			dtx1 += frxi * trxti;
+		}
+		double prout2 = n.prr * n.prr;
+		// Fraction of time in receive mode
+		double prtxout = 1.0 - n.ponestrobe * prout2 * n.prr;
+		double nrtxout = expectedRetransmissions(prtxout, nrtx);
+		double ftx = (nrtxout + 1) * n.fout;
+		double ttxr = (n.niter * (2 * TTURN + TSL) + 2 * TTURN + TACK * prout2 + TWAIT * (1.0 - prout2)) * n.psack
+				+ (n.tmax / TITER) * (2 * TTURN + TSL) * (1.0 - n.psack);
+		ttxr = (1.0 - n.pburst) * ttxr + n.pburst * (2 * TTURN + TACK * prout2 + TWAIT * (1.0 - prout2));
+		double drxc = drxc1 + ftx * ttxr;
+		double drx = drxc + (1.0 - drxc) * tl / (double) (tl + ts);
+		// Fraction of time in transmit mode
+		double ttxt = (n.niter * TSTR + TDATA) * n.psack + (n.tmax / TITER) * TSTR * (1.0 - n.psack);
+		ttxt = (1.0 - n.pburst) * ttxt + n.pburst * TDATA;
+		double dtx = dtx1 + ftx * ttxt;
+		// Fraction of time in idle mode
+		double didle = 1.0 - dtx - drx;
+		// Total power draw
+		double ptotal = dtx * PTX + drx * PRX + didle * PS;
+		// Node lifetime T
+		n.nodeLifetime = Q * U / ptotal;
+	}
+
+	protected void queuingRate(ModelNode n, int tl, int ts, int nrtx) {
+		if (n.isSink()) {
+			n.fqueuing = Double.NEGATIVE_INFINITY;
+			return;
+		}
+		double prout2 = n.prr * n.prr;
+		double prtxout = 1.0 - n.ponestrobe * prout2 * n.prr;
+		double nrtxout = expectedRetransmissions(prtxout, nrtx);
+		double ttx = (1.0 - n.pburst) * strobedTransmissionTime(n) + n.pburst * burstTransmissionTime(n);
+		double fforwarding = 1.0 / ((nrtxout + 1) * ttx);
+		n.fqueuing = n.fout - fforwarding;
+	}
+}
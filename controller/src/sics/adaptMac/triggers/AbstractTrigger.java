@@ -49,9 +49,6 @@ public abstract class AbstractTrigger {
 	// Controller logger 
 	private static Logger logger = Logger.getLogger(AbstractTrigger.class.getName());
 	
-	// Determines whether paths start from leaf nodes are from any node (besides the sink) in the tree 
-	private static final boolean FROM_LEAVES = false;
-	
 	/**
 	 * Callback function. Signals triggers that Glossy has finished
 	 * the collection of network state information.
@@ -83,12 +80,7 @@ public abstract class AbstractTrigger {
 					if (currentTopology.isConsistent()) {
 						Collection<Object> topology = new LinkedList<Object>();
 						topology.add(currentTopology.getTimestamp() - currentTopology.getInitialTimestamp());
-						topology.add(buildNodeIds(currentTopology));
-						topology.add(buildPRRs(currentTopology));
-						topology.add(buildFs(currentTopology));
-						topology.add(buildParents(currentTopology));
-						topology.add(buildChildrenList(currentTopology));
-						topology.add(buildPathList(currentTopology));
+						topology.addAll(currentTopology.export());
 
 						topologies.add(topology);
 					}
@@ -100,12 +92,7 @@ public abstract class AbstractTrigger {
 								// Avoids examining topologies with incomplete info
 								Collection<Object> topology = new LinkedList<Object>();
 								topology.add(t.getTimestamp() - t.getInitialTimestamp());
-								topology.add(buildNodeIds(t));
-								topology.add(buildPRRs(t));
-								topology.add(buildFs(t));
-								topology.add(buildParents(t));
-								topology.add(buildChildrenList(t));
-								topology.add(buildPathList(t));
+								topology.addAll(t.export());
 
 								topologies.add(topology);
 							}
@@ -119,152 +106,6 @@ public abstract class AbstractTrigger {
 		return topologies;
 	}
 	
-	/**
-	 * Constructs collection of integers representing the node ids
-	 * in the supplied topology.
-	 * 
-	 * @param t The topology.
-	 * @return Collection of node ids.
-	 */
-	private Collection<Integer> buildNodeIds(Topology t) {
-		Collection<Integer> nodeIds = new LinkedList<Integer>();
-		for (NodeTopologyInfo n : t.getNodes()) {
-			nodeIds.add(n.getNodeId());
-		}
-		logger.debug("TRIGGER: nodeIds:" + nodeIds);
-
-		return nodeIds;
-	}
-	
-	/**
-	 * Constructs a collection of doubles representing the PRRs
-	 * in the supplied topology.
-	 * 
-	 * @param t The topology.
-	 * @return Collection of PRRs.
-	 */
-	private Collection<Double> buildPRRs(Topology t) {
-		Collection<Double> prrs = new LinkedList<Double>();
-		for (NodeTopologyInfo n : t.getNodes()) {
-			prrs.add(Math.sqrt((double) n.getPrr() / 1000.0));
-
-		}
-		logger.debug("TRIGGER: prrs:" + prrs);
-
-		return prrs;
-	}
-	
-	/**
-	 * Constructs a collection of doubles representing the 
-	 * packet generation rates in the supplied topology.
-	 * 
-	 * @param t The topology.
-	 * @return Collection of packet generation rates.
-	 */
-	private Collection<Double> buildFs(Topology t) {
-		Collection<Double> fs = new LinkedList<Double>();
-		for (NodeTopologyInfo n : t.getNodes()) {
-			fs.add(n.getPktRate());
-		}
-		logger.debug("TRIGGER: fs:" + fs);
-
-		return fs;
-	}
-
-	/**
-	 * Constructs for each node in the supplied topology a list of node ids
-	 * that contains the node's parent or is empty (sink). 
-	 * 
-	 * @param t The topology.
-	 * @return List of lists containing each node's parent.
-	 */
-	private LinkedList<LinkedList<Integer>> buildParents(Topology t) {
-		LinkedList<LinkedList<Integer>> parentList = new LinkedList<LinkedList<Integer>>();
-		for (NodeTopologyInfo n : t.getNodes()) {
-			LinkedList<Integer> parentOfN = new LinkedList<Integer>();
-			// Adds nothing if the node is the sink
-			if (n.getParentId() != n.getNodeId()) {
-				parentOfN.add(n.getParentId());
-			}
-			parentList.add(parentOfN);
-		}
-		logger.debug("TRIGGER: parentList:" + parentList);
-		
-		return parentList;
-	}
-	
-	/**
-	 * Constructs for each node in the supplied topology a list of node ids
-	 * that contains the node's children or is empty (leaf nodes).
-	 * 
-	 * @param t The topology.
-	 * @return List of lists containing each node's children.
-	 */
-	private LinkedList<LinkedList<Integer>> buildChildrenList(Topology t) {
-		LinkedList<LinkedList<Integer>> childrenList = new LinkedList<LinkedList<Integer>>();
-		for (NodeTopologyInfo n : t.getNodes()) {
-			LinkedList<Integer> childrenOfN = new LinkedList<Integer>();
-			for (NodeTopologyInfo m : t.getNodes()) {
-				if (!m.equals(n) && m.getParentId() == n.getNodeId()) {
-					childrenOfN.add(m.getNodeId());
-				}
-			}
-			childrenList.add(childrenOfN);
-		}
-		logger.debug("TRIGGER: childrenList:" + childrenList);
-
-		return childrenList;
-	}
-	
-	/**
-	 * Constructs for each node in the supplied topology a list of nodes ids
-	 * that represents the node's path to the sink or is empty (sink).
-	 * 
-	 * @param t The topology.
-	 * @return List of lists containing each node's path to the sink
-	 */
-	private LinkedList<LinkedList<Integer>> buildPathList(Topology t) {
-		LinkedList<LinkedList<Integer>> pathList = new LinkedList<LinkedList<Integer>>();
-		// Find the source nodes
-		LinkedList<NodeTopologyInfo> sources = new LinkedList<NodeTopologyInfo>();
-		if (FROM_LEAVES) {
-			for (NodeTopologyInfo n : t.getNodes()) {
-				boolean isLeaf = true;
-				for (NodeTopologyInfo m : t.getNodes()) {
-					if (m.getParentId() == n.getNodeId()) {
-						isLeaf = false;
-						break;
-					}
-				}
-				if (isLeaf) {
-					sources.add(n);
-				}
-			}
-		} else {
-			for (NodeTopologyInfo n : t.getNodes()) {
-				if (!n.isSink()) {
-					sources.add(n);
-				}
-			}
-		}
-
-		// Building paths from sources to sink
-		for (NodeTopologyInfo l : sources) {
-			LinkedList<Integer> path = new LinkedList<Integer>();
-			NodeTopologyInfo iterator = t.getNodeInfo(l.getNodeId());
-			while (iterator.getNodeId() != t.getSink().getNodeId()) {
-				path.add(iterator.getNodeId());
-				iterator = t.getNodeInfo(iterator.getParentId());
-			}
-			// The path ends with the sink
-			path.add(t.getSink().getNodeId());
-			pathList.add(path);
-		}
-		logger.debug("TRIGGER: pathList:" + pathList);
-
-		return pathList;
-	}
-	
 	/**
 	 * Determines the MAC configuration in the current topology.
 	 * 
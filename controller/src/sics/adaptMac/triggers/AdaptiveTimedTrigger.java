@@ -36,9 +36,9 @@ import java.util.LinkedList;
 
 import org.apache.log4j.Logger;
 
-import sics.adaptMac.EclipseDriver;
 import sics.adaptMac.MacConfiguration;
 import sics.adaptMac.NodeTopologyInfo;
+import sics.adaptMac.Solver;
 import sics.adaptMac.Topology;
 
 /**
@@ -76,8 +76,8 @@ public class AdaptiveTimedTrigger extends AbstractTrigger {
 	// Data rate threshold to detect traffic peaks
 	private static final double CHECK_DATA_RATE = 1.0/20.0;
 
-	// ECLiPSe driver
-	private final EclipseDriver driver;
+	// Solver, either the ECLiPSe driver or the native parallel optimizer
+	private final Solver driver;
 	
 	// History of topologies
 	private final LinkedList<Topology> topologyHistory;
@@ -101,7 +101,7 @@ public class AdaptiveTimedTrigger extends AbstractTrigger {
 	private final double reliabilityConstraint;
 	private final double latencyConstraint;
 	
-	public AdaptiveTimedTrigger(final EclipseDriver driver,
+	public AdaptiveTimedTrigger(final Solver driver,
 			final LinkedList<Topology> topologyHistory,
 			final int initialDelay,
 			final int retryPeriod,
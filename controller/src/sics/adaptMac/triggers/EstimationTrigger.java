@@ -29,19 +29,25 @@
 
 package sics.adaptMac.triggers;
 
+import java.util.Collection;
 import java.util.HashSet;
 import java.util.LinkedList;
 
 import org.apache.log4j.Logger;
 
 import sics.adaptMac.EclipseDriver;
+import sics.adaptMac.MacConfiguration;
 import sics.adaptMac.NetworkPerformance;
 import sics.adaptMac.NodeTopologyInfo;
 import sics.adaptMac.Topology;
+import sics.adaptMac.models.MacModel;
 
 /**
- * A trigger that uses ECLiPSe to compute an estimate of the current network performance
- * each time Glossy finished the collection of network state information. 
+ * A trigger that computes an estimate of the current network performance
+ * each time Glossy finished the collection of network state information.
+ * The estimate is computed either by ECLiPSe or, if a native model is
+ * supplied, directly in Java. In cross-check mode, both are computed and
+ * deviations are logged.
  * 
  * Used in almost all experiments to see how good/bad are the estimations.
  * 
@@ -55,9 +61,18 @@ public class EstimationTrigger extends AbstractTrigger {
 	// Statistics logger
 	private static Logger statsLogger = Logger.getLogger("stats");
 	
+	// Maximum relative deviation between native and ECLiPSe estimates in cross-check mode
+	private static final double CROSS_CHECK_TOLERANCE = 1e-3;
+	
 	// ECLiPSe driver
 	private final EclipseDriver driver;
 	
+	// Native MAC model, or null to estimate using ECLiPSe
+	private final MacModel model;
+	
+	// True if native estimates are checked against ECLiPSe
+	private final boolean crossCheck;
+	
 	// History of topologies
 	private final LinkedList<Topology> topologyHistory;
 	
@@ -69,16 +84,23 @@ public class EstimationTrigger extends AbstractTrigger {
 	 * 
 	 * @param driver The ECLiPSe driver.
 	 * @param topologyHistory History of topologies.
+	 * @param model Native MAC model, or null to estimate using ECLiPSe.
+	 * @param crossCheck If true, native estimates are checked against ECLiPSe.
 	 */
 	public EstimationTrigger(final EclipseDriver driver,
-			final LinkedList<Topology> topologyHistory) {
+			final LinkedList<Topology> topologyHistory,
+			final MacModel model,
+			final boolean crossCheck) {
 		this.driver = driver;
 		this.topologyHistory = topologyHistory;
+		this.model = model;
+		this.crossCheck = crossCheck && model != null;
 		this.waitNotify = new WaitNotify();
 
 		// Start the estimation trigger thread
 		startEstimationTrigger();
-		logger.info("Started EstimationTrigger");
+		logger.info("Started EstimationTrigger with " + (model == null ? "ECLiPSe" : "native") + " estimation"
+				+ (this.crossCheck ? " and cross-check" : ""));
 	}
 	
 	/**
@@ -91,8 +113,8 @@ public class EstimationTrigger extends AbstractTrigger {
 					// Wait until we get notified that Glossy finished
 					waitNotify.doWait();
 					
-					// Estimate current network performance using ECLiPSe
-					NetworkPerformance netPerf = driver.performance(prepareTopologies(topologyHistory, true), extractCurrentMacConfiguration(topologyHistory));
+					// Estimate current network performance
+					NetworkPerformance netPerf = estimate(prepareTopologies(topologyHistory, true), extractCurrentMacConfiguration(topologyHistory));
 					if (netPerf != null) {
 						statsLogger.info("ESTIMATE " + netPerf.getLifetime() + " " + netPerf.getReliability() + " " + netPerf.getLatency() + " " + netPerf.getMaxQueuingRate());
 					}
@@ -101,6 +123,45 @@ public class EstimationTrigger extends AbstractTrigger {
 		}, "estimation trigger").start();
 	}
 	
+	/**
+	 * Estimates the network performance either natively or using ECLiPSe.
+	 * 
+	 * @param topologies Topologies as prepared for ECLiPSe.
+	 * @param macConf The current MAC configuration.
+	 * @return The estimated network performance, or null on failure.
+	 */
+	private NetworkPerformance estimate(Collection<Object> topologies, MacConfiguration macConf) {
+		if (model == null) {
+			return driver.performance(topologies, macConf);
+		}
+		
+		long start = System.nanoTime();
+		NetworkPerformance netPerf = model.performance(topologies, macConf);
+		logger.info("Estimated network performance natively in " + (System.nanoTime() - start) / 1000 + " us: " + netPerf);
+		
+		if (crossCheck && netPerf != null) {
+			NetworkPerformance eclipsePerf = driver.performance(topologies, macConf);
+			if (eclipsePerf != null) {
+				checkDeviation("lifetime", netPerf.getLifetime(), eclipsePerf.getLifetime());
+				checkDeviation("reliability", netPerf.getReliability(), eclipsePerf.getReliability());
+				checkDeviation("latency", netPerf.getLatency(), eclipsePerf.getLatency());
+				checkDeviation("queuing rate", netPerf.getMaxQueuingRate(), eclipsePerf.getMaxQueuingRate());
+			}
+		}
+		
+		return netPerf;
+	}
+	
+	/**
+	 * Logs a warning if a native estimate deviates from the ECLiPSe estimate.
+	 */
+	private void checkDeviation(String figure, double nativeValue, double eclipseValue) {
+		double deviation = Math.abs(nativeValue - eclipseValue) / Math.max(Math.abs(eclipseValue), Double.MIN_VALUE);
+		if (deviation > CROSS_CHECK_TOLERANCE) {
+			logger.warn("Native " + figure + " estimate " + nativeValue + " deviates from ECLiPSe estimate " + eclipseValue);
+		}
+	}
+	
 	/**
 	 * Callback function. Signals that Glossy has finished the
 	 * collection of network state information. 
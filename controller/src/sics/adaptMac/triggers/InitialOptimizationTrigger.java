@@ -39,6 +39,7 @@ import org.apache.log4j.Logger;
 import sics.adaptMac.EclipseDriver;
 import sics.adaptMac.MacConfiguration;
 import sics.adaptMac.NodeTopologyInfo;
+import sics.adaptMac.Solver;
 import sics.adaptMac.Topology;
 
 /**
@@ -63,8 +64,8 @@ public class InitialOptimizationTrigger extends AbstractTrigger {
 	// Maximum number of optimization retries
 	private static final int MAX_RETRIES = 10;
 	
-	// ECLiPSe driver
-	private final EclipseDriver driver;
+	// Solver, either the ECLiPSe driver or the native parallel optimizer
+	private final Solver driver;
 	
 	// History of topologies
 	private final LinkedList<Topology> topologyHistory;
@@ -85,14 +86,14 @@ public class InitialOptimizationTrigger extends AbstractTrigger {
 	/**
 	 * Constructor to create an instance of this trigger.
 	 * 
-	 * @param driver The ECLiPSe driver.
+	 * @param driver The solver (ECLiPSe driver or native parallel optimizer).
 	 * @param topologyHistory History of topologies.
 	 * @param initialDelay Initial delay in minutes.
 	 * @param output Stream to output parameters to serialdump.
 	 * @param reliabilityConstraint End-to-end constraint on reliability.
 	 * @param latencyConstraint End-to-end constraint on latency.
 	 */
-	public InitialOptimizationTrigger(final EclipseDriver driver,
+	public InitialOptimizationTrigger(final Solver driver,
 			final LinkedList<Topology> topologyHistory,
 			final int initialDelay,
 			final BufferedWriter output,
@@ -40,6 +40,7 @@ import sics.adaptMac.EclipseDriver;
 import sics.adaptMac.MacConfiguration;
 import sics.adaptMac.NetworkPerformance;
 import sics.adaptMac.NodeTopologyInfo;
+import sics.adaptMac.Solver;
 import sics.adaptMac.Topology;
 
 /**
@@ -65,8 +66,8 @@ public class TimedPerformanceTrigger extends AbstractTrigger {
 	// Maximum allowed violation of reliability constraint
 	private static final double REL_TOLERANCE = 0.05;
 	
-	// ECLiPSe driver
-	private final EclipseDriver driver;
+	// Solver, either the ECLiPSe driver or the native parallel optimizer
+	private final Solver driver;
 	
 	// History of topologies
 	private final LinkedList<Topology> topologyHistory;
@@ -99,7 +100,7 @@ public class TimedPerformanceTrigger extends AbstractTrigger {
 	/**
 	 * Constructor to create an instance of this trigger.
 	 * 
-	 * @param driver The ECLiPSe driver.
+	 * @param driver The solver (ECLiPSe driver or native parallel optimizer).
 	 * @param topologyHistory History of topologies.
 	 * @param initialDelay Initial delay in minutes.
 	 * @param period Optimization period in number of Glossy phases.
@@ -108,7 +109,7 @@ public class TimedPerformanceTrigger extends AbstractTrigger {
 	 * @param reliabilityConstraint End-to-end constraint on reliability.
 	 * @param latencyConstraint End-to-end constraint on latency.
 	 */
-	public TimedPerformanceTrigger(final EclipseDriver driver,
+	public TimedPerformanceTrigger(final Solver driver,
 			final LinkedList<Topology> topologyHistory,
 			final int initialDelay,
 			final int period,